@@ -0,0 +1,576 @@
+// implot_util_bench: drives ImPlotEngine headless with synthetic workloads and prints one JSON object per
+// workload (JSON lines) with frame-time percentiles, GPU time, geometry per frame and memory use, then a
+// "csv_load" line with CsvLoader throughput and the frame times while it loads, a "capture" line with frame times
+// without and with a frame capture running, a "replay" line with the same dashboard live and replayed from a draw
+// data recording, an "overlap" line per frames-in-flight setting and latency mode with how much CPU and GPU work
+// overlapped, and one "startup" line with the engine's start-up timings and time to first frame.
+//
+// Runs on any Vulkan driver, including software ones, e.g.
+//   VK_DRIVER_FILES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./implot_util_bench --out bench_output.txt
+//
+// Without workload flags the built-in suite runs. Any of the flags below runs a single custom workload:
+//   --drawers N --series N --points N --subplots RxC --dashes N --churn N
+//   --dash-addline (dashes via one AddLine per dash, the pre-batching baseline) --dashed-series
+//   --pyramid (series through PyramidSeries instead of ImPlot::PlotLine)
+//   --density (series as a DensityPlot heatmap, re-binned every frame as while panning)
+// Common flags: --frames N --warmup N --width W --height H --out FILE
+//   --csv-rows N (rows of the generated CSV for the "csv_load" line, 0 skips it)
+//   --capture-frames N (frames rendered each without and with capture for the "capture" line, 0 skips it)
+//   --replay-frames N (frames recorded, then replayed, for the "replay" line, 0 skips it)
+//   --overlap-frames N (frames per setting for the "overlap" lines, 0 skips them)
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <imgui.h>
+#include <imgui_impl_vulkan.h>
+#include <implot.h>
+
+#include "csv_loader.h"
+#include "density_plot.h"
+#include "implot_engine.h"
+#include "implot_util.h"
+#include "pyramid_series.h"
+
+namespace {
+
+struct Workload {
+    std::string name{"custom"};
+    int drawers{1};
+    int series{1};
+    int points{1000};
+    int sub_rows{0};
+    int sub_cols{0};
+    int dashes{0};
+    int churn{0};  // drawers removed and re-added per frame
+    bool dash_addline{false};   // baseline dashes: one ImDrawList::AddLine per dash
+    bool dashed_series{false};  // series through PlotDashedLine instead of ImPlot::PlotLine
+    bool pyramid{false};        // series through PyramidSeries instead of ImPlot::PlotLine
+    bool density{false};        // series as DensityPlot heatmaps, re-binned every frame
+};
+
+struct Options {
+    uint32_t frames{300};
+    uint32_t warmup{30};
+    uint32_t width{1920};
+    uint32_t height{1080};
+    int csv_rows{2000000};
+    uint32_t capture_frames{120};
+    uint32_t replay_frames{120};
+    uint32_t overlap_frames{120};
+    std::string out;
+};
+
+struct SeriesData {
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::unique_ptr<PyramidSeries> pyramid;
+    std::unique_ptr<DensityPlot> density;
+};
+
+auto make_series(int count, int points, bool pyramid, bool density) -> std::vector<SeriesData> {
+    std::vector<SeriesData> out(count);
+    for (int s = 0; s < count; ++s) {
+        out[s].xs.resize(points);
+        out[s].ys.resize(points);
+        for (int i = 0; i < points; ++i) {
+            const double t = static_cast<double>(i) / std::max(points - 1, 1);
+            out[s].xs[i] = t;
+            out[s].ys[i] = std::sin(t * 40.0 + s) + 0.1 * std::sin(t * 977.0 * (s + 1));
+        }
+        if (pyramid) {
+            out[s].pyramid = std::make_unique<PyramidSeries>();
+            out[s].pyramid->append(out[s].xs.data(), out[s].ys.data(), out[s].xs.size());
+        }
+        if (density)
+            out[s].density = std::make_unique<DensityPlot>();
+    }
+    return out;
+}
+
+auto memory_kb(const char *field) -> long {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    const size_t len = std::strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, len, field) == 0)
+            return std::strtol(line.c_str() + len + 1, nullptr, 10);
+    }
+    return -1;
+}
+
+auto plot_series(const Workload &w, const std::vector<SeriesData> &data) -> void {
+    char label[32];
+    for (size_t s = 0; s < data.size(); ++s) {
+        std::snprintf(label, sizeof(label), "s%zu", s);
+        if (data[s].pyramid) {
+            data[s].pyramid->plot(label);
+        } else if (data[s].density) {
+            data[s].density->touch();
+            data[s].density->plot(label, data[s].xs.data(), data[s].ys.data(), data[s].xs.size());
+        } else if (w.dashed_series) {
+            PlotDashedLine(label, data[s].xs.data(), data[s].ys.data(), static_cast<int>(data[s].xs.size()));
+        } else {
+            ImPlot::PlotLine(label, data[s].xs.data(), data[s].ys.data(), static_cast<int>(data[s].xs.size()));
+        }
+    }
+}
+
+// Baseline for the dash workloads: every dash through ImDrawList::AddLine and the path machinery.
+auto add_dashed_line_per_dash(ImDrawList *draw_list, ImVec2 p1, ImVec2 p2, ImU32 color, float thickness) -> void {
+    const float dash_len = 6.0f, gap_len = 4.0f;
+    const ImVec2 delta(p2.x - p1.x, p2.y - p1.y);
+    const float len = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+    if (len <= 0.0f)
+        return;
+    const ImVec2 dir(delta.x / len, delta.y / len);
+    for (float dist = 0.0f; dist < len; dist += dash_len + gap_len) {
+        const float end = std::min(dist + dash_len, len);
+        draw_list->AddLine(ImVec2(p1.x + dir.x * dist, p1.y + dir.y * dist),
+                           ImVec2(p1.x + dir.x * end, p1.y + dir.y * end), color, thickness);
+    }
+}
+
+auto plot_dashes(const Workload &w) -> void {
+    const int dashes = w.dashes;
+    if (dashes <= 0)
+        return;
+    ImDrawList *draw_list = ImPlot::GetPlotDrawList();
+    const ImVec2 pos = ImPlot::GetPlotPos();
+    const ImVec2 size = ImPlot::GetPlotSize();
+    ImPlot::PushPlotClipRect();
+    for (int d = 0; d < dashes; ++d) {
+        const float y = pos.y + size.y * (static_cast<float>(d) + 0.5f) / static_cast<float>(dashes);
+        if (w.dash_addline)
+            add_dashed_line_per_dash(draw_list, ImVec2(pos.x, y), ImVec2(pos.x + size.x, y), IM_COL32(255, 255, 0, 160),
+                                     1.0f);
+        else
+            AddDashedLine(draw_list, ImVec2(pos.x, y), ImVec2(pos.x + size.x, y), IM_COL32(255, 255, 0, 160), 1.0f);
+    }
+    ImPlot::PopPlotClipRect();
+}
+
+auto make_drawer(const Workload &w, const std::vector<SeriesData> &data, int index, int columns, ImVec2 cell) {
+    return [&w, &data, index, columns, cell]() {
+        const char *fmt = w.sub_rows > 0 ? "sub%d" : "plot%d";
+        char title[32];
+        std::snprintf(title, sizeof(title), fmt, index);
+        ImGui::SetNextWindowPos(ImVec2(cell.x * (index % columns), cell.y * (index / columns)), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(cell, ImGuiCond_Always);
+        if (w.sub_rows > 0) {
+            if (!ImPlotBeginSub(title, std::nullopt, w.sub_rows, w.sub_cols))
+                return;
+            for (int c = 0; c < w.sub_rows * w.sub_cols; ++c) {
+                char cell_title[32];
+                std::snprintf(cell_title, sizeof(cell_title), "##c%d", c);
+                if (ImPlot::BeginPlot(cell_title)) {
+                    plot_series(w, data);
+                    plot_dashes(w);
+                    ImPlot::EndPlot();
+                }
+            }
+            ImPlotEndSub();
+        } else {
+            if (!ImPlotBegin(title))
+                return;
+            plot_series(w, data);
+            plot_dashes(w);
+            ImPlotEnd();
+        }
+    };
+}
+
+auto run(const Workload &w, const Options &opt, std::ostream &out) -> void {
+    auto &engine = ImPlotEngine::instance();
+    const auto data = make_series(w.series, w.points, w.pyramid, w.density);
+
+    const int total = w.drawers + w.churn;
+    const int columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(total)))));
+    const int rows = (total + columns - 1) / columns;
+    const ImVec2 cell(static_cast<float>(opt.width) / columns, static_cast<float>(opt.height) / rows);
+
+    for (int i = 0; i < w.drawers; ++i)
+        engine.draw("bench", make_drawer(w, data, i, columns, cell));
+
+    // Churn: every frame the oldest churn drawers are removed and replaced by new ones.
+    std::deque<uint32_t> churned;
+    int next_slot = 0;
+    if (w.churn > 0) {
+        engine.draw("churn", [&]() {
+            while (static_cast<int>(churned.size()) >= w.churn) {
+                engine.remove_drawer(churned.front());
+                churned.pop_front();
+            }
+            while (static_cast<int>(churned.size()) < w.churn) {
+                const int index = w.drawers + (next_slot++ % w.churn);
+                churned.push_back(engine.draw("churned", make_drawer(w, data, index, columns, cell)));
+            }
+        });
+    }
+
+    engine.set_profiling(false);
+    engine.render_headless(opt.warmup);
+    engine.set_profiling(true);
+    engine.render_headless(opt.frames);
+    engine.set_profiling(false);
+
+    const auto &profiler = engine.profiler();
+    const auto frame = profiler.frame_summary(opt.frames);
+    const auto drawers = profiler.phase_summary(FramePhase::Drawers, opt.frames);
+    const auto render = profiler.phase_summary(FramePhase::FrameRender, opt.frames);
+    const auto gpu = profiler.gpu_summary(opt.frames);
+    double vtx = 0.0, idx = 0.0, draw_calls = 0.0;
+    const auto records = profiler.latest(opt.frames);
+    for (const auto &r : records) {
+        vtx += r.vtx_count;
+        idx += r.idx_count;
+        draw_calls += r.draw_call_count;
+    }
+    if (!records.empty()) {
+        vtx /= static_cast<double>(records.size());
+        idx /= static_cast<double>(records.size());
+        draw_calls /= static_cast<double>(records.size());
+    }
+
+    out << "{\"name\":\"" << w.name << "\",\"drawers\":" << w.drawers << ",\"series\":" << w.series
+        << ",\"points\":" << w.points << ",\"subplots\":\"" << w.sub_rows << "x" << w.sub_cols
+        << "\",\"dashes\":" << w.dashes << ",\"dash_impl\":\"" << (w.dash_addline ? "addline" : "batched")
+        << "\",\"dashed_series\":" << (w.dashed_series ? "true" : "false")
+        << ",\"pyramid\":" << (w.pyramid ? "true" : "false") << ",\"density\":" << (w.density ? "true" : "false")
+        << ",\"churn\":" << w.churn << ",\"frames\":" << frame.samples
+        << ",\"frame_ms\":{\"mean\":" << frame.mean_ms << ",\"p50\":" << frame.p50_ms << ",\"p95\":" << frame.p95_ms
+        << ",\"p99\":" << frame.p99_ms << ",\"max\":" << frame.max_ms << "},\"drawers_ms_p50\":" << drawers.p50_ms
+        << ",\"frame_render_ms_p50\":" << render.p50_ms << ",\"gpu_ms\":{\"p50\":" << gpu.p50_ms
+        << ",\"p95\":" << gpu.p95_ms << "},\"vtx_per_frame\":" << vtx << ",\"idx_per_frame\":" << idx
+        << ",\"draw_calls_per_frame\":" << draw_calls << ",\"rss_kb\":" << memory_kb("VmRSS:")
+        << ",\"peak_rss_kb\":" << memory_kb("VmHWM:") << "}" << std::endl;
+
+    engine.remove_drawers();
+    // Let the churn drawer's captures go out of scope only after the engine dropped it.
+    engine.render_headless(1);
+}
+
+// Loads a generated CSV while the engine renders a plot of whatever has been published so far.
+auto run_csv(const Options &opt, std::ostream &out) -> void {
+    const auto path = std::filesystem::temp_directory_path() / "implot_util_bench.csv";
+    {
+        std::ofstream csv(path);
+        csv << "t,a,b,c\n";
+        char line[96];
+        for (int i = 0; i < opt.csv_rows; ++i) {
+            const double t = i * 1e-3;
+            const int n = std::snprintf(line, sizeof(line), "%.3f,%.6f,%.6f,%d\n", t, std::sin(t), std::cos(3.0 * t),
+                                        i % 1000);
+            csv.write(line, n);
+        }
+    }
+
+    auto &engine = ImPlotEngine::instance();
+    CsvLoader loader(path.string(), {}, engine.stop_token());
+    engine.draw("csv", [&loader, &opt]() {
+        ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImVec2(static_cast<float>(opt.width), static_cast<float>(opt.height)), ImGuiCond_Always);
+        if (!ImPlotBegin("csv"))
+            return;
+        const auto table = loader.table();
+        if (table->names().size() >= 2)
+            table->plot_line("a", 0, 1, ImPlotLineFlags_SkipNaN);
+        ImPlotEnd();
+    });
+
+    engine.set_profiling(true);
+    uint32_t frames = 0;
+    while (loader.state() == CsvLoadState::Loading) {
+        engine.render_headless(1);
+        ++frames;
+    }
+    engine.set_profiling(false);
+    const auto frame = engine.profiler().frame_summary(frames);
+    loader.wait();
+
+    out << "{\"name\":\"csv_load\",\"rows\":" << loader.table()->rows() << ",\"bytes\":" << loader.bytes_total()
+        << ",\"mb_s\":" << loader.throughput_mb_s() << ",\"frames_during_load\":" << frames
+        << ",\"frame_ms\":{\"p50\":" << frame.p50_ms << ",\"p95\":" << frame.p95_ms << ",\"max\":" << frame.max_ms
+        << "}}" << std::endl;
+
+    engine.remove_drawers();
+    engine.render_headless(1);
+    std::filesystem::remove(path);
+}
+
+// A small dashboard rendered without and then with a Y4M capture running, for what capturing costs the frame loop.
+auto run_capture(const Options &opt, std::ostream &out) -> void {
+    auto &engine = ImPlotEngine::instance();
+    const Workload w{.name = "capture", .drawers = 4, .series = 4, .points = 1000};
+    const auto data = make_series(w.series, w.points, false, false);
+    const ImVec2 cell(static_cast<float>(opt.width) / 2, static_cast<float>(opt.height) / 2);
+    for (int i = 0; i < w.drawers; ++i)
+        engine.draw("bench", make_drawer(w, data, i, 2, cell));
+
+    engine.render_headless(opt.warmup);
+    engine.set_profiling(true);
+    engine.render_headless(opt.capture_frames);
+    const auto plain = engine.profiler().frame_summary(opt.capture_frames);
+
+    const auto path = std::filesystem::temp_directory_path() / "implot_util_bench.y4m";
+    engine.start_capture(path.string());
+    engine.render_headless(opt.capture_frames);
+    const auto captured = engine.profiler().frame_summary(opt.capture_frames);
+    engine.set_profiling(false);
+    engine.stop_capture();
+    const FrameCaptureStats stats = engine.capture_stats();
+    const uint64_t attempts = stats.frames_captured + stats.frames_dropped + stats.frames_skipped;
+
+    const double record_ms_mean = attempts ? stats.record_ms / static_cast<double>(attempts) : 0.0;
+    const double encode_ms_mean =
+        stats.frames_written ? stats.encode_ms / static_cast<double>(stats.frames_written) : 0.0;
+    out << "{\"name\":\"capture\",\"frames\":" << opt.capture_frames << ",\"frame_ms_p50\":{\"off\":" << plain.p50_ms
+        << ",\"on\":" << captured.p50_ms << "},\"frame_ms_p95\":{\"off\":" << plain.p95_ms
+        << ",\"on\":" << captured.p95_ms << "},\"captured\":" << stats.frames_captured
+        << ",\"written\":" << stats.frames_written << ",\"dropped\":" << stats.frames_dropped
+        << ",\"record_ms_mean\":" << record_ms_mean << ",\"record_ms_max\":" << stats.record_ms_max
+        << ",\"encode_ms_mean\":" << encode_ms_mean << ",\"bytes\":" << stats.bytes_written << "}" << std::endl;
+
+    engine.remove_drawers();
+    engine.render_headless(1);
+    std::filesystem::remove(path);
+}
+
+// A dashboard rendered live while its draw data is recorded, then replayed from the recording: the frame time
+// left once the drawers are gone, and how much of FrameRender is the geometry itself.
+auto run_replay(const Options &opt, std::ostream &out) -> void {
+    auto &engine = ImPlotEngine::instance();
+    const Workload w{.name = "replay", .drawers = 4, .series = 4, .points = 100000};
+    const auto data = make_series(w.series, w.points, false, false);
+    const ImVec2 cell(static_cast<float>(opt.width) / 2, static_cast<float>(opt.height) / 2);
+    for (int i = 0; i < w.drawers; ++i)
+        engine.draw("bench", make_drawer(w, data, i, 2, cell));
+
+    engine.render_headless(opt.warmup);
+    const auto path = std::filesystem::temp_directory_path() / "implot_util_bench.ddr";
+    engine.set_profiling(true);
+    engine.start_draw_recording(path.string());
+    engine.render_headless(opt.replay_frames);
+    engine.stop_draw_recording();
+    const auto live = engine.profiler().frame_summary(opt.replay_frames);
+    const auto live_render = engine.profiler().phase_summary(FramePhase::FrameRender, opt.replay_frames);
+
+    auto replay = std::make_shared<DrawDataReplay>(path.string());
+    engine.set_replay(replay);
+    engine.render_headless(opt.replay_frames);
+    engine.set_replay(nullptr);
+    const auto replayed = engine.profiler().frame_summary(opt.replay_frames);
+    const auto replayed_render = engine.profiler().phase_summary(FramePhase::FrameRender, opt.replay_frames);
+    engine.set_profiling(false);
+
+    out << "{\"name\":\"replay\",\"frames\":" << replay->frame_count() << ",\"bytes\":"
+        << std::filesystem::file_size(path) << ",\"frame_ms_p50\":{\"live\":" << live.p50_ms
+        << ",\"replay\":" << replayed.p50_ms << "},\"frame_render_ms_p50\":{\"live\":" << live_render.p50_ms
+        << ",\"replay\":" << replayed_render.p50_ms << "},\"callbacks_skipped\":" << replay->callbacks_skipped()
+        << "}" << std::endl;
+
+    engine.remove_drawers();
+    engine.render_headless(1);
+    std::filesystem::remove(path);
+}
+
+// One dashboard under each frames-in-flight setting and latency mode: frame times, and how often the CPU built a
+// frame while the GPU still rendered an earlier one.
+auto run_overlap(const Options &opt, std::ostream &out) -> void {
+    auto &engine = ImPlotEngine::instance();
+    const Workload w{.name = "overlap", .drawers = 4, .series = 4, .points = 100000};
+    const auto data = make_series(w.series, w.points, false, false);
+    const ImVec2 cell(static_cast<float>(opt.width) / 2, static_cast<float>(opt.height) / 2);
+    for (int i = 0; i < w.drawers; ++i)
+        engine.draw("bench", make_drawer(w, data, i, 2, cell));
+
+    const uint32_t frames_in_flight = engine.frames_in_flight();
+    const FrameLatency latency = engine.frame_latency();
+    for (const FrameLatency mode : {FrameLatency::Throughput, FrameLatency::Low}) {
+        for (uint32_t f = 1; f <= 3; ++f) {
+            if (mode == FrameLatency::Low && f > 1)
+                break;  // Low waits for an idle GPU every frame, so more frames in flight change nothing
+            engine.set_frames_in_flight(f);
+            engine.set_frame_latency(mode);
+            engine.render_headless(opt.warmup);
+            engine.set_profiling(true);
+            engine.render_headless(opt.overlap_frames);
+            engine.set_profiling(false);
+            const auto frame = engine.profiler().frame_summary(opt.overlap_frames);
+            const auto gpu = engine.profiler().gpu_summary(opt.overlap_frames);
+            const auto overlap = engine.profiler().overlap_summary(opt.overlap_frames);
+            out << "{\"name\":\"overlap\",\"frames_in_flight\":" << f << ",\"latency\":\""
+                << (mode == FrameLatency::Low ? "low" : "throughput") << "\",\"frames\":" << frame.samples
+                << ",\"frame_ms\":{\"p50\":" << frame.p50_ms << ",\"p95\":" << frame.p95_ms
+                << "},\"gpu_ms_p50\":" << gpu.p50_ms << ",\"gpu_busy_at_begin\":" << overlap.busy_at_begin
+                << ",\"gpu_busy_at_render\":" << overlap.busy_at_render
+                << ",\"mean_in_flight\":" << overlap.mean_in_flight << ",\"cpu_wait_ms\":" << overlap.gpu_wait_ms
+                << "}" << std::endl;
+        }
+    }
+    engine.set_frames_in_flight(frames_in_flight);
+    engine.set_frame_latency(latency);
+
+    engine.remove_drawers();
+    engine.render_headless(1);
+}
+
+auto suite() -> std::vector<Workload> {
+    std::vector<Workload> s;
+    for (int d : {1, 16, 64})
+        s.push_back(Workload{.name = "drawers", .drawers = d, .series = 4, .points = 1000});
+    for (int n : {1, 16, 64})
+        s.push_back(Workload{.name = "series", .drawers = 4, .series = n, .points = 1000});
+    for (int p : {1000, 100000, 1000000})
+        s.push_back(Workload{.name = "points", .drawers = 1, .series = 1, .points = p});
+    for (int g : {2, 4})
+        s.push_back(Workload{.name = "subplots", .drawers = 4, .series = 2, .points = 1000, .sub_rows = g, .sub_cols = g});
+    for (int n : {100, 1000}) {
+        s.push_back(Workload{.name = "dashes", .drawers = 4, .series = 1, .points = 100, .dashes = n});
+        s.push_back(
+            Workload{.name = "dashes", .drawers = 4, .series = 1, .points = 100, .dashes = n, .dash_addline = true});
+    }
+    for (int p : {1000, 100000})
+        s.push_back(Workload{.name = "dashed_series", .drawers = 1, .series = 4, .points = p, .dashed_series = true});
+    for (int p : {1000000, 10000000})
+        s.push_back(Workload{.name = "pyramid", .drawers = 1, .series = 1, .points = p, .pyramid = true});
+    for (int p : {1000000, 10000000})
+        s.push_back(Workload{.name = "density", .drawers = 1, .series = 1, .points = p, .density = true});
+    for (int c : {4, 32})
+        s.push_back(Workload{.name = "churn", .drawers = 4, .series = 1, .points = 1000, .churn = c});
+    return s;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options opt;
+    Workload custom;
+    bool has_custom = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> const char * {
+            if (i + 1 >= argc) {
+                std::cerr << "missing value for " << arg << std::endl;
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--frames") {
+            opt.frames = static_cast<uint32_t>(std::atoi(next()));
+        } else if (arg == "--warmup") {
+            opt.warmup = static_cast<uint32_t>(std::atoi(next()));
+        } else if (arg == "--width") {
+            opt.width = static_cast<uint32_t>(std::atoi(next()));
+        } else if (arg == "--height") {
+            opt.height = static_cast<uint32_t>(std::atoi(next()));
+        } else if (arg == "--csv-rows") {
+            opt.csv_rows = std::atoi(next());
+        } else if (arg == "--capture-frames") {
+            opt.capture_frames = static_cast<uint32_t>(std::atoi(next()));
+        } else if (arg == "--replay-frames") {
+            opt.replay_frames = static_cast<uint32_t>(std::atoi(next()));
+        } else if (arg == "--overlap-frames") {
+            opt.overlap_frames = static_cast<uint32_t>(std::atoi(next()));
+        } else if (arg == "--out") {
+            opt.out = next();
+        } else if (arg == "--drawers") {
+            custom.drawers = std::atoi(next());
+            has_custom = true;
+        } else if (arg == "--series") {
+            custom.series = std::atoi(next());
+            has_custom = true;
+        } else if (arg == "--points") {
+            custom.points = std::atoi(next());
+            has_custom = true;
+        } else if (arg == "--subplots") {
+            if (std::sscanf(next(), "%dx%d", &custom.sub_rows, &custom.sub_cols) != 2) {
+                std::cerr << "--subplots expects RxC" << std::endl;
+                return 2;
+            }
+            has_custom = true;
+        } else if (arg == "--dashes") {
+            custom.dashes = std::atoi(next());
+            has_custom = true;
+        } else if (arg == "--churn") {
+            custom.churn = std::atoi(next());
+            has_custom = true;
+        } else if (arg == "--dash-addline") {
+            custom.dash_addline = true;
+            has_custom = true;
+        } else if (arg == "--dashed-series") {
+            custom.dashed_series = true;
+            has_custom = true;
+        } else if (arg == "--density") {
+            custom.density = true;
+            has_custom = true;
+        } else if (arg == "--pyramid") {
+            custom.pyramid = true;
+            has_custom = true;
+        } else {
+            std::cerr << "unknown argument " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    std::ofstream file;
+    if (!opt.out.empty()) {
+        file.open(opt.out);
+        if (!file) {
+            std::cerr << "cannot open " << opt.out << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = opt.out.empty() ? std::cout : file;
+
+    auto &engine = ImPlotEngine::instance();
+    engine.init_headless("implot_util_bench", opt.width, opt.height);
+
+    const auto workloads = has_custom ? std::vector<Workload>{custom} : suite();
+    for (const auto &w : workloads)
+        run(w, opt, out);
+    if (opt.csv_rows > 0)
+        run_csv(opt, out);
+    if (opt.capture_frames > 0)
+        run_capture(opt, out);
+    if (opt.replay_frames > 0)
+        run_replay(opt, out);
+    if (opt.overlap_frames > 0)
+        run_overlap(opt, out);
+
+    // Start-up last, once the first frame exists. Compare cold and warm pipeline cache runs with
+    // IMPLOT_UTIL_PIPELINE_CACHE pointing at a fresh or an existing file.
+    const EngineStartupStats &startup = engine.startup_stats();
+    const auto first_frame = engine.time_to_first_frame();
+    out << "{\"name\":\"startup\",\"init_ms\":" << startup.init_ms
+        << ",\"vk_instance_ms\":" << startup.vulkan.instance_ms << ",\"vk_device_ms\":" << startup.vulkan.device_ms
+        << ",\"pipeline_cache_load_ms\":" << startup.vulkan.pipeline_cache_load_ms
+        << ",\"pipeline_cache_bytes\":" << startup.vulkan.pipeline_cache_bytes
+        << ",\"pipeline_cache_hit\":" << (startup.vulkan.pipeline_cache_hit ? "true" : "false")
+        << ",\"imgui_vulkan_ms\":" << startup.imgui_vulkan_ms << ",\"first_frame_ms\":"
+        << (first_frame ? std::chrono::duration<double, std::milli>(*first_frame).count() : -1.0) << "}"
+        << std::endl;
+
+    const VulkanHostAllocStats host = engine.vulkan_host_memory();
+    out << "{\"name\":\"vulkan_host_memory\",\"live_bytes\":" << host.live_bytes
+        << ",\"live_count\":" << host.live_count << ",\"peak_bytes\":" << host.peak_bytes
+        << ",\"total_count\":" << host.total_count << ",\"pooled_bytes\":" << host.pooled_bytes
+        << ",\"command_scope_total\":" << host.scopes[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND].total_count << "}"
+        << std::endl;
+
+    engine.deinit();
+    return 0;
+}
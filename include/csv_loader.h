@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <implot.h>
+
+class ThreadPool;
+
+struct CsvOptions {
+    char delimiter = ',';
+    bool header = true;                  // first line holds column names; otherwise they are c0, c1, ...
+    size_t chunk_bytes = 4 << 20;        // parse granularity; chunks end on a line break
+    ThreadPool *pool = nullptr;          // nullptr = a pool shared by all loaders, separate from ThreadPool::shared()
+    // Called on the loader thread after each published chunk, e.g. to ImPlotEngine::invalidate().
+    std::function<void()> on_publish;
+};
+
+// Rows parsed from one chunk of the file, stored by column.
+struct CsvChunk {
+    size_t rows = 0;
+    std::vector<std::vector<double>> columns;
+};
+
+// Immutable view of everything published so far. Cheap to hold for a frame; later chunks go to a new table.
+class CsvTable {
+  public:
+    auto names() const -> const std::vector<std::string> & { return this->names_; }
+    auto rows() const -> size_t { return this->offsets_.empty() ? 0 : this->offsets_.back(); }
+    // Index of the column called `name`, or -1.
+    auto find(const std::string &name) const -> int;
+    auto chunks() const -> const std::vector<std::shared_ptr<const CsvChunk>> & { return this->chunks_; }
+    auto value(int column, size_t row) const -> double;
+
+    // Plots column `y` over column `x` for every published row. Must be called between ImPlot::BeginPlot / EndPlot.
+    auto plot_line(const char *label, int x, int y, ImPlotLineFlags flags = 0) const -> void;
+
+  private:
+    friend class CsvLoader;
+
+    struct Cursor {
+        const CsvTable *table;
+        int x, y;
+        size_t chunk;  // last chunk looked up; getters walk rows in order
+    };
+
+    static auto getter(int idx, void *data) -> ImPlotPoint;
+    auto chunk_of(size_t row, size_t hint) const -> size_t;
+
+    std::vector<std::string> names_;
+    std::vector<std::shared_ptr<const CsvChunk>> chunks_;
+    std::vector<size_t> offsets_;  // offsets_[i] = rows before chunk i + 1
+};
+
+enum class CsvLoadState : uint8_t { Loading, Done, Cancelled, Failed };
+
+// Loads a CSV file of numbers in the background. The file is memory-mapped and cut into chunks at line breaks;
+// chunks are parsed in parallel on a thread pool (delimiters located 64 bytes at a time with SIMD compares,
+// numbers converted with std::from_chars) and published in file order, so a plot of table() fills in while the
+// render thread never waits. Fields that are not numbers read as NaN, missing fields as NaN, extra fields are
+// dropped. Quoted fields are understood but must not contain line breaks.
+//
+// Loading stops early when `stop` is requested (e.g. ImPlotEngine::stop_token(), so closing the window ends the
+// load), on cancel(), or when the loader is destroyed; rows published until then stay in table().
+class CsvLoader {
+  public:
+    explicit CsvLoader(std::string path, CsvOptions options = {}, std::stop_token stop = {});
+    ~CsvLoader();
+
+    CsvLoader(const CsvLoader &) = delete;
+    CsvLoader &operator=(const CsvLoader &) = delete;
+
+    auto table() const -> std::shared_ptr<const CsvTable>;
+    auto state() const -> CsvLoadState { return this->state_.load(std::memory_order_acquire); }
+    // Set when state() is Failed.
+    auto error() const -> std::string;
+
+    auto cancel() -> void { this->thread_.request_stop(); }
+    // Blocks until the loader finished, was cancelled or failed.
+    auto wait() const -> void;
+
+    auto bytes_total() const -> uint64_t { return this->bytesTotal_.load(std::memory_order_relaxed); }
+    auto bytes_done() const -> uint64_t { return this->bytesDone_.load(std::memory_order_relaxed); }
+    // Parsed bytes per second of wall time since the loader started, in MB/s.
+    auto throughput_mb_s() const -> double;
+
+  private:
+    auto run(std::stop_token st) -> void;
+    auto publish(std::shared_ptr<const CsvChunk> chunk, uint64_t bytes) -> void;
+    auto finish(CsvLoadState state, std::string error = {}) -> void;
+
+    std::string path_;
+    CsvOptions options_;
+    std::chrono::steady_clock::time_point start_;
+    std::atomic<std::chrono::steady_clock::rep> elapsed_{0};  // frozen when loading ends
+    std::atomic<uint64_t> bytesTotal_{0};
+    std::atomic<uint64_t> bytesDone_{0};
+    std::atomic<CsvLoadState> state_{CsvLoadState::Loading};
+
+    mutable std::mutex mutex_;  // table_, error_
+    mutable std::condition_variable done_;
+    std::shared_ptr<const CsvTable> table_;
+    std::string error_;
+
+    std::jthread thread_;
+    // Forwards an external stop request to thread_; declared last so it goes away before the thread is joined.
+    std::optional<std::stop_callback<std::function<void()>>> stopForward_;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <implot.h>
+
+class ThreadPool;
+
+enum class DensityScale {
+    Linear,  // colour proportional to the point count
+    Log,     // colour proportional to log10(1 + count), so sparse outliers stay visible next to dense cores
+};
+
+// Scatter data drawn as a 2D histogram of the visible area instead of one marker per point.
+//
+// The plot area is divided into cells of cell_size() pixels; points are counted on the thread pool, each task
+// into its own histogram, and the histograms are summed with SIMD. Counting reruns only when the plot limits, the
+// plot size, the data pointer or count change, or after touch(); other frames draw the cached grid. The heatmap
+// holds one cell per cell_size() x cell_size() pixels, so drawing cost depends on the plot size, not on the data.
+// Keep one instance per series. Draws with the current colormap (ImPlot::PushColormap).
+class DensityPlot {
+  public:
+    explicit DensityPlot(ThreadPool *pool = nullptr);  // nullptr = ThreadPool::shared()
+
+    DensityPlot(const DensityPlot &) = delete;
+    DensityPlot &operator=(const DensityPlot &) = delete;
+
+    auto set_cell_size(int pixels) -> void { this->cellSize_ = pixels > 0 ? pixels : 1; }
+    auto cell_size() const -> int { return this->cellSize_; }
+    // The data changed in place: count again on the next plot().
+    auto touch() -> void {
+        this->dirty_ = true;
+        this->boundsValid_ = false;
+    }
+
+    // Plots (xs[i], ys[i]) for i < count in the current plot (linear axes). Must be called between
+    // ImPlot::BeginPlot / EndPlot. Auto-fit uses the bounds of the data.
+    auto plot(const char *label, const double *xs, const double *ys, size_t count,
+              DensityScale scale = DensityScale::Log) -> void;
+
+    // Of the last binning, e.g. for ImPlot::ColormapScale: the colour range is [0, scale_max()].
+    auto max_count() const -> uint32_t { return this->maxCount_; }
+    auto scale_max() const -> double;
+
+  private:
+    struct Key {
+        const double *xs = nullptr;
+        const double *ys = nullptr;
+        size_t count = 0;
+        double x_min = 0, x_max = 0, y_min = 0, y_max = 0;
+        int cols = 0, rows = 0;
+
+        auto operator==(const Key &) const -> bool = default;
+    };
+
+    auto bin(const Key &key) -> void;
+    auto tasks_for(size_t count) const -> size_t;
+    auto update_values(DensityScale scale) -> void;
+    auto fit(const double *xs, const double *ys, size_t count) -> void;
+
+    ThreadPool *pool_;
+    int cellSize_ = 4;
+    bool dirty_ = true;
+    Key key_;
+    DensityScale scale_ = DensityScale::Log;
+    uint32_t maxCount_ = 0;
+    std::vector<std::vector<uint32_t>> partials_;  // per task; partials_[0] ends up with the totals
+    std::vector<float> values_;                    // row-major, row 0 at the top
+
+    // Data bounds for auto-fit, cached per data identity.
+    const double *boundsXs_ = nullptr;
+    const double *boundsYs_ = nullptr;
+    size_t boundsCount_ = 0;
+    bool boundsValid_ = false;
+    double bxMin_ = 0, bxMax_ = 0, byMin_ = 0, byMax_ = 0;
+};
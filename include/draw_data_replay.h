@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <imgui.h>
+
+// Writes each frame's ImDrawData to a binary file: display rect, and per draw list its commands (clip rect,
+// texture, offsets, element count), vertices and indices as stored in memory. User callbacks are kept as markers
+// only; their code and data cannot outlive the process. Render thread, after ImGui::Render().
+class DrawDataRecorder {
+  public:
+    // Throws std::runtime_error if `path` cannot be opened.
+    explicit DrawDataRecorder(const std::string &path);
+
+    DrawDataRecorder(const DrawDataRecorder &) = delete;
+    DrawDataRecorder &operator=(const DrawDataRecorder &) = delete;
+
+    // Throws std::runtime_error when the file cannot be written.
+    auto record(const ImDrawData *draw_data) -> void;
+
+    auto frames() const -> uint64_t { return this->frames_; }
+    auto bytes() const -> uint64_t { return this->bytes_; }
+
+  private:
+    std::ofstream file_;
+    std::vector<uint8_t> buffer_;  // one frame, written with a single call
+    uint64_t frames_ = 0;
+    uint64_t bytes_ = 0;
+};
+
+// Frames written by DrawDataRecorder, loaded into draw lists once and handed out as ImDrawData, so the Vulkan
+// backend can be fed recorded production frames without running any drawer.
+//
+// Geometry, clip rects, draw-call count and order are exactly as recorded. Textures are not: font atlas
+// references resolve to the replaying context's atlas (glyph UVs are the recorded ones, so text shows the wrong
+// pixels, at the same cost), other texture ids to what map_texture() says, else also to the atlas. User
+// callbacks other than ImDrawCallback_ResetRenderState, e.g. PlotGpuSeries() draws, are skipped.
+class DrawDataReplay {
+  public:
+    // Throws std::runtime_error if the file cannot be read or was not written by DrawDataRecorder with the same
+    // ImDrawVert / ImDrawIdx layout.
+    explicit DrawDataReplay(const std::string &path);
+    ~DrawDataReplay();
+
+    DrawDataReplay(const DrawDataReplay &) = delete;
+    DrawDataReplay &operator=(const DrawDataReplay &) = delete;
+
+    auto frame_count() const -> size_t { return this->frames_.size(); }
+    // Recorded ImTextureID -> live one.
+    auto map_texture(uint64_t recorded, ImTextureID live) -> void { this->textures_[recorded] = live; }
+
+    // Draw data of frame `index`, valid until the next call. The replaying ImGui context must be current and its
+    // font atlas built (one ImGui::NewFrame() is enough).
+    auto frame(size_t index) -> ImDrawData *;
+    // Callbacks dropped from the recorded frames, in total.
+    auto callbacks_skipped() const -> uint64_t { return this->callbacksSkipped_; }
+
+  private:
+    enum class TexKind : uint8_t { Managed, Raw };
+
+    struct TexUse {
+        ImDrawCmd *cmd;
+        TexKind kind;
+        uint64_t id;  // ImTextureData::UniqueID for Managed, ImTextureID for Raw
+    };
+
+    struct Frame {
+        ImVec2 displayPos;
+        ImVec2 displaySize;
+        ImVec2 framebufferScale;
+        std::vector<std::unique_ptr<ImDrawList>> lists;
+        std::vector<TexUse> textures;  // every command's texture, patched in by frame()
+        int totalVtx = 0;
+        int totalIdx = 0;
+    };
+
+    std::vector<Frame> frames_;
+    std::unordered_map<uint64_t, ImTextureID> textures_;
+    uint64_t callbacksSkipped_ = 0;
+    ImDrawData drawData_;
+};
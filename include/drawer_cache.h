@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <imgui.h>
+
+// How often a drawer's closure has to run. With neither field set the drawer runs every frame (the default).
+struct DrawerUpdate {
+    std::chrono::nanoseconds interval{0};  // re-run at most this often
+    bool versioned{false};                 // re-run when the drawer's version is bumped (Entry::touch())
+
+    auto cached() const -> bool { return this->interval.count() > 0 || this->versioned; }
+};
+
+// Replays the output of a slow-moving drawer between its updates.
+//
+// While the closure runs, the top-level windows it begins are recorded: their position, size, content extent and
+// a copy of their draw list. On frames the closure is skipped, each window is begun again at the same place and
+// its draw list is swapped for the recorded one, so ImGui keeps the window alive and ImPlot does no work.
+//
+// The cache is dropped, and the closure runs, on any change the recording cannot reproduce: the drawer's interval
+// or version, display size, ImGui/ImPlot style, font atlas texture, or the mouse or keyboard interacting with one
+// of its windows. A drawer that opens child windows, popups or tooltips, or none at all, is never replayed.
+class DrawerCache {
+  public:
+    // Identity of everything every cached draw list depends on. Computed once per frame.
+    static auto context_epoch() -> uint64_t;
+
+    auto needs_run(const DrawerUpdate &update, uint64_t version, int64_t now_ns, uint64_t epoch) const -> bool;
+    auto begin_capture() -> void;
+    auto end_capture(uint64_t version, int64_t now_ns, uint64_t epoch) -> void;
+    auto replay() -> void;
+    auto clear() -> void { this->valid_ = false; }
+
+  private:
+    struct Window {
+        ImGuiID id;
+        std::string name;
+        ImGuiWindowFlags flags;
+        ImVec2 pos;
+        ImVec2 size;
+        ImVec2 content;
+        ImVector<ImDrawCmd> cmds;
+        ImVector<ImDrawIdx> idx;
+        ImVector<ImDrawVert> vtx;
+        ImVector<ImU8> callbackData;
+    };
+
+    auto interacting() const -> bool;
+
+    std::vector<Window> windows_;
+    bool valid_{false};
+    uint64_t version_{0};
+    int64_t runNs_{0};
+    uint64_t epoch_{0};
+    int frame_{0};
+    int firstBeginOrder_{0};
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "drawer_cache.h"
+
+struct Entry {
+    uint32_t id;
+    std::string key;
+    std::move_only_function<void()> fn;  // ImGui/ImPlot calls; the emit stage of a staged drawer
+    std::move_only_function<void()> prepare;  // optional, thread-safe, no ImGui: runs on the thread pool
+    DrawerUpdate update;
+    std::atomic<uint64_t> version{0};
+    DrawerCache cache;      // render thread only
+    bool prepared{false};   // prepare() ran for the upcoming emit
+
+    Entry(std::move_only_function<void()> f, std::string k = "", DrawerUpdate u = {})
+        : id(UINT32_MAX), key(std::move(k)), fn(std::move(f)), update(u) {}
+
+    Entry(std::move_only_function<void()> p, std::move_only_function<void()> f, std::string k)
+        : id(UINT32_MAX), key(std::move(k)), fn(std::move(f)), prepare(std::move(p)) {}
+
+    // Marks the drawer's data as changed; a versioned drawer re-runs on the next frame. Thread-safe.
+    auto touch() -> void { this->version.fetch_add(1, std::memory_order_release); }
+};
+
+using EntryPtr = std::shared_ptr<Entry>;
+
+struct DrawerCommand {
+    enum class Op : uint8_t { Add, RemoveId, RemoveKey, Clear, Touch };
+
+    Op op;
+    uint32_t id{0};
+    std::string key;
+    EntryPtr entry;
+};
+
+// Drawers in registration order with O(1) lookup by id and by key. Owned by the render thread, which applies
+// queued DrawerCommands to it at frame boundaries. Removal leaves a hole that is compacted away once holes
+// outnumber live drawers, so add and remove are amortized O(1).
+class DrawerRegistry {
+  public:
+    auto apply(DrawerCommand &cmd) -> void;
+    auto find(uint32_t id) const -> Entry *;
+    auto size() const -> size_t { return this->index_.size(); }
+
+    template <class F> auto for_each(F &&fn) const -> void {
+        for (const EntryPtr &item : this->slots_)
+            if (item)
+                fn(*item);
+    }
+
+  private:
+    auto add(EntryPtr item) -> void;
+    auto remove(uint32_t id) -> void;
+    auto remove(const std::string &key) -> void;
+    auto clear() -> void;
+    auto compact() -> void;
+
+    std::vector<EntryPtr> slots_;                                           // registration order, nullptr = hole
+    std::unordered_map<uint32_t, size_t> index_;                            // id -> slot
+    std::unordered_map<std::string, std::unordered_set<uint32_t>> keys_;    // key -> ids
+};
+
+// Drawer mutations recorded on any thread and submitted with ImPlotEngine::submit(). The whole batch is applied
+// at a single frame boundary, so no frame ever shows it half done. Ids are assigned when recorded.
+class DrawerBatch {
+  public:
+    template <class F> auto draw(F &&fn) -> uint32_t { return draw(std::make_shared<Entry>(std::forward<F>(fn))); }
+
+    template <class F> auto draw(std::string key, F &&fn) -> uint32_t {
+        return draw(std::make_shared<Entry>(std::forward<F>(fn), std::move(key)));
+    }
+
+    template <class F> auto draw(std::string key, DrawerUpdate update, F &&fn) -> uint32_t {
+        return draw(std::make_shared<Entry>(std::forward<F>(fn), std::move(key), update));
+    }
+
+    template <class P, class E> auto draw_staged(std::string key, P &&prepare, E &&emit) -> uint32_t {
+        return draw(std::make_shared<Entry>(std::forward<P>(prepare), std::forward<E>(emit), std::move(key)));
+    }
+
+    // Removes every drawer registered under `key`, including earlier ones of this batch, then adds `fn` under it.
+    template <class F> auto replace(std::string key, F &&fn) -> uint32_t {
+        this->remove(key);
+        return draw(std::move(key), std::forward<F>(fn));
+    }
+
+    auto draw(EntryPtr item) -> uint32_t;
+    auto remove(uint32_t id) -> void;
+    auto remove(const std::string &key) -> void;
+    auto clear() -> void;
+    auto touch(uint32_t id) -> void;
+    auto empty() const -> bool { return this->commands_.empty(); }
+
+  private:
+    friend class ImPlotEngine;
+
+    explicit DrawerBatch(std::atomic<uint32_t> &ids) : ids_(&ids) {}
+
+    std::atomic<uint32_t> *ids_;
+    std::vector<DrawerCommand> commands_;
+};
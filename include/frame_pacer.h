@@ -0,0 +1,25 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+// Caps the frame rate of a loop with a precise deadline schedule: a coarse sleep until shortly before the
+// deadline, then a spin for the remainder. The spin margin tracks how much the OS oversleeps, so the tail stays
+// short on a quiet machine and grows on a loaded one.
+class FramePacer {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    // 0 (or negative) disables pacing. Thread-safe; takes effect on the next pace().
+    auto set_target_fps(double fps) -> void { targetFps_.store(fps, std::memory_order_relaxed); }
+    auto target_fps() const -> double { return targetFps_.load(std::memory_order_relaxed); }
+
+    // Blocks until the next frame is due. Call once per frame, from the loop's thread only.
+    auto pace() -> void;
+
+  private:
+    std::atomic<double> targetFps_{0.0};
+    clock::time_point next_{};
+    clock::duration period_{};
+    clock::duration spinMargin_{std::chrono::microseconds(1000)};
+};
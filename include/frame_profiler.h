@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct ImDrawData;
+
+enum class FramePhase : uint8_t {
+    GpuWait,  // FrameLatency::Low: the GPU finishing the last frame before input is polled
+    PollEvents,
+    SwapchainResize,
+    NewFrame,
+    PrepareWait,  // staged drawers' prepare() still running on the thread pool
+    Drawers,
+    Render,
+    FrameRender,
+    FenceWait,  // nested in FrameRender
+    FramePresent,
+    Count,
+};
+
+extern auto FramePhaseName(FramePhase phase) -> const char *;
+
+struct DrawerSample {
+    uint32_t id;
+    uint32_t begin_ns;     // relative to FrameRecord::begin_ns
+    uint32_t duration_ns;
+};
+
+// Geometry of the draw lists owned by one ImGui window (child windows are windows of their own).
+struct WindowSample {
+    uint32_t id;  // hash of the window name, see FrameProfiler::window_name()
+    uint32_t vtx_count;
+    uint32_t idx_count;
+    uint32_t cmd_lists;
+    uint32_t draw_calls;
+};
+
+struct FrameRecord {
+    static constexpr size_t kMaxDrawers = 128;
+    static constexpr size_t kMaxWindows = 64;
+    static constexpr size_t kPhases = static_cast<size_t>(FramePhase::Count);
+
+    uint64_t frame;
+    int64_t begin_ns;  // steady_clock time since epoch
+    uint32_t duration_ns;
+    uint32_t phase_begin_ns[kPhases];  // relative to begin_ns
+    uint32_t phase_ns[kPhases];        // 0 when the phase did not run this frame
+    uint32_t vtx_count;                // ImDrawData::TotalVtxCount
+    uint32_t idx_count;                // ImDrawData::TotalIdxCount
+    uint32_t cmd_list_count;           // ImDrawData::CmdListsCount
+    uint32_t draw_call_count;          // commands with elements; callbacks are not counted
+    uint32_t gpu_ns;                   // render pass on the GPU, filled in a few frames later; 0 if not measured
+    uint32_t in_flight_begin;          // earlier frames the GPU had not finished when this frame's CPU work began
+    uint32_t in_flight_render;         // ... when its FrameRender had a command buffer to record into
+    uint32_t drawer_count;             // samples stored, capped at kMaxDrawers
+    uint32_t drawers_dropped;
+    uint32_t window_count;             // samples stored, capped at kMaxWindows
+    uint32_t windows_dropped;
+    DrawerSample drawers[kMaxDrawers];
+    WindowSample windows[kMaxWindows];
+
+    auto phase(FramePhase p) const -> uint32_t { return phase_ns[static_cast<size_t>(p)]; }
+};
+
+// How much CPU frame building overlapped GPU execution of earlier frames.
+struct OverlapSummary {
+    size_t samples{0};
+    double busy_at_begin{0.0};   // fraction of frames begun while the GPU still ran an earlier one
+    double busy_at_render{0.0};  // fraction of frames rendered while the GPU still ran an earlier one
+    double mean_in_flight{0.0};  // earlier frames on the GPU at FrameRender, mean
+    double gpu_wait_ms{0.0};     // mean GpuWait + FenceWait, the CPU blocked on the GPU
+};
+
+struct TimingSummary {
+    size_t samples{0};
+    double min_ms{0.0};
+    double mean_ms{0.0};
+    double p50_ms{0.0};
+    double p95_ms{0.0};
+    double p99_ms{0.0};
+    double max_ms{0.0};
+};
+
+// Records per-phase and per-drawer CPU timings of the engine frame loop into a ring of frame records.
+//
+// The render thread is the only writer. Every slot is guarded by a sequence counter (odd while being written),
+// so readers on any thread copy records without locks and simply skip a slot that is being rewritten. With
+// profiling disabled every hook is a single relaxed load. GPU times arrive after their frame ended and are
+// patched into its record in place, under the same sequence counter.
+class FrameProfiler {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    explicit FrameProfiler(size_t frames = 512);
+
+    auto set_enabled(bool enabled) -> void { enabled_.store(enabled, std::memory_order_relaxed); }
+    auto enabled() const -> bool { return enabled_.load(std::memory_order_relaxed); }
+
+    // --- Writer side, render thread only ---
+    auto begin_frame() -> void;
+    auto end_frame() -> void;
+    auto discard_frame() -> void { active_ = nullptr; }  // the slot is reused by the next begin_frame()
+    auto begin_phase(FramePhase phase) -> void;
+    auto end_phase(FramePhase phase) -> void;
+    auto frame_active() const -> bool { return active_ != nullptr; }
+    auto now_ns() const -> int64_t {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+    }
+    auto record_drawer(uint32_t id, const std::string &key, int64_t begin_ns) -> void;
+    // Totals plus per-window vertex, index, draw list and draw call counts.
+    auto record_draw_data(const ImDrawData *draw_data) -> void;
+    // Frame number of the record being written; only meaningful while frame_active().
+    auto active_frame() const -> uint64_t { return active_ ? active_->record.frame : 0; }
+    auto record_in_flight_begin(uint32_t frames) -> void;
+    auto record_in_flight_render(uint32_t frames) -> void;
+    // For an earlier frame; ignored once its record was overwritten.
+    auto record_gpu(uint64_t frame, uint64_t gpu_ns) -> void;
+
+    // --- Reader side, any thread ---
+    auto frames_recorded() const -> uint64_t { return next_frame_.load(std::memory_order_acquire); }
+    // Up to `count` most recent complete frames, oldest first.
+    auto latest(size_t count) const -> std::vector<FrameRecord>;
+    auto phase_summary(FramePhase phase, size_t frames = 240) const -> TimingSummary;
+    auto frame_summary(size_t frames = 240) const -> TimingSummary;
+    auto drawer_summary(uint32_t id, size_t frames = 240) const -> TimingSummary;
+    auto drawer_summary(const std::string &key, size_t frames = 240) const -> TimingSummary;
+    auto drawer_key(uint32_t id) const -> std::string;
+    auto gpu_summary(size_t frames = 240) const -> TimingSummary;  // frames with a GPU time only
+    auto overlap_summary(size_t frames = 240) const -> OverlapSummary;
+    auto window_name(uint32_t id) const -> std::string;
+
+    // Chrome trace event JSON (chrome://tracing, Perfetto) for the last `frames` frames.
+    auto write_chrome_trace(const std::string &path, size_t frames = 0) const -> void;
+
+    // ImGui/ImPlot window with phase timelines and the slowest drawers. Call inside a frame.
+    auto draw_overlay(bool *open = nullptr) const -> void;
+
+  private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        FrameRecord record;
+    };
+
+    auto read_slot(uint64_t frame, FrameRecord &out) const -> bool;
+    auto rel_ns(int64_t t) const -> uint32_t;
+    auto prune_names(uint64_t frame) -> void;
+
+    std::atomic<bool> enabled_{false};
+    const size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> next_frame_{0};
+
+    // Writer state
+    Slot *active_{nullptr};
+    int64_t phase_begin_[FrameRecord::kPhases]{};
+    // id -> last frame that sampled it. Names of ids that no longer appear in any slot are dropped, so drawer
+    // churn and per-frame window names do not grow the tables below without bound.
+    std::unordered_map<uint32_t, uint64_t> drawers_seen_;
+    std::unordered_map<uint32_t, uint64_t> windows_seen_;
+    uint64_t next_prune_{0};
+
+    // id -> key and id -> window name tables, written once per new drawer or window
+    mutable std::mutex keys_mutex_;
+    std::unordered_map<uint32_t, std::string> keys_;
+    std::unordered_map<uint32_t, std::string> window_names_;
+};
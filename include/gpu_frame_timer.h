@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkan_helper.h"
+
+struct GpuFrameTiming {
+    uint64_t tag;  // as given to begin()
+    uint64_t ns;   // from the first to the last timestamp on the GPU
+};
+
+// GPU time of each frame's rendering, from a pair of timestamp queries written into the frame's own command
+// buffer around its render pass.
+//
+// Query slots follow the caller's per-frame resources: slot i belongs to the command buffer / fence pair i, and
+// is read by collect(i) once that fence has been waited for anyway before reusing the pair. So results arrive as
+// many frames late as there are slots, and reading them never waits on the GPU. Render thread only.
+class GpuFrameTimer {
+  public:
+    GpuFrameTimer(VulkanHelper *vk, uint32_t slots);
+    ~GpuFrameTimer();
+
+    GpuFrameTimer(const GpuFrameTimer &) = delete;
+    GpuFrameTimer &operator=(const GpuFrameTimer &) = delete;
+
+    // False when the queue family writes no timestamps; every call below is then a no-op.
+    auto supported() const -> bool { return this->pool_ != VK_NULL_HANDLE; }
+    // Drops pending measurements and resizes the query pool. The GPU must be done with every slot.
+    auto reset(uint32_t slots) -> void;
+
+    // Outside a render pass, before and after the work to measure.
+    auto begin(VkCommandBuffer cmd, uint32_t slot, uint64_t tag) -> void;
+    auto end(VkCommandBuffer cmd, uint32_t slot) -> void;
+    // After the slot's last submission completed: queues its measurement for take().
+    auto collect(uint32_t slot) -> void;
+    // Measurements collected since the last call, oldest first.
+    auto take(std::vector<GpuFrameTiming> &out) -> void;
+
+  private:
+    struct Slot {
+        uint64_t tag = 0;
+        bool pending = false;  // both timestamps recorded, result not read yet
+    };
+
+    auto create_pool(uint32_t slots) -> void;
+    auto destroy_pool() -> void;
+
+    VulkanHelper *vk_;
+    VkQueryPool pool_ = VK_NULL_HANDLE;
+    double periodNs_ = 1.0;  // VkPhysicalDeviceLimits::timestampPeriod
+    uint64_t mask_ = ~0ull;  // of the queue family's valid timestamp bits
+    std::vector<Slot> slots_;
+    std::vector<GpuFrameTiming> done_;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <imgui_impl_vulkan.h>
+#include <implot.h>
+
+#include "vulkan_helper.h"
+
+enum class GpuSeriesMode : uint8_t {
+    Lines,   // line strip, 1 px wide
+    Points,  // point list, ImPlot marker size within the device's point size range; 1 px without largePoints
+};
+
+// A large static or append-only XY series living in a device-local vertex buffer.
+//
+// Points are converted once to float offsets from the first point (so precision follows the data's extent, not
+// its magnitude) and copied through a reusable staging buffer. Appends are serialized with each other but never
+// block rendering; a frame draws the points published when its drawer ran. Create through
+// ImPlotEngine::create_gpu_series(); the series keeps the shared device alive.
+class GpuSeries {
+  public:
+    GpuSeries(std::shared_ptr<VulkanHelper> vk, VulkanQueue queue, size_t capacity);
+    ~GpuSeries();
+
+    GpuSeries(const GpuSeries &) = delete;
+    GpuSeries &operator=(const GpuSeries &) = delete;
+
+    // Throws std::length_error past capacity().
+    auto append(const double *xs, const double *ys, size_t count) -> void;
+
+    auto size() const -> size_t { return this->count_.load(std::memory_order_acquire); }
+    auto capacity() const -> size_t { return this->capacity_; }
+    auto buffer() const -> VkBuffer { return this->buffer_; }
+    auto origin_x() const -> double { return this->originX_; }
+    auto origin_y() const -> double { return this->originY_; }
+    // Bounding box of the published points, for ImPlot auto-fit.
+    auto bounds(double &x_min, double &x_max, double &y_min, double &y_max) const -> bool;
+
+  private:
+    static constexpr size_t kStagingPoints = 512 * 1024;  // 4 MiB per upload chunk
+
+    std::shared_ptr<VulkanHelper> vk_;
+    VulkanQueue queue_;
+    size_t capacity_;
+    std::atomic<size_t> count_{0};
+    double originX_{0.0};
+    double originY_{0.0};
+    mutable std::mutex mutex_;  // appends, bounds
+    double xMin_{0.0}, xMax_{0.0}, yMin_{0.0}, yMax_{0.0};
+
+    VkBuffer buffer_ = VK_NULL_HANDLE;
+    VkDeviceMemory memory_ = VK_NULL_HANDLE;
+    VkBuffer staging_ = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory_ = VK_NULL_HANDLE;
+    float *stagingMapped_ = nullptr;
+    bool stagingCoherent_ = true;
+    VkCommandPool commandPool_ = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer_ = VK_NULL_HANDLE;
+    VkFence fence_ = VK_NULL_HANDLE;
+};
+
+// Line and point pipelines for GpuSeries, one set per engine and render pass. Drawn from an ImDrawCallback, so
+// the series lands in the right place in ImGui's draw order and is scissored to the plot area.
+class GpuSeriesRenderer {
+  public:
+    GpuSeriesRenderer(VulkanHelper *vk, VkRenderPass render_pass);
+    ~GpuSeriesRenderer();
+
+    GpuSeriesRenderer(const GpuSeriesRenderer &) = delete;
+    GpuSeriesRenderer &operator=(const GpuSeriesRenderer &) = delete;
+
+    // False when the library was built without glslc, so the shaders could not be compiled.
+    static auto available() -> bool;
+
+    // Swapchain recreation may replace the render pass; pipelines are rebuilt on next use.
+    auto set_render_pass(VkRenderPass render_pass) -> void;
+
+    // Renderer of the engine whose context is bound on this thread (set by ImPlotEngine).
+    static auto current() -> GpuSeriesRenderer *;
+    static auto set_current(GpuSeriesRenderer *renderer) -> void;
+
+    struct Draw {
+        GpuSeriesRenderer *renderer;
+        VkBuffer buffer;
+        uint32_t count;
+        GpuSeriesMode mode;
+        float color[4];
+        float point_size;
+        double ax, bx, ay, by;  // pixel = a * stored + b
+    };
+
+    auto record(VkCommandBuffer cb, const Draw &draw, const ImVec4 &clip_rect) -> void;
+
+  private:
+    auto pipeline(GpuSeriesMode mode) -> VkPipeline;
+    auto destroy_pipelines() -> void;
+
+    VulkanHelper *vk_;
+    VkRenderPass renderPass_;
+    VkPipelineLayout layout_ = VK_NULL_HANDLE;
+    VkShaderModule vert_ = VK_NULL_HANDLE;
+    VkShaderModule frag_ = VK_NULL_HANDLE;
+    VkPipeline pipelines_[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    float pointSizeRange_[2] = {1.0f, 1.0f};  // VkPhysicalDeviceLimits::pointSizeRange when largePoints is enabled
+};
+
+// Plots `series` in the current ImPlot plot (linear axes) with the next item colour; takes part in the legend
+// and auto-fit like any other item. Costs a draw callback on the CPU, independent of the number of points.
+extern auto PlotGpuSeries(const char *label, const GpuSeries &series, GpuSeriesMode mode = GpuSeriesMode::Lines,
+                          ImPlotItemFlags flags = 0) -> void;
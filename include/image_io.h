@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Writes tightly packed RGBA8 pixels as a PNG (stored deflate blocks, no external dependencies).
+extern auto WritePngRGBA(const std::string &path, const uint8_t *rgba, uint32_t width, uint32_t height) -> void;
+
+// Writes tightly packed RGBA8 pixels as-is.
+extern auto WriteRawRGBA(const std::string &path, const uint8_t *rgba, uint32_t width, uint32_t height) -> void;
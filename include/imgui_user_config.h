@@ -1,3 +1,14 @@
 #pragma once
 #define ImDrawIdx unsigned int
 
+// The current-context pointers of ImGui, ImPlot and ImPlot3D are thread-local, so every ImPlotEngine drives its own
+// contexts from its own render thread. Storage lives in src/imgui_thread_context.cpp.
+struct ImGuiContext;
+struct ImPlotContext;
+struct ImPlot3DContext;
+extern thread_local ImGuiContext *ImPlotUtilImGuiContext;
+extern thread_local ImPlotContext *ImPlotUtilImPlotContext;
+extern thread_local ImPlot3DContext *ImPlotUtilImPlot3DContext;
+#define GImGui ImPlotUtilImGuiContext
+#define GImPlot ImPlotUtilImPlotContext
+#define GImPlot3D ImPlotUtilImPlot3DContext
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <implot.h>
+
+enum class DecimateMode {
+    MinMax,  // per pixel column: first, min, max, last (pixel-exact for lines, spikes always kept)
+    Lttb,    // largest-triangle-three-buckets, ~2 points per pixel column
+};
+
+// Reduces a line series with ascending x to what can actually be seen at the current plot width. The output
+// buffers are owned by the decimator and reused between frames, so keep one instance per series.
+class SeriesDecimator {
+  public:
+    struct View {
+        const double *xs{nullptr};
+        const double *ys{nullptr};
+        int count{0};
+    };
+
+    // Visible part of (xs, ys) between x_min and x_max reduced to per-column envelopes, plus the neighbouring
+    // sample on each side so the line reaches the plot edges. Returns the input itself when it is already sparse.
+    auto minmax(const double *xs, const double *ys, size_t n, double x_min, double x_max, int pixel_width) -> View;
+
+    // Same visible range reduced with LTTB down to `threshold` points.
+    auto lttb(const double *xs, const double *ys, size_t n, double x_min, double x_max, size_t threshold) -> View;
+
+    auto decimate(DecimateMode mode, const double *xs, const double *ys, size_t n, double x_min, double x_max,
+                  int pixel_width) -> View;
+
+  private:
+    auto emit(double x, double y) -> void {
+        xs_.push_back(x);
+        ys_.push_back(y);
+    }
+    auto view() const -> View { return View{xs_.data(), ys_.data(), static_cast<int>(xs_.size())}; }
+
+    std::vector<double> xs_;
+    std::vector<double> ys_;
+};
+
+// Plots a decimated line using the current plot's x limits and pixel width. Must be called between
+// ImPlotBeginPlot() / ImPlotEndPlot() (or ImPlot::BeginPlot / EndPlot).
+extern auto PlotLineDecimated(const char *label, const double *xs, const double *ys, size_t n,
+                              SeriesDecimator &decimator, DecimateMode mode = DecimateMode::MinMax,
+                              ImPlotLineFlags flags = 0) -> void;
@@ -2,8 +2,11 @@
 
 #include "implot_util.h"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <stop_token>
@@ -12,64 +15,321 @@
 #include <thread>
 #include <vector>
 
+#include <draw_data_replay.h>
+#include <drawer_registry.h>
+#include <frame_pacer.h>
+#include <frame_profiler.h>
+#include <gpu_frame_timer.h>
+#include <gpu_series.h>
+#include <mpsc_queue.h>
+#include <thread_pool.h>
+#include <vulkan_capture.h>
+#include <vulkan_frame_ring.h>
 #include <vulkan_helper.h>
+#include <vulkan_offscreen.h>
 
-struct Entry {
-    uint32_t id;
-    std::string key;
-    std::move_only_function<void()> fn;
+enum class RenderMode {
+    Continuous,  // render every iteration of the loop (vsync / present mode bound)
+    OnDemand,    // sleep in the event loop until input, invalidate() or a requested frame deadline
+};
+
+// Where the CPU waits for the GPU. Either way no more than frames_in_flight() frames are queued.
+enum class FrameLatency : uint8_t {
+    Throughput,  // build frame N+1 while the GPU renders frame N; its input can be up to a frame older
+    Low,         // wait for the GPU to finish frame N before polling input for N+1; CPU and GPU alternate
+};
+
+enum class EngineReadiness : uint8_t {
+    Uninitialized,
+    Initializing,  // init() / init_async() in progress
+    Ready,         // window, device and contexts are up; no frame shown yet
+    Presented,     // the first frame was presented (or rendered, headless)
+    Failed,        // init threw; the future returned by init_async() holds the exception
+};
 
-    Entry(std::move_only_function<void()> f, std::string k = "")
-        : id(UINT32_MAX), key(std::move(k)), fn(std::move(f)) {}
+// Where engine start-up time goes. `vulkan` is the shared device's bring-up, paid by the first engine only.
+struct EngineStartupStats {
+    double init_ms = 0.0;          // init() / init_headless() total
+    double imgui_vulkan_ms = 0.0;  // ImGui_ImplVulkan_Init, mostly pipeline creation (served by the pipeline cache)
+    VulkanStartupStats vulkan;
 };
 
-using EntryPtr = std::shared_ptr<Entry>;
+// Optional per-frame budgets, 0 for none. Going over one is logged to stderr when it starts, not on every frame it
+// lasts: a window whose draw list holds more than `window_vtx` vertices, or a frame whose render pass took longer
+// than `gpu_ms` on the GPU (known a few frames later).
+struct RenderBudget {
+    uint32_t window_vtx = 0;
+    double gpu_ms = 0.0;
+};
 
+// One window (or offscreen target) with its own ImGui/ImPlot/ImPlot3D context and render thread. instance() is the
+// process-wide default engine; create() makes further independent ones. All engines share one VkInstance/VkDevice
+// and the GLFW event queue, which whichever render thread is polling drains for every window.
 class ImPlotEngine : public Singleton<ImPlotEngine> {
     friend class Singleton<ImPlotEngine>;
 
   public:
+    static auto create() -> std::unique_ptr<ImPlotEngine>;
+    ~ImPlotEngine();
+
     auto init(const std::string &title) -> void;
+    // Runs init() on a background thread and returns at once, so GLFW, instance/device and swapchain set-up
+    // overlap the application's own loading. show() waits for it and rethrows its failure. Drawers can be
+    // registered meanwhile: they are queued without taking any lock and appear on the first frame.
+    auto init_async(const std::string &title) -> std::shared_future<void>;
+    auto readiness() const -> EngineReadiness { return readiness_.load(std::memory_order_acquire); }
+    // From the start of init() / init_async() to the end of the first frame; empty until then.
+    auto time_to_first_frame() const -> std::optional<std::chrono::nanoseconds>;
     auto deinit() -> void;
     auto show_async() -> void;
     auto show_stop() -> void;
     auto show_wait() -> void;
+    // The engine must outlive a detached show thread: close its window (or have it stopped otherwise) and wait
+    // for show() to return before destroying the engine.
     auto show_detach() -> void;
+    // Of the show_async() thread: requested by show_stop(), or when its window is closed. Pass it to work that
+    // should end with the window, such as a CsvLoader. Never requested before show_async().
+    auto stop_token() const -> std::stop_token { return show_thread_.get_stop_token(); }
     auto show(std::optional<std::string> title = std::nullopt, bool clear_entries = true) -> void;
 
+    // Headless mode: no GLFW window or swapchain, the drawer list renders into an offscreen image instead.
+    auto init_headless(const std::string &title, uint32_t width, uint32_t height) -> void;
+    auto render_headless(uint32_t frames, float delta_time = 1.0f / 60.0f) -> void;
+    auto read_pixels() -> std::vector<uint8_t>;  // RGBA8 of the last headless frame
+    auto save_png(const std::string &path) -> void;
+    auto save_raw(const std::string &path) -> void;
+    auto is_headless() const -> bool { return headless_; }
+
     template <class F> auto draw(F &&fn) -> uint32_t { return draw(std::make_shared<Entry>(std::forward<F>(fn))); }
 
     template <class F> auto draw(std::string key, F &&fn) -> uint32_t {
         return draw(std::make_shared<Entry>(std::forward<F>(fn), std::move(key)));
     }
 
+    // Slow-moving drawer: between updates its recorded output is replayed instead of running `fn` (DrawerCache).
+    template <class F> auto draw(std::string key, DrawerUpdate update, F &&fn) -> uint32_t {
+        return draw(std::make_shared<Entry>(std::forward<F>(fn), std::move(key), update));
+    }
+
+    // Two-stage drawer. `prepare` (filtering, resampling, statistics; no ImGui) for frame N+1 runs on the shared
+    // work-stealing pool, in parallel with the other drawers' prepares, while frame N is rendered and presented.
+    // `emit` then issues the ImGui/ImPlot calls on the render thread. An invalidate() after the pipelined prepare
+    // started makes it run again before the emit, so on-demand frames never show data older than their trigger.
+    template <class P, class E> auto draw_staged(std::string key, P &&prepare, E &&emit) -> uint32_t {
+        return draw(std::make_shared<Entry>(std::forward<P>(prepare), std::forward<E>(emit), std::move(key)));
+    }
+
+    template <class F> auto replace_drawer(std::string key, F &&fn) -> uint32_t {
+        auto b = this->batch();
+        const uint32_t id = b.replace(std::move(key), std::forward<F>(fn));
+        this->submit(std::move(b));
+        return id;
+    }
+
+    // Drawer mutations never block: they are queued and applied by the render thread at the next frame boundary,
+    // in submission order. A batch is applied as a whole.
     auto draw(EntryPtr item) -> uint32_t;
     auto remove_drawer(uint32_t id) -> void;
     auto remove_drawer(const std::string &name) -> void;
     auto remove_drawers() -> void;
+    auto touch_drawer(uint32_t id) -> void;
+    auto batch() -> DrawerBatch { return DrawerBatch(this->lastDrawerId_); }
+    auto submit(DrawerBatch &&batch) -> void;
+
+    // Static or append-only series uploaded once to a device-local buffer on this engine's device and drawn with
+    // PlotGpuSeries(). Needs an initialized engine; the series may be drawn by any engine sharing the device.
+    auto create_gpu_series(size_t capacity) -> std::shared_ptr<GpuSeries>;
+
+    // Valid once readiness() is Ready or later.
+    auto startup_stats() const -> const EngineStartupStats & { return startupStats_; }
+    // Driver host memory behind the shared device's VkAllocationCallbacks, per VkSystemAllocationScope: live and
+    // peak bytes, live and total allocation counts. Covers every engine on the device. All zero before Ready.
+    auto vulkan_host_memory() const -> VulkanHostAllocStats;
+
+    // CPU timing of the frame loop phases and of each drawer. Disabled by default; queries are thread-safe.
+    auto profiler() -> FrameProfiler & { return profiler_; }
+    auto set_profiling(bool enabled) -> void { profiler_.set_enabled(enabled); }
+    auto set_profiler_overlay(bool visible) -> void { showProfiler_.store(visible, std::memory_order_relaxed); }
+
+    // GPU time of the render pass and draw data geometry (totals, per window) land in the profiler's frame
+    // records; the GPU time of a frame arrives a few frames after it. Thread-safe.
+    auto set_render_budget(RenderBudget budget) -> void;
+    auto render_budget() const -> RenderBudget;
+    // Latest measured render pass GPU time, of any frame; empty before the first or without timestamp support.
+    auto gpu_frame_ms() const -> std::optional<double>;
+
+    // On-demand rendering. invalidate() and request_frame_*() are thread-safe; drawers that animate call
+    // request_frame_in() every frame with their next deadline.
+    auto set_render_mode(RenderMode mode) -> void;
+    auto render_mode() const -> RenderMode { return renderMode_.load(std::memory_order_relaxed); }
+    auto set_settle_frames(int frames) -> void { settleFrameCount_.store(frames, std::memory_order_relaxed); }
+    auto invalidate() -> void;
+    auto request_frame_at(std::chrono::steady_clock::time_point deadline) -> void;
+    auto request_frame_in(std::chrono::steady_clock::duration delay) -> void {
+        request_frame_at(std::chrono::steady_clock::now() + delay);
+    }
+
+    // Swapchain configuration and frame pacing. Thread-safe; the render thread rebuilds the swapchain on its next
+    // frame. An unsupported present mode falls back to FIFO. target_fps <= 0 disables the pacer.
+    auto set_present_mode(VkPresentModeKHR mode) -> void;
+    auto set_min_image_count(uint32_t count) -> void;
+    auto set_target_fps(double fps) -> void { pacer_.set_target_fps(fps); }
+    auto present_mode() const -> VkPresentModeKHR { return presentMode_.load(std::memory_order_relaxed); }
+    // Frames the CPU may record ahead of the GPU, 1..VulkanFrameRing::kMaxFrames, independent of the swapchain
+    // image count. Each has its own command buffer and fence. Thread-safe; applied at the next frame. Achieved
+    // overlap: profiler().overlap_summary().
+    auto set_frames_in_flight(uint32_t frames) -> void;
+    auto frames_in_flight() const -> uint32_t { return framesInFlight_.load(std::memory_order_relaxed); }
+    auto set_frame_latency(FrameLatency latency) -> void { frameLatency_.store(latency, std::memory_order_relaxed); }
+    auto frame_latency() const -> FrameLatency { return frameLatency_.load(std::memory_order_relaxed); }
+
+    // Records every rendered frame (the swapchain image, or the offscreen image when headless) to `path` until
+    // stop_capture(). Copies go through a ring of staging buffers and are written by a background thread; when
+    // the ring is full frames are dropped, the frame loop never waits. Thread-safe. Throws std::logic_error before
+    // init, std::runtime_error if the file cannot be opened or the surface does not allow copying its images.
+    // A running capture is stopped first.
+    auto start_capture(const std::string &path, FrameCaptureOptions options = {}) -> void;
+    // Writes the frames already copied and closes the file.
+    auto stop_capture() -> void;
+    // Of the running capture, else of the last one.
+    auto capture_stats() const -> FrameCaptureStats;
+
+    // Appends the draw data of every frame built from the drawers to `path` (DrawDataRecorder), until
+    // stop_draw_recording(). Written on the render thread as each frame is built. Thread-safe. Throws
+    // std::runtime_error if the file cannot be opened; a write failure ends the recording.
+    auto start_draw_recording(const std::string &path) -> void;
+    auto stop_draw_recording() -> void;
+    // Frames from `replay`, one per rendered frame and in a loop, instead of the drawers: show() and
+    // render_headless() hand them straight to FrameRender. Drawers do not run and drawer commands wait until the
+    // replay is cleared with nullptr. Input still reaches ImGui, which draws nothing of its own meanwhile.
+    // Thread-safe.
+    auto set_replay(std::shared_ptr<DrawDataReplay> replay) -> void;
 
   private:
+    // GLFW input captured on whichever thread pumps events, replayed into the ImGui backend on the render thread.
+    struct InputEvent {
+        enum class Type : uint8_t { CursorPos, MouseButton, Scroll, Key, Char, CursorEnter, Focus };
+        Type type;
+        int a, b, c, d;
+        double x, y;
+    };
+
+    auto initialized() const -> bool { return this->window_ || this->headless_; }
+    auto bind_context() -> void;
+    auto setup_imgui(float main_scale) -> void;
+    auto destroy_contexts() -> void;
+    auto init_imgui_vulkan(VkRenderPass render_pass, uint32_t image_count) -> void;
+    auto begin_init() -> void;
+    auto finish_init() -> void;
+    auto await_init() -> void;
+    auto mark_frame_done() -> void;
+    auto apply_drawer_commands() -> void;
+    auto build_frame() -> ImDrawData *;
+    auto replay_frame(DrawDataReplay &replay, size_t index) -> ImDrawData *;
+    auto record_frame(const ImDrawData *draw_data) -> void;
+    auto gpu_tag() const -> uint64_t;
+    auto sync_frame_start() -> void;
+    auto check_window_budget(const ImDrawData *draw_data) -> void;
+    auto collect_gpu_timings() -> void;
+    auto launch_prepares() -> void;
+    auto finish_prepares() -> void;
+    auto run_drawer(Entry &item, uint64_t epoch, int64_t now_ns) -> void;
+    auto wait_for_frame() -> void;
+    auto poll_events() -> void;
+    auto wait_events(double timeout) -> void;
+    auto forward_input() -> void;
+    auto install_input_callbacks() -> void;
+    static auto note_input(GLFWwindow *window) -> void;
+    static auto queue_input(GLFWwindow *window, const InputEvent &event) -> void;
+    auto signal() -> void;
+    auto wake() -> void;
+    auto select_present_mode(VkSurfaceKHR surface) -> VkPresentModeKHR;
     auto SetupVulkanWindow(ImGui_ImplVulkanH_Window *wd, VkSurfaceKHR surface, int width, int height) -> void;
     auto CleanupVulkanWindow() -> void;
     auto FrameRender(ImGui_ImplVulkanH_Window *wd, ImDrawData *draw_data) -> void;
     auto FramePresent(ImGui_ImplVulkanH_Window *wd) -> void;
 
   private:
-    uint32_t lastDrawerId_{0};
-    std::atomic<std::shared_ptr<const std::vector<EntryPtr>>> drawers_;
-    std::recursive_mutex drawers_mutex_;
+    std::atomic<uint32_t> lastDrawerId_{0};
+    MpscQueue<std::vector<DrawerCommand>> drawerCommands_;
+    DrawerRegistry drawers_;                      // render thread only
+    bool drawersLive_{false};                     // a drawer command was ever applied
+    mutable std::recursive_mutex drawers_mutex_;  // init/deinit/show state
+    TaskGroup prepares_;
+    std::atomic<uint64_t> invalidations_{0};
+    uint64_t preparesEpoch_{0};  // invalidations_ when the in-flight prepares were launched
+
+  private:
+    FrameProfiler profiler_;
+    std::atomic<bool> showProfiler_{false};
+    std::unique_ptr<GpuFrameTimer> gpuTimer_;
+    std::vector<GpuFrameTiming> gpuTimings_;
+    std::atomic<int64_t> lastGpuNs_{-1};
+    std::atomic<uint32_t> budgetWindowVtx_{0};
+    std::atomic<double> budgetGpuMs_{0.0};
+    std::vector<std::string> overBudget_;  // windows over budget last frame; render thread
+    std::vector<std::string> overBudgetNext_;
+    bool gpuOverBudget_{false};
+
+  private:
+    std::atomic<RenderMode> renderMode_{RenderMode::Continuous};
+    std::atomic<bool> dirty_{true};
+    std::atomic<bool> inputPending_{false};
+    std::atomic<bool> wakeable_{false};  // GLFW is up and glfwPostEmptyEvent() may be called
+    std::atomic<int64_t> nextFrameNs_{INT64_MAX};  // steady_clock deadline requested by drawers
+    std::atomic<int> settleFrameCount_{3};
+    int settleFrames_{0};
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    bool wakeSignal_{false};
+
+  private:
+    ImGuiContext *imguiContext_{nullptr};
+    ImPlotContext *implotContext_{nullptr};
+    ImPlot3DContext *implot3dContext_{nullptr};
+    std::mutex inputMutex_;
+    std::vector<InputEvent> inputEvents_;
+    std::vector<InputEvent> inputDrain_;
 
   private:
-    VulkanHelper vulkanHelper_;
+    std::shared_ptr<VulkanHelper> vulkanHelper_;
+    VulkanQueue queue_;
+    VkDescriptorPool descriptorPool_{VK_NULL_HANDLE};
+    std::unique_ptr<GpuSeriesRenderer> gpuSeriesRenderer_;
+    EngineStartupStats startupStats_;
+    std::atomic<EngineReadiness> readiness_{EngineReadiness::Uninitialized};
+    std::chrono::steady_clock::time_point initStart_;
+    std::atomic<int64_t> firstFrameNs_{-1};
+    std::shared_future<void> initFuture_;  // of the last init_async(); guarded by drawers_mutex_
     ImGui_ImplVulkanH_Window mainWindowData_;
     uint32_t minImageCount_{2};
     bool swapChainRebuild_{false};
+    std::atomic<VkPresentModeKHR> presentModeRequest_{VK_PRESENT_MODE_FIFO_KHR};  // constructor sets the build default
+    std::atomic<VkPresentModeKHR> presentMode_{VK_PRESENT_MODE_FIFO_KHR};
+    std::atomic<uint32_t> minImageCountRequest_{2};
+    std::atomic<bool> swapchainConfigDirty_{false};
+    std::atomic<uint32_t> framesInFlight_{2};
+    std::atomic<FrameLatency> frameLatency_{FrameLatency::Throughput};
+    VulkanFrameRing frames_;               // swapchain path; the offscreen target has its own
+    VkImageUsageFlags swapchainUsage_{0};  // beyond colour attachment: transfer source when the surface allows it
+    mutable std::mutex captureMutex_;      // capture_, captureStats_; held by the render thread around its use
+    std::unique_ptr<VulkanFrameCapture> capture_;
+    FrameCaptureStats captureStats_;
+    std::mutex replayMutex_;  // recorder_, replay_, replayFrame_
+    std::unique_ptr<DrawDataRecorder> recorder_;
+    std::shared_ptr<DrawDataReplay> replay_;
+    size_t replayFrame_{0};
+    FramePacer pacer_;
     GLFWwindow *window_{nullptr};
+    bool headless_{false};
+    VulkanOffscreen offscreen_;
+    bool showDemoWindow_{false};
+    ImVec4 clearColor_{0.45f, 0.55f, 0.60f, 1.00f};
 
   private:
     std::string title_;
     std::jthread show_thread_;
+    std::atomic<bool> showRunning_{false};  // the show_async() thread is inside show()
     std::stop_token stop_token_;
-    ImPlotEngine() noexcept = default;
-    ~ImPlotEngine() noexcept = default;
+    ImPlotEngine();
 };
\ No newline at end of file
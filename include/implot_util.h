@@ -33,5 +33,17 @@ extern auto ImPlotBeginPlot(const std::string &plot_title,
 
 extern auto ImPlotEndPlot() -> void;
 
+// Dashed lines are written as quads straight into the draw list with one vertex reservation, and only the dashes
+// inside the current clip rect are generated.
 extern auto AddDashedLine(ImDrawList *draw_list, ImVec2 p1, ImVec2 p2, ImU32 color, float thickness,
                           float dash_len = 6.0f, float gap_len = 4.0f) -> void;
+
+// The pattern runs on across vertices, starting `phase` pixels into it. Returns the phase at the last point, so a
+// polyline drawn in pieces keeps one continuous pattern.
+extern auto AddDashedPolyline(ImDrawList *draw_list, const ImVec2 *points, int count, ImU32 color, float thickness,
+                              float dash_len = 6.0f, float gap_len = 4.0f, float phase = 0.0f) -> float;
+
+// ImPlot line item drawn dashed: legend, colour, line weight and auto-fit as for ImPlot::PlotLine. Call between
+// BeginPlot / EndPlot.
+extern auto PlotDashedLine(const char *label, const double *xs, const double *ys, int count, float dash_len = 6.0f,
+                           float gap_len = 4.0f, ImPlotItemFlags flags = 0) -> void;
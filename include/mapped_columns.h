@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <implot.h>
+
+enum class ColumnType : uint32_t {
+    F32 = 1,
+    F64 = 2,
+    I64 = 3,  // e.g. timestamps in ns; plotted as value * scale
+};
+
+// Access pattern hint for the whole mapping (madvise).
+enum class MappedAccess {
+    Normal,
+    Sequential,  // scans, exports: aggressive read-ahead, pages dropped behind
+    Random,      // zoomed-in browsing: no read-ahead
+};
+
+// One column to write with WriteMappedColumns(). `data` holds `rows` values of `type`, tightly packed.
+struct MappedColumnSpec {
+    std::string name;
+    ColumnType type;
+    const void *data;
+    double scale = 1.0;
+};
+
+// Writes a columnar file readable by MappedColumns. Columns are stored one after another, each 64-byte aligned,
+// with their min/max (for auto-fit) and whether they are sorted (for visible-range lookup) recorded in the header.
+// Throws std::runtime_error on I/O errors.
+extern auto WriteMappedColumns(const std::string &path, const std::vector<MappedColumnSpec> &columns, size_t rows)
+    -> void;
+
+// Read-only columnar data source backed by a memory mapping: opening costs the header only, samples are read
+// straight from the page cache by ImPlot getters, and nothing is copied into process memory.
+//
+// File layout (little endian): a 32-byte file header, `column_count` 96-byte column descriptors, then the data.
+// A column is `rows` values of its type starting at `offset`, `stride` bytes apart, so both columnar and
+// interleaved (row-major) records can be described.
+class MappedColumns {
+  public:
+    struct Column {
+        std::string name;
+        ColumnType type;
+        uint64_t offset;
+        uint64_t stride;
+        double scale;
+        double min;  // scaled
+        double max;
+        bool sorted;  // non-decreasing, so visible rows are found by binary search
+    };
+
+    // Throws std::runtime_error if the file cannot be mapped or its header is invalid or out of bounds.
+    explicit MappedColumns(const std::string &path);
+    ~MappedColumns();
+
+    MappedColumns(const MappedColumns &) = delete;
+    MappedColumns &operator=(const MappedColumns &) = delete;
+
+    auto rows() const -> size_t { return this->rows_; }
+    auto columns() const -> const std::vector<Column> & { return this->columns_; }
+    // Index of the column called `name`, or -1.
+    auto find(const std::string &name) const -> int;
+
+    auto value(int column, size_t row) const -> double;
+
+    auto advise(MappedAccess access) const -> void;
+    // Asks the kernel to start reading rows [first, first + count) of `column` in the background (MADV_WILLNEED).
+    auto prefetch(int column, size_t first, size_t count) const -> void;
+
+    // Rows whose x lies in [x_min, x_max] plus one neighbour on each side. The whole table unless `x` is sorted.
+    auto visible_rows(int x, double x_min, double x_max, size_t &first, size_t &count) const -> void;
+
+    // Plots column `y` over column `x` for the rows visible in the current plot, and prefetches one view width of
+    // rows on either side so panning finds them resident. Auto-fit uses the header's min/max, never the data.
+    auto plot_line(const char *label, int x, int y, ImPlotLineFlags flags = 0) const -> void;
+    auto plot_scatter(const char *label, int x, int y, ImPlotScatterFlags flags = 0) const -> void;
+
+  private:
+    struct Cursor {
+        const MappedColumns *source;
+        int x, y;
+        size_t first;
+    };
+
+    static auto getter(int idx, void *data) -> ImPlotPoint;
+    auto prepare_plot(int x, int y, ImPlotItemFlags flags, Cursor &cursor) const -> int;
+
+    void *map_ = nullptr;
+    size_t mapSize_ = 0;
+    size_t rows_ = 0;
+    std::vector<Column> columns_;
+};
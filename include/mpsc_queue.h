@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free multi-producer, single-consumer FIFO (Vyukov's intrusive node queue).
+//
+// push() is one atomic exchange plus the node allocation and never waits for the consumer. pop() must only be
+// called from one thread; it may report empty while a producer is between its exchange and its link store, in
+// which case the element shows up on a later pop().
+template <class T> class MpscQueue {
+  public:
+    MpscQueue() = default;
+    ~MpscQueue() {
+        T discard;
+        while (this->pop(discard)) {
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    auto push(T value) -> void { this->push_node(new Node{{nullptr}, std::move(value)}); }
+
+    auto pop(T &out) -> bool {
+        Node *tail = this->tail_;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &this->stub_) {
+            if (!next)
+                return false;
+            this->tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            this->tail_ = next;
+            out = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+        if (tail != this->head_.load(std::memory_order_acquire))
+            return false;  // a push is in flight
+        this->push_node(&this->stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+        this->tail_ = next;
+        out = std::move(tail->value);
+        delete tail;
+        return true;
+    }
+
+  private:
+    struct Node {
+        std::atomic<Node *> next;
+        T value;
+    };
+
+    auto push_node(Node *node) -> void {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node *prev = this->head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    Node stub_{{nullptr}, T{}};
+    std::atomic<Node *> head_{&stub_};
+    Node *tail_{&stub_};  // consumer only
+};
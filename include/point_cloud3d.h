@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include <implot3d.h>
+
+// A large static point cloud for ImPlot3D, drawn at a level of detail that follows the view.
+//
+// An octree is built on a background thread: points are partitioned into octants until a node holds at most
+// `leaf_size` points, stored leaf by leaf, and shuffled within each leaf so that any prefix of a leaf is a uniform
+// sample of it. Each frame the tree is walked from the root; nodes outside the plot's axis box (the view volume of
+// ImPlot3D's orthographic projection) are skipped, each visible leaf asks for points in proportion to its projected
+// screen area, and the total is scaled down to the point budget. The chosen prefixes are gathered into one
+// ImPlot3D::PlotScatter call, and auto-fit uses the bounds of the whole cloud. Until the tree is ready, an evenly
+// strided sample within the budget is drawn (and fitted) instead.
+class PointCloud3D {
+  public:
+    PointCloud3D(std::vector<float> xs, std::vector<float> ys, std::vector<float> zs, size_t leaf_size = 4096);
+    ~PointCloud3D();
+
+    PointCloud3D(const PointCloud3D &) = delete;
+    PointCloud3D &operator=(const PointCloud3D &) = delete;
+
+    auto ready() const -> bool { return this->ready_.load(std::memory_order_acquire); }
+    auto size() const -> size_t { return this->count_; }
+
+    // Upper bound on the points handed to ImPlot3D per frame.
+    auto set_point_budget(size_t points) -> void { this->budget_ = points > 0 ? points : 1; }
+    // Points drawn per pixel of a leaf's projected area before the budget applies; higher is denser.
+    auto set_points_per_pixel(float density) -> void { this->density_ = density > 0.0f ? density : 1e-3f; }
+
+    // Must be called between ImPlot3D::BeginPlot / EndPlot.
+    auto plot(const char *label, ImPlot3DScatterFlags flags = 0) -> void;
+
+    // Of the last plot(): points drawn and leaves they came from.
+    auto drawn_points() const -> size_t { return this->drawnPoints_; }
+    auto drawn_leaves() const -> size_t { return this->drawnLeaves_; }
+
+  private:
+    struct Node {
+        float min[3];
+        float max[3];
+        uint32_t first;        // into the reordered points
+        uint32_t count;
+        uint32_t firstChild;   // into nodes; children are contiguous
+        uint32_t childCount;   // 0 for a leaf
+    };
+
+    struct Tree {
+        std::vector<float> xs, ys, zs;  // reordered: every node's points are contiguous
+        std::vector<Node> nodes;        // nodes[0] is the root
+    };
+
+    auto build(std::stop_token st) -> void;
+
+    std::vector<float> xs_, ys_, zs_;  // as given; released once the tree is ready
+    size_t count_;
+    size_t leafSize_;
+    size_t budget_ = 1000000;
+    float density_ = 1.0f;
+
+    std::unique_ptr<Tree> tree_;  // written by the builder before ready_ is set
+    std::atomic<bool> ready_{false};
+    bool released_ = false;       // render thread: xs_/ys_/zs_ freed
+
+    // Render-thread scratch, reused across frames.
+    std::vector<float> gx_, gy_, gz_;
+    std::vector<uint32_t> stack_;
+    struct Pick {
+        uint32_t node;
+        double want;
+    };
+    std::vector<Pick> picks_;
+    size_t drawnPoints_ = 0;
+    size_t drawnLeaves_ = 0;
+
+    std::jthread builder_;  // last: joined before the members it uses go away
+};
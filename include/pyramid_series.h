@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <vector>
+
+#include <implot.h>
+
+enum class PyramidStyle {
+    MinMax,  // line through each bucket's min and max in time order (spikes always kept)
+    Mean,    // line through the bucket means
+    Band,    // shaded min..max band under the mean line
+};
+
+// Append-only time series (x non-decreasing) with a pyramid of pre-aggregated levels for plotting at any zoom.
+//
+// Level 1 groups `base_bucket` samples, every further level pairs two buckets of the one below, and levels are
+// added as the series grows. A bucket stores the indices of its min and max sample and the sum of its y values
+// (24 bytes), so level 1 costs 24 / base_bucket bytes per sample and all levels together about 48 / base_bucket,
+// on top of the samples themselves. Appends update only the trailing bucket of each level. Plotting picks the
+// coarsest level that still has at least one bucket per pixel column in the visible x range, so the points handed
+// to ImPlot are bounded by the plot width, not by the length of the data.
+//
+// Appends and plotting may run on different threads; an append waits for a plot call in progress and vice versa.
+class PyramidSeries {
+  public:
+    // `base_bucket` is rounded up to a power of two, at least 2.
+    explicit PyramidSeries(size_t base_bucket = 8);
+
+    PyramidSeries(const PyramidSeries &) = delete;
+    PyramidSeries &operator=(const PyramidSeries &) = delete;
+
+    // Throws std::invalid_argument if x goes backwards; nothing is appended then.
+    auto append(double x, double y) -> void { this->append(&x, &y, 1); }
+    auto append(const double *xs, const double *ys, size_t count) -> void;
+    auto reserve(size_t count) -> void;
+
+    auto size() const -> size_t;
+    // Aggregated levels, not counting the raw samples.
+    auto levels() const -> size_t;
+
+    // The part of the series to draw for x_min..x_max at `pixel_width` columns: `level` 0 is the raw samples
+    // [first, first + count), otherwise buckets [first, first + count) of that level. Includes one neighbour on
+    // each side so lines reach the plot edges.
+    struct Selection {
+        int level{0};
+        size_t first{0};
+        size_t count{0};
+    };
+    auto select(double x_min, double x_max, int pixel_width) const -> Selection;
+
+    // Plots the visible part in the current plot (between ImPlotBeginPlot()/ImPlotEndPlot() or ImPlot::BeginPlot /
+    // EndPlot). While the plot is auto-fitting, the whole series is drawn from the coarsest level instead.
+    auto plot(const char *label, PyramidStyle style = PyramidStyle::MinMax, ImPlotLineFlags flags = 0) const -> void;
+
+  private:
+    struct Bucket {
+        uint64_t imin;  // sample index of the smallest y (first on ties)
+        uint64_t imax;  // sample index of the largest y (first on ties)
+        double sum;
+    };
+
+    // Getter state for one plot call.
+    struct Cursor {
+        const PyramidSeries *series;
+        Selection sel;
+    };
+
+    static auto raw_getter(int idx, void *data) -> ImPlotPoint;
+    static auto minmax_getter(int idx, void *data) -> ImPlotPoint;
+    static auto mean_getter(int idx, void *data) -> ImPlotPoint;
+    static auto low_getter(int idx, void *data) -> ImPlotPoint;
+    static auto high_getter(int idx, void *data) -> ImPlotPoint;
+
+    auto bucket_size(int level) const -> size_t { return this->base_ << (level - 1); }
+    auto bucket_mid_x(int level, size_t bucket) const -> double;
+    auto bucket_mean(int level, size_t bucket) const -> double;
+    auto merge(const Bucket &a, const Bucket &b) const -> Bucket;
+    auto rebuild_from(size_t old_size) -> void;
+    auto select_locked(double x_min, double x_max, int pixel_width) const -> Selection;
+
+    size_t base_;
+    std::vector<double> xs_;
+    std::vector<double> ys_;
+    std::vector<std::vector<Bucket>> levels_;  // levels_[l - 1] is level l
+    mutable std::shared_mutex mutex_;
+};
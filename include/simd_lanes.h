@@ -0,0 +1,150 @@
+#pragma once
+
+// Minimal double-precision lane abstraction so kernels are written once and compiled for AVX2, NEON or plain
+// scalar code, whichever the target enables (Release builds use -march=native).
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace simd {
+
+#if defined(__AVX2__)
+
+struct Lanes {
+    using vec = __m256d;
+    using mask = __m256d;
+    static constexpr size_t width = 4;
+    static constexpr const char *name = "avx2";
+
+    static auto load(const double *p) -> vec { return _mm256_loadu_pd(p); }
+    static auto store(double *p, vec v) -> void { _mm256_storeu_pd(p, v); }
+    static auto set1(double v) -> vec { return _mm256_set1_pd(v); }
+    static auto iota() -> vec { return _mm256_set_pd(3.0, 2.0, 1.0, 0.0); }
+    static auto add(vec a, vec b) -> vec { return _mm256_add_pd(a, b); }
+    static auto mul(vec a, vec b) -> vec { return _mm256_mul_pd(a, b); }
+    static auto min(vec a, vec b) -> vec { return _mm256_min_pd(a, b); }
+    static auto max(vec a, vec b) -> vec { return _mm256_max_pd(a, b); }
+    static auto abs(vec a) -> vec { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static auto lt(vec a, vec b) -> mask { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    // Lane-wise m ? a : b
+    static auto select(mask m, vec a, vec b) -> vec { return _mm256_blendv_pd(b, a, m); }
+};
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+struct Lanes {
+    using vec = float64x2_t;
+    using mask = uint64x2_t;
+    static constexpr size_t width = 2;
+    static constexpr const char *name = "neon";
+
+    static auto load(const double *p) -> vec { return vld1q_f64(p); }
+    static auto store(double *p, vec v) -> void { vst1q_f64(p, v); }
+    static auto set1(double v) -> vec { return vdupq_n_f64(v); }
+    static auto iota() -> vec {
+        const double v[2] = {0.0, 1.0};
+        return vld1q_f64(v);
+    }
+    static auto add(vec a, vec b) -> vec { return vaddq_f64(a, b); }
+    static auto mul(vec a, vec b) -> vec { return vmulq_f64(a, b); }
+    static auto min(vec a, vec b) -> vec { return vminq_f64(a, b); }
+    static auto max(vec a, vec b) -> vec { return vmaxq_f64(a, b); }
+    static auto abs(vec a) -> vec { return vabsq_f64(a); }
+    static auto lt(vec a, vec b) -> mask { return vcltq_f64(a, b); }
+    static auto select(mask m, vec a, vec b) -> vec { return vbslq_f64(m, a, b); }
+};
+
+#else
+
+struct Lanes {
+    using vec = double;
+    using mask = bool;
+    static constexpr size_t width = 1;
+    static constexpr const char *name = "scalar";
+
+    static auto load(const double *p) -> vec { return *p; }
+    static auto store(double *p, vec v) -> void { *p = v; }
+    static auto set1(double v) -> vec { return v; }
+    static auto iota() -> vec { return 0.0; }
+    static auto add(vec a, vec b) -> vec { return a + b; }
+    static auto mul(vec a, vec b) -> vec { return a * b; }
+    static auto min(vec a, vec b) -> vec { return b < a ? b : a; }
+    static auto max(vec a, vec b) -> vec { return a < b ? b : a; }
+    static auto abs(vec a) -> vec { return std::abs(a); }
+    static auto lt(vec a, vec b) -> mask { return a < b; }
+    static auto select(mask m, vec a, vec b) -> vec { return m ? a : b; }
+};
+
+#endif
+
+// Bit i set where p[i] == c, over the 64 bytes at p (which must all be readable). Text scanners use it to find
+// delimiters a block at a time instead of a byte at a time.
+inline auto match_bytes64(const char *p, char c) -> uint64_t {
+#if defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi8(c);
+    const auto lo = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), needle)));
+    const auto hi = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32)), needle)));
+    return static_cast<uint64_t>(lo) | (static_cast<uint64_t>(hi) << 32);
+#elif defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(c);
+    uint64_t bits = 0;
+    for (int i = 0; i < 4; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i));
+        bits |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle))))
+                << (16 * i);
+    }
+    return bits;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    // Each matching byte keeps its bit weight; a horizontal add of distinct weights is their OR.
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t w = vld1q_u8(weights);
+    const uint8x16_t needle = vdupq_n_u8(static_cast<uint8_t>(c));
+    uint64_t bits = 0;
+    for (int i = 0; i < 4; ++i) {
+        const uint8x16_t m = vandq_u8(vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t *>(p + 16 * i)), needle), w);
+        const uint64_t lo = vaddv_u8(vget_low_u8(m));
+        const uint64_t hi = vaddv_u8(vget_high_u8(m));
+        bits |= (lo | (hi << 8)) << (16 * i);
+    }
+    return bits;
+#else
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; ++i)
+        bits |= static_cast<uint64_t>(p[i] == c) << i;
+    return bits;
+#endif
+}
+
+// dst[i] += src[i] for i < n, e.g. merging per-thread histograms.
+inline auto add_u32(uint32_t *dst, const uint32_t *src, size_t n) -> void {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_add_epi32(a, b));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_add_epi32(a, b));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= n; i += 4)
+        vst1q_u32(dst + i, vaddq_u32(vld1q_u32(dst + i), vld1q_u32(src + i)));
+#endif
+    for (; i < n; ++i)
+        dst[i] += src[i];
+}
+
+}  // namespace simd
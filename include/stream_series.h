@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+
+#include <implot.h>
+
+// Producer topology of a StreamSeries. Single is one writer thread, Multi lets any number of threads push.
+enum class StreamProducers { Single, Multi };
+
+// Fixed-capacity ring buffer of (x, y) samples stored as two columns (SoA).
+//
+// Producers push wait-free; the render thread plots the most recent window through an ImPlot getter without
+// locks or copies. Old samples are overwritten once the ring wraps. The newest `headroom` slots before the
+// write cursor are never exposed to readers, so a producer that runs less than `headroom` samples ahead of the
+// render thread per frame cannot overwrite a sample that is being plotted.
+template <class T = double, StreamProducers P = StreamProducers::Single> class StreamSeries {
+    static_assert(std::atomic<T>::is_always_lock_free, "StreamSeries requires lock-free atomics for T");
+    static constexpr size_t kCacheLine = 64;
+
+  public:
+    // A snapshot of the readable window, valid for the current frame.
+    struct Window {
+        const StreamSeries *series{nullptr};
+        uint64_t begin{0};
+        int count{0};
+
+        static auto getter(int idx, void *data) -> ImPlotPoint {
+            const auto *w = static_cast<const Window *>(data);
+            const auto slot = (w->begin + static_cast<uint64_t>(idx)) & w->series->mask_;
+            return ImPlotPoint(static_cast<double>(w->series->xs_[slot].load(std::memory_order_relaxed)),
+                               static_cast<double>(w->series->ys_[slot].load(std::memory_order_relaxed)));
+        }
+    };
+
+    explicit StreamSeries(size_t capacity, size_t headroom = 0)
+        : capacity_(std::bit_ceil(std::max<size_t>(capacity, 2))), mask_(capacity_ - 1),
+          headroom_(headroom ? headroom : capacity_ / 8), xs_(std::make_unique<std::atomic<T>[]>(capacity_)),
+          ys_(std::make_unique<std::atomic<T>[]>(capacity_)) {
+        if (headroom_ >= capacity_) {
+            throw std::invalid_argument("StreamSeries: headroom must be smaller than capacity");
+        }
+        if constexpr (P == StreamProducers::Multi) {
+            seq_ = std::make_unique<std::atomic<uint64_t>[]>(capacity_);
+        }
+    }
+
+    StreamSeries(const StreamSeries &) = delete;
+    StreamSeries &operator=(const StreamSeries &) = delete;
+
+    auto push(T x, T y) noexcept -> void {
+        if constexpr (P == StreamProducers::Single) {
+            const auto idx = head_.load(std::memory_order_relaxed);
+            xs_[idx & mask_].store(x, std::memory_order_relaxed);
+            ys_[idx & mask_].store(y, std::memory_order_relaxed);
+            head_.store(idx + 1, std::memory_order_release);
+        } else {
+            const auto idx = reserve_.fetch_add(1, std::memory_order_relaxed);
+            xs_[idx & mask_].store(x, std::memory_order_relaxed);
+            ys_[idx & mask_].store(y, std::memory_order_relaxed);
+            seq_[idx & mask_].store(idx + 1, std::memory_order_release);
+        }
+    }
+
+    // Pushes min(xs.size(), ys.size()) samples. With multiple producers the batch occupies a contiguous range.
+    auto push(std::span<const T> xs, std::span<const T> ys) noexcept -> void {
+        const auto n = std::min(xs.size(), ys.size());
+        if (n == 0)
+            return;
+        if constexpr (P == StreamProducers::Single) {
+            const auto idx = head_.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < n; ++i) {
+                xs_[(idx + i) & mask_].store(xs[i], std::memory_order_relaxed);
+                ys_[(idx + i) & mask_].store(ys[i], std::memory_order_relaxed);
+            }
+            head_.store(idx + n, std::memory_order_release);
+        } else {
+            const auto idx = reserve_.fetch_add(n, std::memory_order_relaxed);
+            for (size_t i = 0; i < n; ++i) {
+                xs_[(idx + i) & mask_].store(xs[i], std::memory_order_relaxed);
+                ys_[(idx + i) & mask_].store(ys[i], std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                seq_[(idx + i) & mask_].store(idx + i + 1, std::memory_order_release);
+            }
+        }
+    }
+
+    auto capacity() const noexcept -> size_t { return capacity_; }
+    auto headroom() const noexcept -> size_t { return headroom_; }
+
+    // Total number of samples published so far (monotonic, never wraps in practice).
+    auto published() const noexcept -> uint64_t {
+        if constexpr (P == StreamProducers::Single) {
+            return head_.load(std::memory_order_acquire);
+        } else {
+            return advance_published();
+        }
+    }
+
+    // Number of samples a reader may currently see.
+    auto size() const noexcept -> size_t {
+        return static_cast<size_t>(std::min<uint64_t>(published(), capacity_ - headroom_));
+    }
+
+    // Snapshot of the newest `max_count` readable samples (all readable samples when 0).
+    auto window(size_t max_count = 0) const noexcept -> Window {
+        const auto end = published();
+        auto n = std::min<uint64_t>(end, capacity_ - headroom_);
+        if (max_count)
+            n = std::min<uint64_t>(n, max_count);
+        n = std::min<uint64_t>(n, static_cast<uint64_t>(INT32_MAX));
+        return Window{this, end - n, static_cast<int>(n)};
+    }
+
+    // Plots the newest `max_count` samples. Must be called between ImPlot::BeginPlot / EndPlot.
+    auto plot_line(const char *label, size_t max_count = 0, ImPlotLineFlags flags = 0) const -> void {
+        auto w = this->window(max_count);
+        ImPlot::PlotLineG(label, &Window::getter, &w, w.count, flags);
+    }
+
+    auto plot_scatter(const char *label, size_t max_count = 0, ImPlotScatterFlags flags = 0) const -> void {
+        auto w = this->window(max_count);
+        ImPlot::PlotScatterG(label, &Window::getter, &w, w.count, flags);
+    }
+
+  private:
+    // Extends the published prefix over every slot whose sequence stamp shows it has been written. Slots that a
+    // producer reserved but has not yet stamped stop the scan; slots already lapped by newer writes are skipped.
+    auto advance_published() const noexcept -> uint64_t {
+        auto pos = head_.load(std::memory_order_acquire);
+        const auto reserved = reserve_.load(std::memory_order_relaxed);
+        if (reserved > pos + capacity_) {
+            pos = reserved - capacity_;
+        }
+        while (pos < reserved) {
+            const auto seq = seq_[pos & mask_].load(std::memory_order_acquire);
+            if (seq < pos + 1)
+                break;
+            ++pos;
+        }
+        auto cur = head_.load(std::memory_order_relaxed);
+        while (cur < pos && !head_.compare_exchange_weak(cur, pos, std::memory_order_release,
+                                                         std::memory_order_relaxed)) {
+        }
+        return std::max(cur, pos);
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    const size_t headroom_;
+    std::unique_ptr<std::atomic<T>[]> xs_;
+    std::unique_ptr<std::atomic<T>[]> ys_;
+    std::unique_ptr<std::atomic<uint64_t>[]> seq_;
+
+    // Single: write cursor owned by the producer. Multi: published prefix, advanced by readers.
+    alignas(kCacheLine) mutable std::atomic<uint64_t> head_{0};
+    alignas(kCacheLine) std::atomic<uint64_t> reserve_{0};
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+class ThreadPool;
+
+// A set of tasks that can be waited on together. The first exception thrown by a task is rethrown by wait().
+class TaskGroup {
+  public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    auto pending() const -> bool { return this->pending_.load(std::memory_order_acquire) != 0; }
+
+  private:
+    friend class ThreadPool;
+
+    std::atomic<uint32_t> pending_{0};
+    std::mutex errorMutex_;
+    std::exception_ptr error_;
+};
+
+// Work-stealing pool. Each worker pops from the back of its own deque and steals from the front of the others
+// when it runs dry; tasks submitted from outside are spread round-robin. A thread waiting on a group runs queued
+// tasks instead of blocking, so waiting from inside a task cannot deadlock the pool.
+class ThreadPool {
+  public:
+    explicit ThreadPool(unsigned threads = 0);  // 0 = hardware threads - 1 (at least 1)
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Process-wide pool shared by every engine, so several windows do not oversubscribe the cores.
+    static auto shared() -> ThreadPool &;
+
+    auto size() const -> unsigned { return (unsigned)this->workers_.size(); }
+    auto submit(TaskGroup &group, std::move_only_function<void()> fn) -> void;
+    auto wait(TaskGroup &group) -> void;
+
+  private:
+    struct Task {
+        std::move_only_function<void()> fn;
+        TaskGroup *group;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    auto run(unsigned self, std::stop_token st) -> void;
+    auto try_pop(unsigned self, Task &out) -> bool;
+    auto execute(Task &task) -> void;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::jthread> threads_;
+    std::atomic<uint32_t> next_{0};
+    std::atomic<uint32_t> queued_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable_any sleepCv_;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Host allocations of one VkSystemAllocationScope. Bytes are as requested by the driver, without padding.
+struct VulkanHostScopeStats {
+    uint64_t live_bytes = 0;
+    uint64_t live_count = 0;
+    uint64_t peak_bytes = 0;
+    uint64_t total_count = 0;     // allocations + reallocations since start-up, i.e. churn
+    uint64_t internal_bytes = 0;  // reported through pfnInternalAllocation (driver-side, not ours)
+};
+
+struct VulkanHostAllocStats {
+    static constexpr int kScopes = 5;  // VK_SYSTEM_ALLOCATION_SCOPE_COMMAND .. _INSTANCE
+
+    VulkanHostScopeStats scopes[kScopes];
+    uint64_t live_bytes = 0;
+    uint64_t live_count = 0;
+    uint64_t peak_bytes = 0;
+    uint64_t total_count = 0;
+    uint64_t large_count = 0;   // live allocations too big for the pools
+    uint64_t pooled_bytes = 0;  // slab memory held by the pools, used or free
+};
+
+// VkAllocationCallbacks for the shared instance/device. Small allocations (up to kMaxClass with alignment and
+// header) come from power-of-two size classes carved out of 64 KiB slabs; every VkSystemAllocationScope has its own
+// arena, so short-lived command-scope churn never fragments long-lived object memory, and blocks are recycled
+// instead of going back to malloc, which keeps swapchain rebuild storms off the system allocator. Slabs are kept
+// until the allocator is destroyed. Callbacks are thread-safe; counters are readable at any time.
+class VulkanHostAllocator final {
+  public:
+    static constexpr size_t kSlabSize = 64 * 1024;
+    static constexpr size_t kMinClass = 32;
+    static constexpr size_t kMaxClass = 4096;  // slabs are aligned to this, so a block is aligned to its own size
+    static constexpr int kClasses = 8;         // 32, 64, ..., 4096
+
+    VulkanHostAllocator();
+    ~VulkanHostAllocator();
+
+    VulkanHostAllocator(const VulkanHostAllocator &) = delete;
+    VulkanHostAllocator &operator=(const VulkanHostAllocator &) = delete;
+
+    auto callbacks() -> VkAllocationCallbacks * { return &this->callbacks_; }
+    auto stats() const -> VulkanHostAllocStats;
+
+  private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct Arena {
+        std::mutex mutex;
+        FreeBlock *free[kClasses] = {};
+        char *bump[kClasses] = {};
+        char *bumpEnd[kClasses] = {};
+        std::vector<void *> slabs;
+    };
+
+    struct Counters {
+        std::atomic<uint64_t> liveBytes{0};
+        std::atomic<uint64_t> liveCount{0};
+        std::atomic<uint64_t> peakBytes{0};
+        std::atomic<uint64_t> totalCount{0};
+        std::atomic<uint64_t> internalBytes{0};
+    };
+
+    static VKAPI_ATTR void *VKAPI_CALL Allocate(void *user, size_t size, size_t alignment,
+                                                VkSystemAllocationScope scope);
+    static VKAPI_ATTR void *VKAPI_CALL Reallocate(void *user, void *original, size_t size, size_t alignment,
+                                                  VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL Free(void *user, void *memory);
+    static VKAPI_ATTR void VKAPI_CALL InternalAllocate(void *user, size_t size, VkInternalAllocationType type,
+                                                       VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL InternalFree(void *user, size_t size, VkInternalAllocationType type,
+                                                   VkSystemAllocationScope scope);
+
+    auto allocate(size_t size, size_t alignment, int scope) -> void *;
+    auto release(void *memory) -> void;
+    auto pop(Arena &arena, int cls) -> void *;
+    auto count_alloc(int scope, size_t size) -> void;
+    auto count_free(int scope, size_t size) -> void;
+
+    VkAllocationCallbacks callbacks_ = {};
+    Arena arenas_[VulkanHostAllocStats::kScopes];
+    Counters scopes_[VulkanHostAllocStats::kScopes];
+    Counters total_;
+    std::atomic<uint64_t> largeCount_{0};
+    std::atomic<uint64_t> pooledBytes_{0};
+};
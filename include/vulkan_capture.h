@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vulkan_helper.h"
+
+enum class FrameCaptureFormat : uint8_t {
+    Y4M,  // YUV4MPEG2, 4:2:0 BT.601 limited range; plays in ffplay/mpv, encodes with ffmpeg -i capture.y4m
+    Raw,  // headerless RGBA8 frames back to back, FrameCaptureStats::width x height each
+};
+
+struct FrameCaptureOptions {
+    FrameCaptureFormat format = FrameCaptureFormat::Y4M;
+    uint32_t ring_size = 3;  // staging buffers; a frame is dropped when none is free
+    uint32_t fps = 60;       // written to the Y4M header only; frames are stored as rendered
+};
+
+struct FrameCaptureStats {
+    uint32_t width = 0;            // of the first captured frame; later frames of another size are skipped
+    uint32_t height = 0;
+    uint64_t frames_captured = 0;  // copies recorded into a staging buffer
+    uint64_t frames_written = 0;
+    uint64_t frames_dropped = 0;   // every staging buffer was still busy (GPU copy or writer behind)
+    uint64_t frames_skipped = 0;   // size changed or unsupported format
+    uint64_t bytes_written = 0;
+    double record_ms = 0.0;        // render thread, total: collecting finished copies, recording, fence submits
+    double record_ms_max = 0.0;    // worst single call of the above
+    double encode_ms = 0.0;        // writer thread, total: colour conversion and file writes
+    bool failed = false;           // the file could not be written; nothing more is captured
+};
+
+// Records rendered frames to a video file without stalling the frame loop.
+//
+// record() appends a copy of the frame's colour image into the next of a ring of persistently mapped,
+// host-visible staging buffers to the frame's own command buffer; submitted() follows the frame's vkQueueSubmit
+// with an empty submit that signals the buffer's fence. Later frames poll those fences without waiting and hand
+// finished buffers, in order, to a writer thread that converts and writes them. If the next buffer is still on
+// the GPU or with the writer the frame is dropped, never waited for. Render-thread methods must not run
+// concurrently with each other or with close().
+class VulkanFrameCapture {
+  public:
+    // Throws std::runtime_error if `path` cannot be opened.
+    VulkanFrameCapture(VulkanHelper *vk, const std::string &path, FrameCaptureOptions options = {});
+    ~VulkanFrameCapture();
+
+    VulkanFrameCapture(const VulkanFrameCapture &) = delete;
+    VulkanFrameCapture &operator=(const VulkanFrameCapture &) = delete;
+
+    // Render thread: `image` (B8G8R8A8 or R8G8B8A8) is in `layout` after the render pass, and is left in it.
+    // Returns false if the frame is not captured.
+    auto record(VkCommandBuffer cmd, VkImage image, VkImageLayout layout, VkFormat format, uint32_t width,
+                uint32_t height) -> bool;
+    // Render thread, right after the frame was submitted to `queue` and with the queue's lock held.
+    auto submitted(VkQueue queue) -> void;
+
+    // Waits for the copies in flight, writes them and closes the file. Also done by the destructor.
+    auto close() -> void;
+
+    auto stats() const -> FrameCaptureStats;
+
+  private:
+    enum class SlotState : uint8_t { Free, Recorded, InFlight, Queued };
+
+    struct Slot {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        const uint8_t *mapped = nullptr;
+        VkFence fence = VK_NULL_HANDLE;
+        std::atomic<SlotState> state{SlotState::Free};
+    };
+
+    auto create_slots() -> void;
+    auto collect(bool wait) -> void;
+    auto write_loop(std::stop_token st) -> void;
+    auto write_frame(const Slot &slot) -> void;
+    auto note_record_time(double ms) -> void;
+
+    VulkanHelper *vk_;
+    FrameCaptureOptions options_;
+    std::ofstream file_;
+    // Fixed by the first frame; published to the writer with the first queued slot.
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    bool bgra_ = false;
+    VkDeviceSize frameBytes_ = 0;
+    bool coherent_ = true;
+    std::unique_ptr<Slot[]> slots_;
+    uint32_t slotCount_;
+    uint32_t next_ = 0;          // render thread: slot for the next record()
+    uint32_t collect_ = 0;       // render thread: oldest slot that may be in flight
+    int recorded_ = -1;          // render thread: slot waiting for submitted()
+
+    mutable std::mutex mutex_;   // queue_, stats_
+    std::condition_variable_any queued_;
+    std::deque<uint32_t> queue_;
+    FrameCaptureStats stats_;
+    std::atomic<bool> failed_{false};
+
+    bool closed_ = false;
+
+    // Writer thread only.
+    std::vector<uint8_t> scratch_;  // converted frame
+    bool headerWritten_ = false;
+
+    std::jthread writer_;  // last: joined before the members it uses go away
+};
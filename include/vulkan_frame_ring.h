@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkan_helper.h"
+
+struct VulkanFrameSlot {
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;              // signaled by the slot's last submission
+    VkSemaphore imageAcquired = VK_NULL_HANDLE;  // swapchain rings only
+};
+
+// Command recording resources for a fixed number of frames in flight, independent of how many images the render
+// target has. The CPU records frame N+1 into the next slot while the GPU still executes frame N; it only waits when
+// it comes back around to a slot whose frame the GPU has not finished.
+//
+// A ring created with `images` > 0 also keeps the swapchain-side state: one render-complete semaphore per image
+// (the present of an image waits on it, so it is reused only once that image is acquired again) and which slot
+// last rendered each image, since acquisition order need not follow the ring.
+class VulkanFrameRing final {
+  public:
+    static constexpr uint32_t kMaxFrames = 4;
+
+    VulkanFrameRing() = default;
+    ~VulkanFrameRing() = default;
+
+    auto Create(VulkanHelper *vk, uint32_t frames, uint32_t images = 0) -> void;
+    // The GPU must be done with every slot.
+    auto Destroy() -> void;
+    auto Created() const -> bool { return !this->slots_.empty(); }
+
+    auto FrameCount() const -> uint32_t { return static_cast<uint32_t>(this->slots_.size()); }
+    auto Index() const -> uint32_t { return this->index_; }
+    auto Current() -> VulkanFrameSlot & { return this->slots_[this->index_]; }
+    // Moves to the next slot and waits until the GPU finished the frame last recorded into it.
+    auto Next() -> VulkanFrameSlot &;
+    // Waits until the GPU finished every submitted frame.
+    auto WaitIdle() -> void;
+    // Submitted frames the GPU has not finished yet, by polling their fences.
+    auto Pending() const -> uint32_t;
+
+    // Swapchain rings: waits for the frame that last rendered `image` if the GPU still has it, then records that
+    // the current slot renders it.
+    auto ClaimImage(uint32_t image) -> void;
+    auto RenderComplete(uint32_t image) const -> VkSemaphore { return this->renderComplete_[image]; }
+
+  private:
+    VulkanHelper *vk_ = nullptr;
+    std::vector<VulkanFrameSlot> slots_;
+    uint32_t index_ = 0;
+    std::vector<VkSemaphore> renderComplete_;  // per swapchain image
+    std::vector<VkFence> imageFences_;         // per swapchain image: fence of the slot that last rendered it
+};
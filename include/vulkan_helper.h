@@ -1,6 +1,14 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "vulkan_allocator.h"
 
 struct VulkanData {
     VkAllocationCallbacks *allocator = nullptr;
@@ -10,21 +18,84 @@ struct VulkanData {
     uint32_t queueFamily = UINT32_MAX;
     VkQueue queue = VK_NULL_HANDLE;
     VkPipelineCache pipelineCache = VK_NULL_HANDLE;
-    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
 
     // Default constructor
     VulkanData() noexcept = default;
 };
 
+// Device bring-up timings, for comparing cold and warm starts (e.g. many viewers restarting at once).
+struct VulkanStartupStats {
+    double instance_ms = 0.0;
+    double device_ms = 0.0;
+    double pipeline_cache_load_ms = 0.0;
+    size_t pipeline_cache_bytes = 0;  // seeded from disk; 0 on a cold or rejected cache
+    bool pipeline_cache_hit = false;
+};
+
+// A device queue handed out to one engine. When there are more engines than queues in the family, queues are
+// shared round-robin, so every submit, present and queue wait goes through `mutex`.
+struct VulkanQueue {
+    VkQueue queue = VK_NULL_HANDLE;
+    std::mutex *mutex = nullptr;
+};
+
 class VulkanHelper final {
   public:
+    static constexpr uint32_t kMaxQueues = 4;
+
     VulkanHelper() = default;
     ~VulkanHelper() = default;
 
+    // Process-wide instance/device shared by every engine; destroyed when the last holder releases it. The first
+    // caller fixes the instance extensions and whether the device is headless; a later caller that needs more
+    // than that gets std::runtime_error.
+    static auto Acquire(const ImVector<const char *> &instance_extensions, bool headless = false)
+        -> std::shared_ptr<VulkanHelper>;
+
     static auto check_vk_result(VkResult err) -> void;
     auto IsExtensionAvailable(const ImVector<VkExtensionProperties> &properties, const char *extension) -> bool;
-    auto Setup(ImVector<const char *> instance_extensions) -> void;
+    // `headless` skips the swapchain device extension so the device can be created without any surface support.
+    auto Setup(ImVector<const char *> instance_extensions, bool headless = false) -> void;
     auto Cleanup() -> void;
+    auto FindMemoryType(uint32_t type_bits, VkMemoryPropertyFlags properties) const -> uint32_t;
+
+    auto AcquireQueue() -> VulkanQueue;
+    // Locks every queue, for calls that wait on the whole device (vkDeviceWaitIdle inside the ImGui helpers).
+    auto LockQueues() -> std::vector<std::unique_lock<std::mutex>>;
+    // Descriptor pools are externally synchronized, so each ImGui context allocates from its own.
+    auto CreateDescriptorPool() -> VkDescriptorPool;
+    auto DestroyDescriptorPool(VkDescriptorPool pool) -> void;
+
+    // On-disk VkPipelineCache. Setup() seeds the cache from it when it was written by the same device and driver,
+    // Cleanup() writes it back. Defaults to $IMPLOT_UTIL_PIPELINE_CACHE, else
+    // $XDG_CACHE_HOME (or ~/.cache)/implot_util/pipeline_cache.bin; an empty path disables it. Set before Acquire().
+    static auto SetPipelineCachePath(std::string path) -> void;
+    static auto PipelineCachePath() -> std::string;
+
+    // Routes the instance's and device's host allocations through a VulkanHostAllocator (data.allocator), so they
+    // can be counted per scope. On by default; set before Acquire().
+    static auto SetHostAllocatorEnabled(bool enabled) -> void;
+    // All zero when the host allocator is disabled.
+    auto HostAllocStats() const -> VulkanHostAllocStats;
+
+    // True if the backend will upload textures (vkQueueSubmit on its init queue) while recording `draw_data`.
+    static auto TexturesPending(const ImDrawData *draw_data) -> bool;
 
     VulkanData data;
-};
\ No newline at end of file
+    VulkanStartupStats startup;
+    // Optional device features Setup() enabled because the device has them: largePoints.
+    VkPhysicalDeviceFeatures features = {};
+
+  private:
+    auto LoadPipelineCache() -> void;
+    auto SavePipelineCache() -> void;
+
+    bool headless_ = false;
+    std::vector<std::string> instanceExtensions_;
+    std::vector<VkQueue> queues_;
+    std::unique_ptr<std::mutex[]> queueMutexes_;
+    std::atomic<uint32_t> nextQueue_{0};
+    std::string pipelineCachePath_;
+    uint64_t pipelineCacheHash_ = 0;  // of the data seeded from disk, to skip rewriting an unchanged cache
+    std::unique_ptr<VulkanHostAllocator> hostAllocator_;  // outlives every object created with data.allocator
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkan_frame_ring.h"
+#include "vulkan_helper.h"
+
+class GpuFrameTimer;
+class VulkanFrameCapture;
+
+// Single-image render target used instead of a swapchain when the engine runs headless. Rendering goes into a
+// device-local RGBA8 image; a copy into a host-visible buffer is recorded only for frames that are read back.
+// Frames are recorded through a VulkanFrameRing, so with more than one frame in flight Render() returns without
+// waiting for the previous frame; the render pass orders the frames' writes to the image.
+// A frame capture, if given, gets its own copy of every frame; a GPU timer, its render pass timed in the frame's
+// ring slot.
+class VulkanOffscreen final {
+  public:
+    VulkanOffscreen() = default;
+    ~VulkanOffscreen() = default;
+
+    auto Create(VulkanHelper *vk, VulkanQueue queue, uint32_t width, uint32_t height, uint32_t frames_in_flight = 2)
+        -> void;
+    auto Destroy() -> void;
+    // Waits for the GPU, then rebuilds the frame ring.
+    auto SetFramesInFlight(uint32_t frames) -> void;
+    auto FramesInFlight() const -> uint32_t { return this->frames_.FrameCount(); }
+    auto FrameIndex() const -> uint32_t { return this->frames_.Index(); }
+    auto Pending() const -> uint32_t { return this->frames_.Pending(); }
+    auto Render(ImDrawData *draw_data, const VkClearValue &clear, bool readback,
+                VulkanFrameCapture *capture = nullptr, GpuFrameTimer *timer = nullptr, uint64_t timer_tag = 0)
+        -> void;
+    // Waits for the last submitted frame and copies its pixels (tightly packed RGBA8 rows) into `rgba`.
+    // Returns false if that frame was not rendered with readback enabled.
+    auto Readback(std::vector<uint8_t> &rgba) -> bool;
+    // Waits for every frame in flight.
+    auto Wait() -> void;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+    VkImage image = VK_NULL_HANDLE;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+  private:
+    VulkanHelper *vk_ = nullptr;
+    VulkanQueue queue_;
+    VkDeviceMemory imageMemory_ = VK_NULL_HANDLE;
+    VkImageView imageView_ = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer_ = VK_NULL_HANDLE;
+    VulkanFrameRing frames_;
+    VkBuffer readbackBuffer_ = VK_NULL_HANDLE;
+    VkDeviceMemory readbackMemory_ = VK_NULL_HANDLE;
+    void *readbackMapped_ = nullptr;
+    bool readbackCoherent_ = true;
+    bool readbackPending_ = false;
+};
@@ -0,0 +1,20 @@
+#version 450 core
+
+// GPU-resident series: positions are stored relative to the series origin, the plot-to-NDC affine transform
+// arrives as push constants so panning and zooming never touch the vertex buffer.
+layout(location = 0) in vec2 aPos;
+
+layout(push_constant) uniform PushConstants {
+    vec2 scale;
+    vec2 offset;
+    vec4 color;
+    float pointSize;
+} pc;
+
+layout(location = 0) out vec4 vColor;
+
+void main() {
+    gl_Position = vec4(aPos * pc.scale + pc.offset, 0.0, 1.0);
+    gl_PointSize = pc.pointSize;
+    vColor = pc.color;
+}
@@ -0,0 +1,364 @@
+#include "csv_loader.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "simd_lanes.h"
+#include "thread_pool.h"
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+auto is_blank(char c) -> bool { return c == ' ' || c == '\t' || c == '\r'; }
+
+auto parse_number(const char *begin, const char *end) -> double {
+    while (begin < end && is_blank(*begin))
+        ++begin;
+    while (end > begin && is_blank(end[-1]))
+        --end;
+    if (begin < end && *begin == '+')
+        ++begin;
+    double v;
+    const auto [ptr, ec] = std::from_chars(begin, end, v);
+    return ec == std::errc() && ptr == end && begin < end ? v : kNaN;
+}
+
+// Splits one line into fields, honouring quotes ("" inside quotes is a literal quote).
+auto split_quoted(const char *begin, const char *end, char delimiter) -> std::vector<std::string> {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (const char *p = begin; p < end; ++p) {
+        if (quoted) {
+            if (*p == '"' && p + 1 < end && p[1] == '"')
+                fields.back() += *p++;
+            else if (*p == '"')
+                quoted = false;
+            else
+                fields.back() += *p;
+        } else if (*p == '"') {
+            quoted = true;
+        } else if (*p == delimiter) {
+            fields.emplace_back();
+        } else if (*p != '\r') {
+            fields.back() += *p;
+        }
+    }
+    return fields;
+}
+
+// Row assembly shared by the fast and the quoted parser.
+struct RowBuilder {
+    CsvChunk &chunk;
+    size_t column = 0;
+
+    auto field(double v) -> void {
+        if (this->column < this->chunk.columns.size())
+            this->chunk.columns[this->column].push_back(v);
+        ++this->column;
+    }
+
+    auto end_row() -> void {
+        for (; this->column < this->chunk.columns.size(); ++this->column)
+            this->chunk.columns[this->column].push_back(kNaN);
+        ++this->chunk.rows;
+        this->column = 0;
+    }
+};
+
+// Lines with quotes, one at a time.
+auto parse_quoted(const char *begin, const char *end, char delimiter, RowBuilder &row) -> void {
+    while (begin < end) {
+        const char *eol = static_cast<const char *>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+        if (!eol)
+            eol = end;
+        if (eol > begin && !(eol == begin + 1 && *begin == '\r')) {
+            for (const std::string &f : split_quoted(begin, eol, delimiter))
+                row.field(parse_number(f.data(), f.data() + f.size()));
+            row.end_row();
+        }
+        begin = eol + 1;
+    }
+}
+
+auto parse_chunk(const char *begin, const char *end, size_t columns, char delimiter) -> CsvChunk {
+    CsvChunk chunk;
+    chunk.columns.resize(columns);
+    const size_t guess = static_cast<size_t>(end - begin) / std::max<size_t>(columns * 6, 1);
+    for (auto &c : chunk.columns)
+        c.reserve(guess);
+    RowBuilder row{chunk};
+
+    if (std::memchr(begin, '"', static_cast<size_t>(end - begin))) {
+        parse_quoted(begin, end, delimiter, row);
+        return chunk;
+    }
+
+    const char *field = begin;
+    auto structural = [&](const char *at) {
+        if (*at == '\n') {
+            // Blank lines (including a lone \r) are skipped rather than read as a row of NaN.
+            if (row.column == 0 && (at == field || (at == field + 1 && *field == '\r'))) {
+                field = at + 1;
+                return;
+            }
+            row.field(parse_number(field, at));
+            row.end_row();
+        } else {
+            row.field(parse_number(field, at));
+        }
+        field = at + 1;
+    };
+
+    const char *p = begin;
+    for (; end - p >= 64; p += 64) {
+        uint64_t bits = simd::match_bytes64(p, delimiter) | simd::match_bytes64(p, '\n');
+        while (bits) {
+            structural(p + std::countr_zero(bits));
+            bits &= bits - 1;
+        }
+    }
+    for (; p < end; ++p)
+        if (*p == delimiter || *p == '\n')
+            structural(p);
+    if (field < end || row.column > 0) {
+        // Last line without a line break.
+        const char *stop = end;
+        if (!(row.column == 0 && stop == field + 1 && *field == '\r')) {
+            row.field(parse_number(field, stop));
+            row.end_row();
+        }
+    }
+    return chunk;
+}
+
+// Parsing stays off ThreadPool::shared(): the render thread helps out with queued tasks while it waits for its
+// drawers there, and a 4 MiB parse task would stall its frame.
+auto ingest_pool() -> ThreadPool & {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency() / 2));
+    return pool;
+}
+
+struct Mapping {
+    void *data = MAP_FAILED;
+    size_t size = 0;
+
+    ~Mapping() {
+        if (this->data != MAP_FAILED)
+            ::munmap(this->data, this->size);
+    }
+};
+
+}  // namespace
+
+auto CsvTable::find(const std::string &name) const -> int {
+    for (size_t c = 0; c < this->names_.size(); ++c)
+        if (this->names_[c] == name)
+            return static_cast<int>(c);
+    return -1;
+}
+
+auto CsvTable::chunk_of(size_t row, size_t hint) const -> size_t {
+    if (hint < this->offsets_.size() && row < this->offsets_[hint] &&
+        (hint == 0 || row >= this->offsets_[hint - 1]))
+        return hint;
+    return static_cast<size_t>(std::upper_bound(this->offsets_.begin(), this->offsets_.end(), row) -
+                               this->offsets_.begin());
+}
+
+auto CsvTable::value(int column, size_t row) const -> double {
+    const size_t c = this->chunk_of(row, 0);
+    const size_t first = c == 0 ? 0 : this->offsets_[c - 1];
+    return this->chunks_[c]->columns[column][row - first];
+}
+
+auto CsvTable::getter(int idx, void *data) -> ImPlotPoint {
+    auto *cursor = static_cast<Cursor *>(data);
+    const CsvTable &t = *cursor->table;
+    const auto row = static_cast<size_t>(idx);
+    cursor->chunk = t.chunk_of(row, cursor->chunk);
+    const CsvChunk &chunk = *t.chunks_[cursor->chunk];
+    const size_t local = row - (cursor->chunk == 0 ? 0 : t.offsets_[cursor->chunk - 1]);
+    return ImPlotPoint(chunk.columns[cursor->x][local], chunk.columns[cursor->y][local]);
+}
+
+auto CsvTable::plot_line(const char *label, int x, int y, ImPlotLineFlags flags) const -> void {
+    Cursor cursor{this, x, y, 0};
+    ImPlot::PlotLineG(label, &getter, &cursor, static_cast<int>(std::min<size_t>(this->rows(), INT_MAX)), flags);
+}
+
+CsvLoader::CsvLoader(std::string path, CsvOptions options, std::stop_token stop)
+    : path_(std::move(path)), options_(std::move(options)), start_(std::chrono::steady_clock::now()),
+      table_(std::make_shared<CsvTable>()) {
+    this->thread_ = std::jthread([this](std::stop_token st) { this->run(st); });
+    if (stop.stop_possible())
+        this->stopForward_.emplace(std::move(stop), std::function<void()>([this] { this->thread_.request_stop(); }));
+}
+
+CsvLoader::~CsvLoader() {
+    this->stopForward_.reset();
+    this->thread_.request_stop();
+}
+
+auto CsvLoader::table() const -> std::shared_ptr<const CsvTable> {
+    std::scoped_lock lock(this->mutex_);
+    return this->table_;
+}
+
+auto CsvLoader::error() const -> std::string {
+    std::scoped_lock lock(this->mutex_);
+    return this->error_;
+}
+
+auto CsvLoader::wait() const -> void {
+    std::unique_lock lock(this->mutex_);
+    this->done_.wait(lock, [this] { return this->state() != CsvLoadState::Loading; });
+}
+
+auto CsvLoader::throughput_mb_s() const -> double {
+    auto elapsed = this->elapsed_.load(std::memory_order_acquire);
+    if (this->state() == CsvLoadState::Loading)
+        elapsed = (std::chrono::steady_clock::now() - this->start_).count();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::duration(elapsed)).count();
+    return seconds > 0.0 ? static_cast<double>(this->bytes_done()) / 1e6 / seconds : 0.0;
+}
+
+// Copy-on-write: the render thread keeps whatever table it already holds.
+auto CsvLoader::publish(std::shared_ptr<const CsvChunk> chunk, uint64_t bytes) -> void {
+    if (chunk->rows > 0) {
+        std::scoped_lock lock(this->mutex_);
+        auto next = std::make_shared<CsvTable>(*this->table_);
+        next->offsets_.push_back(next->rows() + chunk->rows);
+        next->chunks_.push_back(std::move(chunk));
+        this->table_ = std::move(next);
+    }
+    this->bytesDone_.fetch_add(bytes, std::memory_order_relaxed);
+    if (this->options_.on_publish)
+        this->options_.on_publish();
+}
+
+auto CsvLoader::finish(CsvLoadState state, std::string error) -> void {
+    this->elapsed_.store((std::chrono::steady_clock::now() - this->start_).count(), std::memory_order_release);
+    {
+        std::scoped_lock lock(this->mutex_);
+        this->error_ = std::move(error);
+        this->state_.store(state, std::memory_order_release);
+    }
+    this->done_.notify_all();
+}
+
+auto CsvLoader::run(std::stop_token st) -> void {
+    Mapping map;
+    {
+        const int fd = ::open(this->path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return this->finish(CsvLoadState::Failed, "cannot open " + this->path_ + ": " + std::strerror(errno));
+        struct stat sb;
+        if (::fstat(fd, &sb) == 0 && sb.st_size > 0) {
+            map.size = static_cast<size_t>(sb.st_size);
+            map.data = ::mmap(nullptr, map.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        const int err = errno;
+        ::close(fd);
+        if (map.size == 0)
+            return this->finish(CsvLoadState::Done);
+        if (map.data == MAP_FAILED)
+            return this->finish(CsvLoadState::Failed, "cannot map " + this->path_ + ": " + std::strerror(err));
+        ::madvise(map.data, map.size, MADV_SEQUENTIAL);
+    }
+    this->bytesTotal_.store(map.size, std::memory_order_relaxed);
+
+    const char *text = static_cast<const char *>(map.data);
+    const char *const text_end = text + map.size;
+    auto line_end = [&](const char *from) {
+        const auto *eol = static_cast<const char *>(std::memchr(from, '\n', static_cast<size_t>(text_end - from)));
+        return eol ? eol + 1 : text_end;
+    };
+
+    // Column names from the first line.
+    const char *pos = text;
+    {
+        const char *first_end = line_end(text);
+        std::vector<std::string> fields =
+            split_quoted(text, first_end - (first_end[-1] == '\n'), this->options_.delimiter);
+        auto table = std::make_shared<CsvTable>();
+        for (size_t c = 0; c < fields.size(); ++c) {
+            std::string name = this->options_.header ? fields[c] : "c" + std::to_string(c);
+            while (!name.empty() && is_blank(name.back()))
+                name.pop_back();
+            name.erase(0, std::min(name.find_first_not_of(" \t"), name.size()));
+            table->names_.push_back(std::move(name));
+        }
+        std::scoped_lock lock(this->mutex_);
+        this->table_ = std::move(table);
+        if (this->options_.header) {
+            this->bytesDone_.store(static_cast<uint64_t>(first_end - text), std::memory_order_relaxed);
+            pos = first_end;
+        }
+    }
+    const size_t columns = this->table_->names_.size();
+
+    ThreadPool &pool = this->options_.pool ? *this->options_.pool : ingest_pool();
+    const size_t max_in_flight = 2 * static_cast<size_t>(pool.size()) + 1;
+    const size_t chunk_bytes = std::max<size_t>(this->options_.chunk_bytes, 64 * 1024);
+
+    struct Pending {
+        std::unique_ptr<TaskGroup> group;
+        std::shared_ptr<CsvChunk> result;
+        uint64_t bytes;
+    };
+    std::deque<Pending> in_flight;
+    std::string error;
+
+    while (!st.stop_requested() && (pos < text_end || !in_flight.empty())) {
+        // Keep a bounded window of chunks in flight; they are published strictly in file order.
+        while (pos < text_end && in_flight.size() < max_in_flight) {
+            const char *end =
+                static_cast<size_t>(text_end - pos) > chunk_bytes ? line_end(pos + chunk_bytes) : text_end;
+            Pending p{std::make_unique<TaskGroup>(), std::make_shared<CsvChunk>(), static_cast<uint64_t>(end - pos)};
+            pool.submit(*p.group, [out = p.result, pos, end, columns, delimiter = this->options_.delimiter, st] {
+                if (!st.stop_requested())
+                    *out = parse_chunk(pos, end, columns, delimiter);
+            });
+            in_flight.push_back(std::move(p));
+            pos = end;
+        }
+        Pending &front = in_flight.front();
+        try {
+            pool.wait(*front.group);
+        } catch (const std::exception &e) {
+            error = e.what();
+            break;
+        }
+        if (!st.stop_requested())
+            this->publish(std::move(front.result), front.bytes);
+        in_flight.pop_front();
+    }
+
+    // Tasks still read the mapping; it must outlive them.
+    for (Pending &p : in_flight) {
+        try {
+            pool.wait(*p.group);
+        } catch (const std::exception &) {
+        }
+    }
+
+    if (!error.empty())
+        this->finish(CsvLoadState::Failed, error);
+    else if (st.stop_requested())
+        this->finish(CsvLoadState::Cancelled);
+    else
+        this->finish(CsvLoadState::Done);
+}
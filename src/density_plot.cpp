@@ -0,0 +1,170 @@
+#include "density_plot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <implot.h>
+#include <implot_internal.h>
+
+#include "simd_lanes.h"
+#include "thread_pool.h"
+
+namespace {
+
+// Below this many points per task the pool costs more than it saves.
+constexpr size_t kMinPointsPerTask = 256 * 1024;
+// Cells per merge task.
+constexpr size_t kMergeSlice = 64 * 1024;
+
+}  // namespace
+
+DensityPlot::DensityPlot(ThreadPool *pool) : pool_(pool ? pool : &ThreadPool::shared()) {}
+
+auto DensityPlot::scale_max() const -> double {
+    return this->scale_ == DensityScale::Log ? std::log10(1.0 + this->maxCount_) : static_cast<double>(this->maxCount_);
+}
+
+auto DensityPlot::tasks_for(size_t count) const -> size_t {
+    return std::clamp<size_t>(count / kMinPointsPerTask, 1, static_cast<size_t>(this->pool_->size()) + 1);
+}
+
+// Bounds of the finite points, split over the pool like the binning.
+auto DensityPlot::fit(const double *xs, const double *ys, size_t count) -> void {
+    struct Bounds {
+        double x_min = std::numeric_limits<double>::infinity(), x_max = -std::numeric_limits<double>::infinity();
+        double y_min = std::numeric_limits<double>::infinity(), y_max = -std::numeric_limits<double>::infinity();
+    };
+    const size_t tasks = this->tasks_for(count);
+    std::vector<Bounds> parts(tasks);
+    TaskGroup group;
+    for (size_t t = 0; t < tasks; ++t) {
+        this->pool_->submit(group, [&, t] {
+            Bounds &b = parts[t];
+            for (size_t i = count * t / tasks, end = count * (t + 1) / tasks; i < end; ++i) {
+                if (!std::isfinite(xs[i]) || !std::isfinite(ys[i]))
+                    continue;
+                b.x_min = std::min(b.x_min, xs[i]);
+                b.x_max = std::max(b.x_max, xs[i]);
+                b.y_min = std::min(b.y_min, ys[i]);
+                b.y_max = std::max(b.y_max, ys[i]);
+            }
+        });
+    }
+    this->pool_->wait(group);
+
+    Bounds all;
+    for (const Bounds &b : parts) {
+        all.x_min = std::min(all.x_min, b.x_min);
+        all.x_max = std::max(all.x_max, b.x_max);
+        all.y_min = std::min(all.y_min, b.y_min);
+        all.y_max = std::max(all.y_max, b.y_max);
+    }
+    this->boundsXs_ = xs;
+    this->boundsYs_ = ys;
+    this->boundsCount_ = count;
+    this->boundsValid_ = true;
+    this->bxMin_ = all.x_min;
+    this->bxMax_ = all.x_max;
+    this->byMin_ = all.y_min;
+    this->byMax_ = all.y_max;
+}
+
+auto DensityPlot::bin(const Key &key) -> void {
+    const size_t cells = static_cast<size_t>(key.cols) * static_cast<size_t>(key.rows);
+    const size_t tasks = this->tasks_for(key.count);
+    this->partials_.resize(tasks);
+    for (auto &p : this->partials_)
+        p.assign(cells, 0);
+
+    const double sx = key.cols / (key.x_max - key.x_min);
+    const double sy = key.rows / (key.y_max - key.y_min);
+    TaskGroup group;
+    for (size_t t = 0; t < tasks; ++t) {
+        this->pool_->submit(group, [&, t] {
+            uint32_t *hist = this->partials_[t].data();
+            for (size_t i = key.count * t / tasks, end = key.count * (t + 1) / tasks; i < end; ++i) {
+                const double fx = (key.xs[i] - key.x_min) * sx;
+                const double fy = (key.y_max - key.ys[i]) * sy;  // row 0 is the top of the plot
+                // Written so that NaN fails the test too.
+                if (!(fx >= 0.0 && fx < key.cols && fy >= 0.0 && fy < key.rows))
+                    continue;
+                ++hist[static_cast<size_t>(fy) * key.cols + static_cast<size_t>(fx)];
+            }
+        });
+    }
+    this->pool_->wait(group);
+
+    // Sum into partials_[0], a slice of cells per task.
+    if (tasks > 1) {
+        for (size_t first = 0; first < cells; first += kMergeSlice) {
+            this->pool_->submit(group, [this, first, cells, tasks] {
+                const size_t n = std::min(kMergeSlice, cells - first);
+                for (size_t t = 1; t < tasks; ++t)
+                    simd::add_u32(this->partials_[0].data() + first, this->partials_[t].data() + first, n);
+            });
+        }
+        this->pool_->wait(group);
+    }
+
+    const std::vector<uint32_t> &counts = this->partials_[0];
+    this->maxCount_ = counts.empty() ? 0 : *std::max_element(counts.begin(), counts.end());
+    this->key_ = key;
+    this->dirty_ = false;
+}
+
+auto DensityPlot::update_values(DensityScale scale) -> void {
+    const std::vector<uint32_t> &counts = this->partials_[0];
+    this->values_.resize(counts.size());
+    if (scale == DensityScale::Log) {
+        for (size_t i = 0; i < counts.size(); ++i)
+            this->values_[i] = counts[i] ? std::log10(1.0f + static_cast<float>(counts[i])) : 0.0f;
+    } else {
+        for (size_t i = 0; i < counts.size(); ++i)
+            this->values_[i] = static_cast<float>(counts[i]);
+    }
+    this->scale_ = scale;
+}
+
+auto DensityPlot::plot(const char *label, const double *xs, const double *ys, size_t count, DensityScale scale)
+    -> void {
+    ImPlotPlot &plot = *ImPlot::GetCurrentPlot();
+    if (plot.FitThisFrame) {
+        if (!this->boundsValid_ || this->boundsXs_ != xs || this->boundsYs_ != ys || this->boundsCount_ != count)
+            this->fit(xs, ys, count);
+        if (this->bxMin_ <= this->bxMax_) {
+            ImPlotAxis &x_axis = plot.Axes[plot.CurrentX];
+            ImPlotAxis &y_axis = plot.Axes[plot.CurrentY];
+            x_axis.ExtendFitWith(y_axis, this->bxMin_, this->byMin_);
+            x_axis.ExtendFitWith(y_axis, this->bxMax_, this->byMax_);
+            y_axis.ExtendFitWith(x_axis, this->byMin_, this->bxMin_);
+            y_axis.ExtendFitWith(x_axis, this->byMax_, this->bxMax_);
+        }
+    }
+
+    const ImPlotRect limits = ImPlot::GetPlotLimits();
+    const ImVec2 size = ImPlot::GetPlotSize();
+    Key key;
+    key.xs = xs;
+    key.ys = ys;
+    key.count = count;
+    key.x_min = limits.X.Min;
+    key.x_max = limits.X.Max;
+    key.y_min = limits.Y.Min;
+    key.y_max = limits.Y.Max;
+    key.cols = std::max(1, static_cast<int>(size.x) / this->cellSize_);
+    key.rows = std::max(1, static_cast<int>(size.y) / this->cellSize_);
+    if (!(key.x_max > key.x_min) || !(key.y_max > key.y_min))
+        return;
+
+    if (this->dirty_ || !(key == this->key_)) {
+        this->bin(key);
+        this->update_values(scale);
+    } else if (scale != this->scale_) {
+        this->update_values(scale);
+    }
+
+    ImPlot::PlotHeatmap(label, this->values_.data(), key.rows, key.cols, 0.0, std::max(this->scale_max(), 1e-9),
+                        nullptr, ImPlotPoint(key.x_min, key.y_min), ImPlotPoint(key.x_max, key.y_max),
+                        ImPlotItemFlags_NoFit);
+}
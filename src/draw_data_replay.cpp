@@ -0,0 +1,242 @@
+#include "draw_data_replay.h"
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+// File layout, native byte order:
+//   header  u32 magic, u32 version, u32 sizeof(ImDrawVert), u32 sizeof(ImDrawIdx)
+//   frame   u32 payload bytes, then: f32 display pos[2], size[2], framebuffer scale[2], u32 list count
+//   list    u32 cmd count, u32 vtx count, u32 idx count, cmds, vertices, indices
+//   cmd     f32 clip[4], u8 callback, u8 texture kind, u16 0, u64 texture id, u32 vtx offset, idx offset, elements
+namespace {
+
+constexpr uint32_t kMagic = 0x44445049;  // "IPDD"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kCmdBytes = 40;  // one recorded cmd, see above
+
+enum Callback : uint8_t { kNoCallback, kResetRenderState, kUserCallback };
+
+template <typename T> auto put(std::vector<uint8_t> &out, const T &value) -> void {
+    const auto *p = reinterpret_cast<const uint8_t *>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+auto put_bytes(std::vector<uint8_t> &out, const void *data, size_t size) -> void {
+    if (size == 0) {
+        return;
+    }
+    const auto *p = static_cast<const uint8_t *>(data);
+    out.insert(out.end(), p, p + size);
+}
+
+// Bounds-checked cursor over one frame's payload.
+class Reader {
+  public:
+    Reader(const std::vector<uint8_t> &data) : data_(data) {}
+
+    template <typename T> auto get() -> T {
+        T value;
+        this->get_bytes(&value, sizeof(T));
+        return value;
+    }
+
+    auto remaining() const -> size_t { return this->data_.size() - this->pos_; }
+
+    auto get_bytes(void *dst, size_t size) -> void {
+        if (size == 0) {
+            return;
+        }
+        if (size > this->remaining()) {
+            throw std::runtime_error("DrawDataReplay: corrupt frame");
+        }
+        std::memcpy(dst, this->data_.data() + this->pos_, size);
+        this->pos_ += size;
+    }
+
+  private:
+    const std::vector<uint8_t> &data_;
+    size_t pos_ = 0;
+};
+
+}  // namespace
+
+DrawDataRecorder::DrawDataRecorder(const std::string &path) : file_(path, std::ios::binary | std::ios::trunc) {
+    if (!this->file_) {
+        throw std::runtime_error("DrawDataRecorder: cannot open " + path);
+    }
+    put(this->buffer_, kMagic);
+    put(this->buffer_, kVersion);
+    put(this->buffer_, static_cast<uint32_t>(sizeof(ImDrawVert)));
+    put(this->buffer_, static_cast<uint32_t>(sizeof(ImDrawIdx)));
+    this->file_.write(reinterpret_cast<const char *>(this->buffer_.data()),
+                      static_cast<std::streamsize>(this->buffer_.size()));
+    this->bytes_ = this->buffer_.size();
+}
+
+auto DrawDataRecorder::record(const ImDrawData *draw_data) -> void {
+    if (!draw_data || !draw_data->Valid) {
+        return;
+    }
+    std::vector<uint8_t> &out = this->buffer_;
+    out.clear();
+    put(out, uint32_t{0});  // payload size, patched below
+    put(out, draw_data->DisplayPos);
+    put(out, draw_data->DisplaySize);
+    put(out, draw_data->FramebufferScale);
+    put(out, static_cast<uint32_t>(draw_data->CmdLists.Size));
+    for (const ImDrawList *dl : draw_data->CmdLists) {
+        put(out, static_cast<uint32_t>(dl->CmdBuffer.Size));
+        put(out, static_cast<uint32_t>(dl->VtxBuffer.Size));
+        put(out, static_cast<uint32_t>(dl->IdxBuffer.Size));
+        for (const ImDrawCmd &cmd : dl->CmdBuffer) {
+            put(out, cmd.ClipRect);
+            uint8_t callback = kNoCallback;
+            if (cmd.UserCallback == ImDrawCallback_ResetRenderState) {
+                callback = kResetRenderState;
+            } else if (cmd.UserCallback) {
+                callback = kUserCallback;
+            }
+            put(out, callback);
+            // Atlas (and other backend-managed) textures are identified by their ImTextureData; the live
+            // ImTextureID of those is a backend handle that means nothing in another process.
+            const ImTextureData *tex = cmd.TexRef._TexData;
+            put(out, static_cast<uint8_t>(tex ? 0 : 1));
+            put(out, uint16_t{0});
+            put(out, tex ? static_cast<uint64_t>(tex->UniqueID) : static_cast<uint64_t>(cmd.TexRef._TexID));
+            put(out, cmd.VtxOffset);
+            put(out, cmd.IdxOffset);
+            put(out, cmd.ElemCount);
+        }
+        put_bytes(out, dl->VtxBuffer.Data, sizeof(ImDrawVert) * dl->VtxBuffer.Size);
+        put_bytes(out, dl->IdxBuffer.Data, sizeof(ImDrawIdx) * dl->IdxBuffer.Size);
+    }
+    const auto payload = static_cast<uint32_t>(out.size() - sizeof(uint32_t));
+    std::memcpy(out.data(), &payload, sizeof(payload));
+
+    this->file_.write(reinterpret_cast<const char *>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!this->file_) {
+        throw std::runtime_error("DrawDataRecorder: write failed");
+    }
+    this->frames_ += 1;
+    this->bytes_ += out.size();
+}
+
+DrawDataReplay::DrawDataReplay(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("DrawDataReplay: cannot open " + path);
+    }
+    uint32_t header[4] = {};
+    if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != kMagic ||
+        header[1] != kVersion) {
+        throw std::runtime_error("DrawDataReplay: " + path + " is not a draw data recording");
+    }
+    if (header[2] != sizeof(ImDrawVert) || header[3] != sizeof(ImDrawIdx)) {
+        throw std::runtime_error("DrawDataReplay: " + path + " was recorded with a different ImDrawVert/ImDrawIdx");
+    }
+
+    file.seekg(0, std::ios::end);
+    const auto file_size = static_cast<uint64_t>(file.tellg());
+    file.seekg(sizeof(header));
+
+    std::vector<uint8_t> payload;
+    uint32_t size = 0;
+    // A recording cut short (the process died mid-write) loses only its last frame. A size beyond the end of the
+    // file is treated the same, before anything is allocated for it.
+    while (file.read(reinterpret_cast<char *>(&size), sizeof(size))) {
+        if (size > file_size - static_cast<uint64_t>(file.tellg())) {
+            break;
+        }
+        payload.resize(size);
+        if (!file.read(reinterpret_cast<char *>(payload.data()), size)) {
+            break;
+        }
+        Reader in(payload);
+        Frame &frame = this->frames_.emplace_back();
+        frame.displayPos = in.get<ImVec2>();
+        frame.displaySize = in.get<ImVec2>();
+        frame.framebufferScale = in.get<ImVec2>();
+        const auto lists = in.get<uint32_t>();
+        for (uint32_t l = 0; l < lists; ++l) {
+            const auto cmds = in.get<uint32_t>();
+            const auto vtx = in.get<uint32_t>();
+            const auto idx = in.get<uint32_t>();
+            // Counts are checked against the payload before anything is sized from them.
+            if (cmds > INT_MAX || vtx > INT_MAX || idx > INT_MAX ||
+                uint64_t{cmds} * kCmdBytes + uint64_t{vtx} * sizeof(ImDrawVert) + uint64_t{idx} * sizeof(ImDrawIdx) >
+                    in.remaining()) {
+                throw std::runtime_error("DrawDataReplay: corrupt frame");
+            }
+            auto dl = std::make_unique<ImDrawList>(nullptr);
+            dl->CmdBuffer.reserve(static_cast<int>(cmds));
+            std::vector<std::pair<TexKind, uint64_t>> textures;
+            for (uint32_t c = 0; c < cmds; ++c) {
+                ImDrawCmd cmd;
+                cmd.ClipRect = in.get<ImVec4>();
+                const auto callback = in.get<uint8_t>();
+                const auto kind = in.get<uint8_t>() == 0 ? TexKind::Managed : TexKind::Raw;
+                in.get<uint16_t>();
+                const auto id = in.get<uint64_t>();
+                cmd.VtxOffset = in.get<unsigned int>();
+                cmd.IdxOffset = in.get<unsigned int>();
+                cmd.ElemCount = in.get<unsigned int>();
+                if (callback == kUserCallback) {
+                    this->callbacksSkipped_ += 1;
+                    continue;
+                }
+                if (callback == kResetRenderState) {
+                    cmd.UserCallback = ImDrawCallback_ResetRenderState;
+                }
+                dl->CmdBuffer.push_back(cmd);
+                textures.emplace_back(kind, id);
+            }
+            for (int c = 0; c < dl->CmdBuffer.Size; ++c) {
+                frame.textures.push_back({&dl->CmdBuffer[c], textures[c].first, textures[c].second});
+            }
+            dl->VtxBuffer.resize(static_cast<int>(vtx));
+            in.get_bytes(dl->VtxBuffer.Data, sizeof(ImDrawVert) * vtx);
+            dl->IdxBuffer.resize(static_cast<int>(idx));
+            in.get_bytes(dl->IdxBuffer.Data, sizeof(ImDrawIdx) * idx);
+            frame.totalVtx += static_cast<int>(vtx);
+            frame.totalIdx += static_cast<int>(idx);
+            frame.lists.push_back(std::move(dl));
+        }
+    }
+    if (this->frames_.empty()) {
+        throw std::runtime_error("DrawDataReplay: " + path + " holds no frames");
+    }
+}
+
+DrawDataReplay::~DrawDataReplay() = default;
+
+auto DrawDataReplay::frame(size_t index) -> ImDrawData * {
+    Frame &frame = this->frames_.at(index);
+    const ImTextureRef atlas = ImGui::GetIO().Fonts->TexRef;
+    for (const TexUse &use : frame.textures) {
+        if (use.kind == TexKind::Raw) {
+            const auto it = this->textures_.find(use.id);
+            use.cmd->TexRef = it != this->textures_.end() ? ImTextureRef(it->second) : atlas;
+        } else {
+            use.cmd->TexRef = atlas;
+        }
+    }
+
+    ImDrawData &dd = this->drawData_;
+    dd.Clear();
+    dd.Valid = true;
+    for (const auto &dl : frame.lists) {
+        dd.CmdLists.push_back(dl.get());
+    }
+    dd.CmdListsCount = dd.CmdLists.Size;
+    dd.TotalVtxCount = frame.totalVtx;
+    dd.TotalIdxCount = frame.totalIdx;
+    dd.DisplayPos = frame.displayPos;
+    dd.DisplaySize = frame.displaySize;
+    dd.FramebufferScale = frame.framebufferScale;
+    // The backend reads both: the viewport for its renderer data, the texture list for pending atlas uploads.
+    dd.OwnerViewport = ImGui::GetMainViewport();
+    dd.Textures = &ImGui::GetPlatformIO().Textures;
+    return &dd;
+}
@@ -0,0 +1,152 @@
+#include "drawer_cache.h"
+
+#include <algorithm>
+
+#include <imgui_internal.h>
+#include <implot.h>
+
+namespace {
+
+auto fnv1a(uint64_t h, const void *data, size_t size) -> uint64_t {
+    const auto *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+}  // namespace
+
+auto DrawerCache::context_epoch() -> uint64_t {
+    const ImGuiIO &io = ImGui::GetIO();
+    uint64_t h = 14695981039346656037ull;
+    h = fnv1a(h, &io.DisplaySize, sizeof(io.DisplaySize));
+    h = fnv1a(h, &io.DisplayFramebufferScale, sizeof(io.DisplayFramebufferScale));
+    h = fnv1a(h, &ImGui::GetStyle(), sizeof(ImGuiStyle));
+    h = fnv1a(h, &ImPlot::GetStyle(), sizeof(ImPlotStyle));
+    // The atlas may be rebuilt or grown into a new texture, which moves glyph UVs under the recorded vertices.
+    const ImTextureData *tex = io.Fonts->TexData;
+    h = fnv1a(h, &tex, sizeof(tex));
+    if (tex) {
+        h = fnv1a(h, &tex->UniqueID, sizeof(tex->UniqueID));
+        h = fnv1a(h, &tex->Width, sizeof(tex->Width));
+        h = fnv1a(h, &tex->Height, sizeof(tex->Height));
+    }
+    return h;
+}
+
+auto DrawerCache::needs_run(const DrawerUpdate &update, uint64_t version, int64_t now_ns, uint64_t epoch) const
+    -> bool {
+    if (!this->valid_ || epoch != this->epoch_)
+        return true;
+    if (update.versioned && version != this->version_)
+        return true;
+    if (update.interval.count() > 0 && now_ns - this->runNs_ >= update.interval.count())
+        return true;
+    return this->interacting();
+}
+
+// Mouse over, dragging, or keyboard focus with input on one of the recorded windows.
+auto DrawerCache::interacting() const -> bool {
+    const ImGuiContext &g = *ImGui::GetCurrentContext();
+    const ImGuiIO &io = g.IO;
+    const bool mouse_active = io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f || io.MouseWheel != 0.0f ||
+                              io.MouseWheelH != 0.0f || ImGui::IsAnyMouseDown() ||
+                              ImGui::IsMouseReleased(ImGuiMouseButton_Left) ||
+                              ImGui::IsMouseReleased(ImGuiMouseButton_Right) ||
+                              ImGui::IsMouseReleased(ImGuiMouseButton_Middle);
+    auto root_id = [](const ImGuiWindow *w) -> ImGuiID { return w && w->RootWindow ? w->RootWindow->ID : 0; };
+    const ImGuiID hovered = mouse_active ? root_id(g.HoveredWindow) : 0;
+    const ImGuiID active = root_id(g.ActiveIdWindow);
+    const ImGuiID moving = root_id(g.MovingWindow);
+    const ImGuiID nav = g.InputEventsTrail.Size > 0 ? root_id(g.NavWindow) : 0;
+
+    for (const Window &w : this->windows_) {
+        if (w.id == hovered || w.id == active || w.id == moving || w.id == nav)
+            return true;
+        const ImGuiWindow *window = ImGui::FindWindowByID(w.id);
+        if (!window || window->Pos.x != w.pos.x || window->Pos.y != w.pos.y || window->Size.x != w.size.x ||
+            window->Size.y != w.size.y)
+            return true;
+    }
+    return false;
+}
+
+auto DrawerCache::begin_capture() -> void {
+    const ImGuiContext &g = *ImGui::GetCurrentContext();
+    this->frame_ = g.FrameCount;
+    this->firstBeginOrder_ = g.WindowsActiveCount;
+}
+
+// Windows first begun this frame while the drawer ran are the ones with BeginOrderWithinContext in
+// [firstBeginOrder_, WindowsActiveCount).
+auto DrawerCache::end_capture(uint64_t version, int64_t now_ns, uint64_t epoch) -> void {
+    const ImGuiContext &g = *ImGui::GetCurrentContext();
+    this->windows_.clear();
+    this->valid_ = false;
+    if (g.WindowsActiveCount == this->firstBeginOrder_ || g.FrameCount != this->frame_)
+        return;
+
+    for (ImGuiWindow *window : g.Windows) {
+        if (window->LastFrameActive != g.FrameCount || window->BeginOrderWithinContext < this->firstBeginOrder_)
+            continue;
+        if (window->Flags & (ImGuiWindowFlags_ChildWindow | ImGuiWindowFlags_Popup | ImGuiWindowFlags_Tooltip)) {
+            this->windows_.clear();
+            return;
+        }
+        const ImDrawList *dl = window->DrawList;
+        if (dl->_Splitter._Count > 1) {
+            this->windows_.clear();
+            return;
+        }
+        Window &w = this->windows_.emplace_back();
+        w.id = window->ID;
+        w.name = window->Name;
+        w.flags = window->Flags;
+        w.pos = window->Pos;
+        w.size = window->Size;
+        w.content = ImVec2(window->DC.CursorMaxPos.x - window->DC.CursorStartPos.x,
+                           window->DC.CursorMaxPos.y - window->DC.CursorStartPos.y);
+        w.cmds = dl->CmdBuffer;
+        w.idx = dl->IdxBuffer;
+        w.vtx = dl->VtxBuffer;
+        w.callbackData = dl->_CallbacksDataBuf;
+    }
+    // Begin order is the order the windows were submitted in, which replay has to repeat.
+    std::sort(this->windows_.begin(), this->windows_.end(), [](const Window &a, const Window &b) {
+        return ImGui::FindWindowByID(a.id)->BeginOrderWithinContext <
+               ImGui::FindWindowByID(b.id)->BeginOrderWithinContext;
+    });
+
+    this->valid_ = !this->windows_.empty();
+    this->version_ = version;
+    this->runNs_ = now_ns;
+    this->epoch_ = epoch;
+}
+
+auto DrawerCache::replay() -> void {
+    for (const Window &w : this->windows_) {
+        ImGui::SetNextWindowPos(w.pos, ImGuiCond_Always);
+        ImGui::SetNextWindowSize(w.size, ImGuiCond_Always);
+        const bool visible = ImGui::Begin(w.name.c_str(), nullptr, w.flags);
+        if (visible && !w.cmds.empty()) {
+            // Keep the content extent so scrollbars and auto-fit behave as if the items had been submitted.
+            ImGui::Dummy(w.content);
+
+            ImDrawList *dl = ImGui::GetWindowDrawList();
+            dl->CmdBuffer = w.cmds;
+            dl->IdxBuffer = w.idx;
+            dl->VtxBuffer = w.vtx;
+            dl->_CallbacksDataBuf = w.callbackData;
+            const ImDrawCmd &last = dl->CmdBuffer.back();
+            dl->_CmdHeader.ClipRect = last.ClipRect;
+            dl->_CmdHeader.TexRef = last.TexRef;
+            dl->_CmdHeader.VtxOffset = last.VtxOffset;
+            dl->_VtxCurrentIdx = (unsigned int)(dl->VtxBuffer.Size - (int)last.VtxOffset);
+            dl->_VtxWritePtr = dl->VtxBuffer.Data + dl->VtxBuffer.Size;
+            dl->_IdxWritePtr = dl->IdxBuffer.Data + dl->IdxBuffer.Size;
+        }
+        ImGui::End();
+    }
+}
@@ -0,0 +1,106 @@
+#include "drawer_registry.h"
+
+auto DrawerRegistry::apply(DrawerCommand &cmd) -> void {
+    switch (cmd.op) {
+    case DrawerCommand::Op::Add:
+        this->add(std::move(cmd.entry));
+        break;
+    case DrawerCommand::Op::RemoveId:
+        this->remove(cmd.id);
+        break;
+    case DrawerCommand::Op::RemoveKey:
+        this->remove(cmd.key);
+        break;
+    case DrawerCommand::Op::Clear:
+        this->clear();
+        break;
+    case DrawerCommand::Op::Touch:
+        if (Entry *item = this->find(cmd.id))
+            item->touch();
+        break;
+    }
+}
+
+auto DrawerRegistry::find(uint32_t id) const -> Entry * {
+    auto it = this->index_.find(id);
+    return it == this->index_.end() ? nullptr : this->slots_[it->second].get();
+}
+
+auto DrawerRegistry::add(EntryPtr item) -> void {
+    const uint32_t id = item->id;
+    if (!item->key.empty())
+        this->keys_[item->key].insert(id);
+    this->index_[id] = this->slots_.size();
+    this->slots_.push_back(std::move(item));
+}
+
+auto DrawerRegistry::remove(uint32_t id) -> void {
+    auto it = this->index_.find(id);
+    if (it == this->index_.end())
+        return;
+    EntryPtr &slot = this->slots_[it->second];
+    if (!slot->key.empty()) {
+        auto k = this->keys_.find(slot->key);
+        k->second.erase(id);
+        if (k->second.empty())
+            this->keys_.erase(k);
+    }
+    slot.reset();
+    this->index_.erase(it);
+    if (this->slots_.size() > 2 * this->index_.size() + 16)
+        this->compact();
+}
+
+auto DrawerRegistry::remove(const std::string &key) -> void {
+    auto k = this->keys_.find(key);
+    if (k == this->keys_.end())
+        return;
+    for (uint32_t id : k->second) {
+        auto it = this->index_.find(id);
+        this->slots_[it->second].reset();
+        this->index_.erase(it);
+    }
+    this->keys_.erase(k);
+    if (this->slots_.size() > 2 * this->index_.size() + 16)
+        this->compact();
+}
+
+auto DrawerRegistry::clear() -> void {
+    this->slots_.clear();
+    this->index_.clear();
+    this->keys_.clear();
+}
+
+auto DrawerRegistry::compact() -> void {
+    size_t out = 0;
+    for (size_t i = 0; i < this->slots_.size(); ++i) {
+        if (!this->slots_[i])
+            continue;
+        this->index_[this->slots_[i]->id] = out;
+        this->slots_[out++] = std::move(this->slots_[i]);
+    }
+    this->slots_.resize(out);
+}
+
+auto DrawerBatch::draw(EntryPtr item) -> uint32_t {
+    const uint32_t id = this->ids_->fetch_add(1, std::memory_order_relaxed) + 1;
+    item->id = id;
+    this->commands_.push_back(DrawerCommand{DrawerCommand::Op::Add, id, {}, std::move(item)});
+    return id;
+}
+
+auto DrawerBatch::remove(uint32_t id) -> void {
+    this->commands_.push_back(DrawerCommand{DrawerCommand::Op::RemoveId, id, {}, nullptr});
+}
+
+auto DrawerBatch::remove(const std::string &key) -> void {
+    this->commands_.push_back(DrawerCommand{DrawerCommand::Op::RemoveKey, 0, key, nullptr});
+}
+
+auto DrawerBatch::clear() -> void {
+    this->commands_.push_back(DrawerCommand{DrawerCommand::Op::Clear, 0, {}, nullptr});
+}
+
+auto DrawerBatch::touch(uint32_t id) -> void {
+    this->commands_.push_back(DrawerCommand{DrawerCommand::Op::Touch, id, {}, nullptr});
+}
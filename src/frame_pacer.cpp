@@ -0,0 +1,53 @@
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FRAME_PACER_PAUSE() _mm_pause()
+#elif defined(__aarch64__)
+#define FRAME_PACER_PAUSE() asm volatile("yield")
+#else
+#define FRAME_PACER_PAUSE() ((void)0)
+#endif
+
+auto FramePacer::pace() -> void {
+    using namespace std::chrono;
+
+    const double fps = this->target_fps();
+    if (fps <= 0.0) {
+        this->period_ = clock::duration::zero();
+        return;
+    }
+
+    const auto period = duration_cast<clock::duration>(duration<double>(1.0 / fps));
+    auto now = clock::now();
+    if (period != this->period_ || this->next_ == clock::time_point{}) {
+        // (Re)start the schedule, the current frame counts as on time.
+        this->period_ = period;
+        this->next_ = now + period;
+        return;
+    }
+
+    if (now < this->next_) {
+        const auto wake = this->next_ - this->spinMargin_;
+        if (now < wake) {
+            std::this_thread::sleep_until(wake);
+            // Feed the observed oversleep into the margin: grow quickly, shrink slowly.
+            const auto over = clock::now() - wake;
+            const auto target = std::clamp<clock::duration>(over + over / 2, microseconds(200), milliseconds(4));
+            this->spinMargin_ = target > this->spinMargin_ ? target : (this->spinMargin_ * 7 + target) / 8;
+        }
+        while (clock::now() < this->next_) {
+            FRAME_PACER_PAUSE();
+        }
+        now = clock::now();
+    }
+
+    // Keep a fixed cadence, but never try to catch up after a long stall.
+    this->next_ += this->period_;
+    if (this->next_ < now) {
+        this->next_ = now + this->period_;
+    }
+}
@@ -0,0 +1,527 @@
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+#include <imgui.h>
+#include <implot.h>
+
+auto FramePhaseName(FramePhase phase) -> const char * {
+    switch (phase) {
+    case FramePhase::GpuWait:
+        return "GpuWait";
+    case FramePhase::PollEvents:
+        return "PollEvents";
+    case FramePhase::SwapchainResize:
+        return "SwapchainResize";
+    case FramePhase::NewFrame:
+        return "NewFrame";
+    case FramePhase::PrepareWait:
+        return "PrepareWait";
+    case FramePhase::Drawers:
+        return "Drawers";
+    case FramePhase::Render:
+        return "Render";
+    case FramePhase::FrameRender:
+        return "FrameRender";
+    case FramePhase::FenceWait:
+        return "FenceWait";
+    case FramePhase::FramePresent:
+        return "FramePresent";
+    default:
+        return "?";
+    }
+}
+
+static auto summarize(std::vector<uint32_t> &ns) -> TimingSummary {
+    TimingSummary s;
+    s.samples = ns.size();
+    if (ns.empty())
+        return s;
+    std::sort(ns.begin(), ns.end());
+    double sum = 0.0;
+    for (auto v : ns)
+        sum += v;
+    auto pct = [&](double p) { return ns[std::min(ns.size() - 1, static_cast<size_t>(p * (ns.size() - 1) + 0.5))]; };
+    s.min_ms = ns.front() * 1e-6;
+    s.max_ms = ns.back() * 1e-6;
+    s.mean_ms = sum / static_cast<double>(ns.size()) * 1e-6;
+    s.p50_ms = pct(0.50) * 1e-6;
+    s.p95_ms = pct(0.95) * 1e-6;
+    s.p99_ms = pct(0.99) * 1e-6;
+    return s;
+}
+
+FrameProfiler::FrameProfiler(size_t frames)
+    : capacity_(std::max<size_t>(frames, 2)), slots_(std::make_unique<Slot[]>(capacity_)) {}
+
+auto FrameProfiler::rel_ns(int64_t t) const -> uint32_t {
+    const auto d = t - this->active_->record.begin_ns;
+    return static_cast<uint32_t>(std::clamp<int64_t>(d, 0, UINT32_MAX));
+}
+
+auto FrameProfiler::begin_frame() -> void {
+    if (!this->enabled())
+        return;
+    const auto frame = this->next_frame_.load(std::memory_order_relaxed);
+    Slot &slot = this->slots_[frame % this->capacity_];
+    slot.seq.store(2 * frame + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    FrameRecord &r = slot.record;
+    r.frame = frame;
+    r.begin_ns = this->now_ns();
+    r.duration_ns = 0;
+    std::memset(r.phase_begin_ns, 0, sizeof(r.phase_begin_ns));
+    std::memset(r.phase_ns, 0, sizeof(r.phase_ns));
+    r.vtx_count = 0;
+    r.idx_count = 0;
+    r.cmd_list_count = 0;
+    r.draw_call_count = 0;
+    r.gpu_ns = 0;
+    r.in_flight_begin = 0;
+    r.in_flight_render = 0;
+    r.drawer_count = 0;
+    r.drawers_dropped = 0;
+    r.window_count = 0;
+    r.windows_dropped = 0;
+    this->active_ = &slot;
+}
+
+auto FrameProfiler::end_frame() -> void {
+    if (!this->active_)
+        return;
+    Slot &slot = *this->active_;
+    slot.record.duration_ns = this->rel_ns(this->now_ns());
+    const auto frame = slot.record.frame;
+    slot.seq.store(2 * frame + 2, std::memory_order_release);
+    this->next_frame_.store(frame + 1, std::memory_order_release);
+    this->active_ = nullptr;
+    if (frame >= this->next_prune_) {
+        this->prune_names(frame);
+        this->next_prune_ = frame + this->capacity_;
+    }
+}
+
+// Once per ring length: forgets ids last sampled by a frame older than every slot.
+auto FrameProfiler::prune_names(uint64_t frame) -> void {
+    const uint64_t oldest = frame + 1 > this->capacity_ ? frame + 1 - this->capacity_ : 0;
+    std::vector<uint32_t> drawers, windows;
+    std::erase_if(this->drawers_seen_, [&](const auto &e) {
+        if (e.second >= oldest)
+            return false;
+        drawers.push_back(e.first);
+        return true;
+    });
+    std::erase_if(this->windows_seen_, [&](const auto &e) {
+        if (e.second >= oldest)
+            return false;
+        windows.push_back(e.first);
+        return true;
+    });
+    if (drawers.empty() && windows.empty())
+        return;
+    std::scoped_lock guard(this->keys_mutex_);
+    for (uint32_t id : drawers)
+        this->keys_.erase(id);
+    for (uint32_t id : windows)
+        this->window_names_.erase(id);
+}
+
+auto FrameProfiler::begin_phase(FramePhase phase) -> void {
+    if (!this->active_)
+        return;
+    const auto i = static_cast<size_t>(phase);
+    this->phase_begin_[i] = this->now_ns();
+    this->active_->record.phase_begin_ns[i] = this->rel_ns(this->phase_begin_[i]);
+}
+
+auto FrameProfiler::end_phase(FramePhase phase) -> void {
+    if (!this->active_)
+        return;
+    const auto i = static_cast<size_t>(phase);
+    const auto d = this->now_ns() - this->phase_begin_[i];
+    this->active_->record.phase_ns[i] = static_cast<uint32_t>(std::clamp<int64_t>(d, 0, UINT32_MAX));
+}
+
+auto FrameProfiler::record_drawer(uint32_t id, const std::string &key, int64_t begin_ns) -> void {
+    if (!this->active_)
+        return;
+    const auto end = this->now_ns();
+    FrameRecord &r = this->active_->record;
+    if (r.drawer_count == FrameRecord::kMaxDrawers) {
+        ++r.drawers_dropped;
+    } else {
+        r.drawers[r.drawer_count++] =
+            DrawerSample{id, this->rel_ns(begin_ns), static_cast<uint32_t>(std::clamp<int64_t>(end - begin_ns, 0,
+                                                                                               UINT32_MAX))};
+    }
+    if (this->drawers_seen_.insert_or_assign(id, r.frame).second) {
+        std::scoped_lock guard(this->keys_mutex_);
+        this->keys_[id] = key;
+    }
+}
+
+auto FrameProfiler::record_draw_data(const ImDrawData *draw_data) -> void {
+    if (!this->active_)
+        return;
+    FrameRecord &r = this->active_->record;
+    r.vtx_count = static_cast<uint32_t>(draw_data->TotalVtxCount);
+    r.idx_count = static_cast<uint32_t>(draw_data->TotalIdxCount);
+    r.cmd_list_count = static_cast<uint32_t>(draw_data->CmdListsCount);
+    for (const ImDrawList *dl : draw_data->CmdLists) {
+        uint32_t draw_calls = 0;
+        for (const ImDrawCmd &cmd : dl->CmdBuffer)
+            if (!cmd.UserCallback && cmd.ElemCount)
+                ++draw_calls;
+        r.draw_call_count += draw_calls;
+
+        const std::string_view name = dl->_OwnerName ? dl->_OwnerName : "";
+        const auto id = static_cast<uint32_t>(std::hash<std::string_view>{}(name));
+        WindowSample *const end = r.windows + r.window_count;
+        WindowSample *w = std::find_if(r.windows, end, [&](const WindowSample &x) { return x.id == id; });
+        if (w == end) {
+            if (r.window_count == FrameRecord::kMaxWindows) {
+                ++r.windows_dropped;
+                continue;
+            }
+            *w = WindowSample{id, 0, 0, 0, 0};
+            ++r.window_count;
+            if (this->windows_seen_.insert_or_assign(id, r.frame).second) {
+                std::scoped_lock guard(this->keys_mutex_);
+                this->window_names_[id] = std::string(name);
+            }
+        }
+        w->vtx_count += static_cast<uint32_t>(dl->VtxBuffer.Size);
+        w->idx_count += static_cast<uint32_t>(dl->IdxBuffer.Size);
+        w->cmd_lists += 1;
+        w->draw_calls += draw_calls;
+    }
+}
+
+auto FrameProfiler::record_in_flight_begin(uint32_t frames) -> void {
+    if (this->active_)
+        this->active_->record.in_flight_begin = frames;
+}
+
+auto FrameProfiler::record_in_flight_render(uint32_t frames) -> void {
+    if (this->active_)
+        this->active_->record.in_flight_render = frames;
+}
+
+auto FrameProfiler::record_gpu(uint64_t frame, uint64_t gpu_ns) -> void {
+    Slot &slot = this->slots_[frame % this->capacity_];
+    const uint64_t done = 2 * frame + 2;
+    if (!this->enabled() || slot.seq.load(std::memory_order_relaxed) != done)
+        return;
+    // A reader racing this sees the same sequence before and after, and either value of this one field.
+    slot.seq.store(done - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.record.gpu_ns = static_cast<uint32_t>(std::min<uint64_t>(gpu_ns, UINT32_MAX));
+    slot.seq.store(done, std::memory_order_release);
+}
+
+auto FrameProfiler::read_slot(uint64_t frame, FrameRecord &out) const -> bool {
+    const Slot &slot = this->slots_[frame % this->capacity_];
+    const auto s1 = slot.seq.load(std::memory_order_acquire);
+    if (s1 != 2 * frame + 2)
+        return false;
+    std::memcpy(&out, &slot.record, sizeof(FrameRecord));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.seq.load(std::memory_order_relaxed) == s1;
+}
+
+auto FrameProfiler::latest(size_t count) const -> std::vector<FrameRecord> {
+    const auto end = this->frames_recorded();
+    // The oldest slot may already be in the middle of a rewrite, skip it.
+    count = std::min<uint64_t>({count, end, this->capacity_ - 1});
+    std::vector<FrameRecord> out(count);
+    size_t n = 0;
+    for (uint64_t f = end - count; f < end; ++f) {
+        if (this->read_slot(f, out[n]))
+            ++n;
+    }
+    out.resize(n);
+    return out;
+}
+
+auto FrameProfiler::phase_summary(FramePhase phase, size_t frames) const -> TimingSummary {
+    std::vector<uint32_t> ns;
+    for (const auto &r : this->latest(frames))
+        if (r.phase(phase))
+            ns.push_back(r.phase(phase));
+    return summarize(ns);
+}
+
+auto FrameProfiler::frame_summary(size_t frames) const -> TimingSummary {
+    std::vector<uint32_t> ns;
+    for (const auto &r : this->latest(frames))
+        ns.push_back(r.duration_ns);
+    return summarize(ns);
+}
+
+auto FrameProfiler::drawer_summary(uint32_t id, size_t frames) const -> TimingSummary {
+    std::vector<uint32_t> ns;
+    for (const auto &r : this->latest(frames))
+        for (uint32_t i = 0; i < r.drawer_count; ++i)
+            if (r.drawers[i].id == id)
+                ns.push_back(r.drawers[i].duration_ns);
+    return summarize(ns);
+}
+
+auto FrameProfiler::drawer_summary(const std::string &key, size_t frames) const -> TimingSummary {
+    std::unordered_set<uint32_t> ids;
+    {
+        std::scoped_lock guard(this->keys_mutex_);
+        for (const auto &[id, k] : this->keys_)
+            if (k == key)
+                ids.insert(id);
+    }
+    // Several drawers may share a key; their time within a frame is summed.
+    std::vector<uint32_t> ns;
+    for (const auto &r : this->latest(frames)) {
+        uint64_t sum = 0;
+        bool seen = false;
+        for (uint32_t i = 0; i < r.drawer_count; ++i) {
+            if (ids.contains(r.drawers[i].id)) {
+                sum += r.drawers[i].duration_ns;
+                seen = true;
+            }
+        }
+        if (seen)
+            ns.push_back(static_cast<uint32_t>(std::min<uint64_t>(sum, UINT32_MAX)));
+    }
+    return summarize(ns);
+}
+
+auto FrameProfiler::drawer_key(uint32_t id) const -> std::string {
+    std::scoped_lock guard(this->keys_mutex_);
+    auto it = this->keys_.find(id);
+    return it != this->keys_.end() ? it->second : std::string();
+}
+
+auto FrameProfiler::gpu_summary(size_t frames) const -> TimingSummary {
+    std::vector<uint32_t> ns;
+    for (const auto &r : this->latest(frames))
+        if (r.gpu_ns)
+            ns.push_back(r.gpu_ns);
+    return summarize(ns);
+}
+
+auto FrameProfiler::overlap_summary(size_t frames) const -> OverlapSummary {
+    OverlapSummary s;
+    const auto records = this->latest(frames);
+    // Only frames that reached FrameRender; the rest (minimized, on-demand idle) say nothing about overlap.
+    for (const auto &r : records) {
+        if (!r.phase(FramePhase::FrameRender))
+            continue;
+        ++s.samples;
+        s.busy_at_begin += r.in_flight_begin > 0 ? 1.0 : 0.0;
+        s.busy_at_render += r.in_flight_render > 0 ? 1.0 : 0.0;
+        s.mean_in_flight += r.in_flight_render;
+        s.gpu_wait_ms += (r.phase(FramePhase::GpuWait) + r.phase(FramePhase::FenceWait)) * 1e-6;
+    }
+    if (s.samples) {
+        const auto n = static_cast<double>(s.samples);
+        s.busy_at_begin /= n;
+        s.busy_at_render /= n;
+        s.mean_in_flight /= n;
+        s.gpu_wait_ms /= n;
+    }
+    return s;
+}
+
+auto FrameProfiler::window_name(uint32_t id) const -> std::string {
+    std::scoped_lock guard(this->keys_mutex_);
+    auto it = this->window_names_.find(id);
+    return it != this->window_names_.end() ? it->second : std::string();
+}
+
+static auto json_escape(const std::string &s) -> std::string {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                out += ' ';
+            else
+                out += c;
+        }
+    }
+    return out;
+}
+
+auto FrameProfiler::write_chrome_trace(const std::string &path, size_t frames) const -> void {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    const auto records = this->latest(frames ? frames : this->capacity_);
+    std::unordered_map<uint32_t, std::string> keys;
+    {
+        std::scoped_lock guard(this->keys_mutex_);
+        keys = this->keys_;
+    }
+    const int64_t origin = records.empty() ? 0 : records.front().begin_ns;
+    auto us = [](int64_t ns) { return static_cast<double>(ns) * 1e-3; };
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto event = [&](const std::string &name, const char *cat, int tid, int64_t begin, uint32_t dur,
+                     const std::string &args) {
+        file << (first ? "" : ",\n") << "{\"name\":\"" << json_escape(name) << "\",\"cat\":\"" << cat
+             << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << us(begin - origin)
+             << ",\"dur\":" << us(dur) << ",\"args\":{" << args << "}}";
+        first = false;
+    };
+
+    for (const auto &r : records) {
+        event("Frame", "frame", 1, r.begin_ns, r.duration_ns,
+              "\"frame\":" + std::to_string(r.frame) + ",\"gpu_ms\":" + std::to_string(r.gpu_ns * 1e-6) +
+                  ",\"vtx\":" + std::to_string(r.vtx_count) + ",\"draw_calls\":" + std::to_string(r.draw_call_count));
+        for (size_t p = 0; p < FrameRecord::kPhases; ++p) {
+            if (!r.phase_ns[p])
+                continue;
+            event(FramePhaseName(static_cast<FramePhase>(p)), "phase", 1, r.begin_ns + r.phase_begin_ns[p],
+                  r.phase_ns[p], "");
+        }
+        for (uint32_t i = 0; i < r.drawer_count; ++i) {
+            const auto &d = r.drawers[i];
+            auto it = keys.find(d.id);
+            std::string name = it != keys.end() && !it->second.empty() ? it->second : "drawer #" + std::to_string(d.id);
+            event(name, "drawer", 1, r.begin_ns + d.begin_ns, d.duration_ns, "\"id\":" + std::to_string(d.id));
+        }
+    }
+    file << "\n]}\n";
+    if (!file) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+auto FrameProfiler::draw_overlay(bool *open) const -> void {
+    constexpr size_t kFrames = 240;
+    const auto records = this->latest(kFrames);
+
+    ImGui::SetNextWindowSize(ImVec2(520, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Frame profiler", open)) {
+        ImGui::End();
+        return;
+    }
+
+    const auto total = this->frame_summary(kFrames);
+    ImGui::Text("frame  mean %.2f ms   p95 %.2f ms   p99 %.2f ms   max %.2f ms", total.mean_ms, total.p95_ms,
+                total.p99_ms, total.max_ms);
+    const auto gpu = this->gpu_summary(kFrames);
+    if (gpu.samples)
+        ImGui::Text("gpu    mean %.2f ms   p95 %.2f ms   p99 %.2f ms   max %.2f ms", gpu.mean_ms, gpu.p95_ms,
+                    gpu.p99_ms, gpu.max_ms);
+    const auto overlap = this->overlap_summary(kFrames);
+    if (overlap.samples)
+        ImGui::Text("overlap  gpu busy at render %.0f%%   in flight %.2f   cpu waits gpu %.2f ms",
+                    overlap.busy_at_render * 100.0, overlap.mean_in_flight, overlap.gpu_wait_ms);
+    if (!records.empty()) {
+        const FrameRecord &last = records.back();
+        ImGui::Text("vtx %u   idx %u   draw lists %u   draw calls %u", last.vtx_count, last.idx_count,
+                    last.cmd_list_count, last.draw_call_count);
+    }
+
+    std::vector<double> xs(records.size());
+    std::vector<double> ys(records.size());
+    if (ImPlot::BeginPlot("##phases", ImVec2(-1, 200))) {
+        ImPlot::SetupAxes("frame", "ms", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        for (size_t p = 0; p < FrameRecord::kPhases; ++p) {
+            for (size_t i = 0; i < records.size(); ++i) {
+                xs[i] = static_cast<double>(records[i].frame);
+                ys[i] = records[i].phase_ns[p] * 1e-6;
+            }
+            ImPlot::PlotLine(FramePhaseName(static_cast<FramePhase>(p)), xs.data(), ys.data(),
+                             static_cast<int>(records.size()));
+        }
+        ImPlot::EndPlot();
+    }
+
+    // Slowest drawers by mean over the window
+    struct Row {
+        uint32_t id;
+        uint64_t sum_ns;
+        uint32_t max_ns;
+        uint32_t frames;
+    };
+    std::unordered_map<uint32_t, Row> rows;
+    for (const auto &r : records) {
+        for (uint32_t i = 0; i < r.drawer_count; ++i) {
+            auto &row = rows.try_emplace(r.drawers[i].id, Row{r.drawers[i].id, 0, 0, 0}).first->second;
+            row.sum_ns += r.drawers[i].duration_ns;
+            row.max_ns = std::max(row.max_ns, r.drawers[i].duration_ns);
+            ++row.frames;
+        }
+    }
+    std::vector<Row> sorted;
+    sorted.reserve(rows.size());
+    for (const auto &[id, row] : rows)
+        sorted.push_back(row);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Row &a, const Row &b) { return a.sum_ns * b.frames > b.sum_ns * a.frames; });
+
+    if (ImGui::BeginTable("##drawers", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupColumn("id");
+        ImGui::TableSetupColumn("key");
+        ImGui::TableSetupColumn("mean ms");
+        ImGui::TableSetupColumn("max ms");
+        ImGui::TableHeadersRow();
+        for (const auto &row : sorted) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", row.id);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(this->drawer_key(row.id).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", static_cast<double>(row.sum_ns) / row.frames * 1e-6);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", row.max_ns * 1e-6);
+        }
+        ImGui::EndTable();
+    }
+
+    // Heaviest windows of the last frame
+    if (!records.empty()) {
+        const FrameRecord &last = records.back();
+        std::vector<WindowSample> windows(last.windows, last.windows + last.window_count);
+        std::sort(windows.begin(), windows.end(),
+                  [](const WindowSample &a, const WindowSample &b) { return a.vtx_count > b.vtx_count; });
+        if (ImGui::BeginTable("##windows", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+            ImGui::TableSetupColumn("window");
+            ImGui::TableSetupColumn("vtx");
+            ImGui::TableSetupColumn("idx");
+            ImGui::TableSetupColumn("draw calls");
+            ImGui::TableHeadersRow();
+            for (const auto &w : windows) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(this->window_name(w.id).c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", w.vtx_count);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", w.idx_count);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", w.draw_calls);
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
@@ -0,0 +1,90 @@
+#include "gpu_frame_timer.h"
+
+#include <algorithm>
+
+GpuFrameTimer::GpuFrameTimer(VulkanHelper *vk, uint32_t slots) : vk_(vk) {
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(vk->data.physicalDevice, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(vk->data.physicalDevice, &count, families.data());
+    const uint32_t bits = vk->data.queueFamily < count ? families[vk->data.queueFamily].timestampValidBits : 0;
+    if (bits == 0)
+        return;
+    this->mask_ = bits >= 64 ? ~0ull : (1ull << bits) - 1;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(vk->data.physicalDevice, &properties);
+    this->periodNs_ = static_cast<double>(properties.limits.timestampPeriod);
+    this->create_pool(slots);
+}
+
+GpuFrameTimer::~GpuFrameTimer() { this->destroy_pool(); }
+
+auto GpuFrameTimer::create_pool(uint32_t slots) -> void {
+    slots = std::max(slots, 1u);
+    VkQueryPoolCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    info.queryCount = 2 * slots;
+    VkResult err = vkCreateQueryPool(this->vk_->data.device, &info, this->vk_->data.allocator, &this->pool_);
+    VulkanHelper::check_vk_result(err);
+    this->slots_.assign(slots, Slot{});
+}
+
+auto GpuFrameTimer::destroy_pool() -> void {
+    if (this->pool_ == VK_NULL_HANDLE)
+        return;
+    vkDestroyQueryPool(this->vk_->data.device, this->pool_, this->vk_->data.allocator);
+    this->pool_ = VK_NULL_HANDLE;
+    this->slots_.clear();
+}
+
+auto GpuFrameTimer::reset(uint32_t slots) -> void {
+    if (!this->supported())
+        return;
+    if (std::max(slots, 1u) == this->slots_.size()) {
+        std::fill(this->slots_.begin(), this->slots_.end(), Slot{});
+        return;
+    }
+    this->destroy_pool();
+    this->create_pool(slots);
+}
+
+auto GpuFrameTimer::begin(VkCommandBuffer cmd, uint32_t slot, uint64_t tag) -> void {
+    if (!this->supported() || slot >= this->slots_.size())
+        return;
+    // The reset runs on the GPU ahead of the new timestamps, after the previous ones were read by collect().
+    vkCmdResetQueryPool(cmd, this->pool_, 2 * slot, 2);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, this->pool_, 2 * slot);
+    this->slots_[slot].tag = tag;
+    this->slots_[slot].pending = false;
+}
+
+auto GpuFrameTimer::end(VkCommandBuffer cmd, uint32_t slot) -> void {
+    if (!this->supported() || slot >= this->slots_.size())
+        return;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, this->pool_, 2 * slot + 1);
+    this->slots_[slot].pending = true;
+}
+
+auto GpuFrameTimer::collect(uint32_t slot) -> void {
+    if (!this->supported() || slot >= this->slots_.size() || !this->slots_[slot].pending)
+        return;
+    Slot &s = this->slots_[slot];
+    s.pending = false;
+    // No WAIT flag: the submission is known to be complete, so VK_NOT_READY only means the frame was abandoned.
+    uint64_t values[4] = {};  // begin, available, end, available
+    VkResult err = vkGetQueryPoolResults(this->vk_->data.device, this->pool_, 2 * slot, 2, sizeof(values), values,
+                                         2 * sizeof(uint64_t),
+                                         VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (err == VK_NOT_READY || !values[1] || !values[3])
+        return;
+    VulkanHelper::check_vk_result(err);
+    const uint64_t ticks = (values[2] - values[0]) & this->mask_;
+    this->done_.push_back(GpuFrameTiming{s.tag, static_cast<uint64_t>(static_cast<double>(ticks) * this->periodNs_)});
+}
+
+auto GpuFrameTimer::take(std::vector<GpuFrameTiming> &out) -> void {
+    out.clear();
+    out.swap(this->done_);
+}
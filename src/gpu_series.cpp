@@ -0,0 +1,516 @@
+#include "gpu_series.h"
+
+#include <imgui.h>
+#include <imgui_impl_vulkan.h>
+#include <implot.h>
+#include <implot_internal.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// SPIR-V generated from shaders/gpu_series.{vert,frag} by glslc at build time (see CMakeLists.txt).
+const uint32_t kVertSpv[] = {
+#include "gpu_series.vert.inc"
+};
+const uint32_t kFragSpv[] = {
+#include "gpu_series.frag.inc"
+};
+
+struct PushConstants {
+    float scale[2];
+    float offset[2];
+    float color[4];
+    float pointSize;
+};
+
+thread_local GpuSeriesRenderer *t_current = nullptr;
+
+auto create_shader(VkDevice device, const VkAllocationCallbacks *allocator, const uint32_t *code, size_t size)
+    -> VkShaderModule {
+    VkShaderModuleCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.codeSize = size;
+    info.pCode = code;
+    VkShaderModule module;
+    VkResult err = vkCreateShaderModule(device, &info, allocator, &module);
+    VulkanHelper::check_vk_result(err);
+    return module;
+}
+
+auto draw_callback(const ImDrawList *, const ImDrawCmd *cmd) -> void {
+    const auto *draw = static_cast<const GpuSeriesRenderer::Draw *>(cmd->UserCallbackData);
+    const auto *state = static_cast<ImGui_ImplVulkan_RenderState *>(ImGui::GetPlatformIO().Renderer_RenderState);
+    draw->renderer->record(state->CommandBuffer, *draw, cmd->ClipRect);
+}
+
+}  // namespace
+
+GpuSeries::GpuSeries(std::shared_ptr<VulkanHelper> vk, VulkanQueue queue, size_t capacity)
+    : vk_(std::move(vk)), queue_(queue), capacity_(capacity) {
+    const VkDevice device = this->vk_->data.device;
+    const VkAllocationCallbacks *allocator = this->vk_->data.allocator;
+    VkResult err;
+
+    // Device-local vertex buffer
+    {
+        VkBufferCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.size = std::max<VkDeviceSize>(capacity, 1) * 2 * sizeof(float);
+        info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        err = vkCreateBuffer(device, &info, allocator, &this->buffer_);
+        VulkanHelper::check_vk_result(err);
+
+        VkMemoryRequirements req;
+        vkGetBufferMemoryRequirements(device, this->buffer_, &req);
+        VkMemoryAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = req.size;
+        alloc_info.memoryTypeIndex = this->vk_->FindMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (alloc_info.memoryTypeIndex == UINT32_MAX)  // software rasterizers may not flag any heap device-local
+            alloc_info.memoryTypeIndex = this->vk_->FindMemoryType(req.memoryTypeBits, 0);
+        err = vkAllocateMemory(device, &alloc_info, allocator, &this->memory_);
+        VulkanHelper::check_vk_result(err);
+        err = vkBindBufferMemory(device, this->buffer_, this->memory_, 0);
+        VulkanHelper::check_vk_result(err);
+    }
+
+    // Persistently mapped staging buffer, reused for every upload chunk
+    {
+        VkBufferCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.size = kStagingPoints * 2 * sizeof(float);
+        info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        err = vkCreateBuffer(device, &info, allocator, &this->staging_);
+        VulkanHelper::check_vk_result(err);
+
+        VkMemoryRequirements req;
+        vkGetBufferMemoryRequirements(device, this->staging_, &req);
+        VkMemoryAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = req.size;
+        alloc_info.memoryTypeIndex = this->vk_->FindMemoryType(
+            req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        this->stagingCoherent_ = alloc_info.memoryTypeIndex != UINT32_MAX;
+        if (!this->stagingCoherent_)
+            alloc_info.memoryTypeIndex =
+                this->vk_->FindMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        if (alloc_info.memoryTypeIndex == UINT32_MAX)
+            throw std::runtime_error("Vulkan: no host-visible memory type for staging");
+        err = vkAllocateMemory(device, &alloc_info, allocator, &this->stagingMemory_);
+        VulkanHelper::check_vk_result(err);
+        err = vkBindBufferMemory(device, this->staging_, this->stagingMemory_, 0);
+        VulkanHelper::check_vk_result(err);
+        void *mapped = nullptr;
+        err = vkMapMemory(device, this->stagingMemory_, 0, VK_WHOLE_SIZE, 0, &mapped);
+        VulkanHelper::check_vk_result(err);
+        this->stagingMapped_ = static_cast<float *>(mapped);
+    }
+
+    // Upload command buffer and fence
+    {
+        VkCommandPoolCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        info.queueFamilyIndex = this->vk_->data.queueFamily;
+        err = vkCreateCommandPool(device, &info, allocator, &this->commandPool_);
+        VulkanHelper::check_vk_result(err);
+
+        VkCommandBufferAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = this->commandPool_;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandBufferCount = 1;
+        err = vkAllocateCommandBuffers(device, &alloc_info, &this->commandBuffer_);
+        VulkanHelper::check_vk_result(err);
+
+        VkFenceCreateInfo fence_info = {};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        err = vkCreateFence(device, &fence_info, allocator, &this->fence_);
+        VulkanHelper::check_vk_result(err);
+    }
+}
+
+GpuSeries::~GpuSeries() {
+    const VkDevice device = this->vk_->data.device;
+    const VkAllocationCallbacks *allocator = this->vk_->data.allocator;
+    {
+        // Frames already submitted may still read the buffer.
+        std::scoped_lock lock(*this->queue_.mutex);
+        vkQueueWaitIdle(this->queue_.queue);
+    }
+    vkDestroyFence(device, this->fence_, allocator);
+    vkDestroyCommandPool(device, this->commandPool_, allocator);
+    if (this->stagingMapped_)
+        vkUnmapMemory(device, this->stagingMemory_);
+    vkDestroyBuffer(device, this->staging_, allocator);
+    vkFreeMemory(device, this->stagingMemory_, allocator);
+    vkDestroyBuffer(device, this->buffer_, allocator);
+    vkFreeMemory(device, this->memory_, allocator);
+}
+
+// New points go to [size(), size() + count), a range no submitted frame reads, so the copy never waits for
+// rendering; the barrier orders it before any later frame's vertex fetch on the same queue.
+auto GpuSeries::append(const double *xs, const double *ys, size_t count) -> void {
+    if (count == 0)
+        return;
+    std::scoped_lock lock(this->mutex_);
+    size_t done = this->count_.load(std::memory_order_relaxed);
+    if (count > this->capacity_ - done)
+        throw std::length_error("GpuSeries: append past capacity");
+    if (done == 0) {
+        this->originX_ = xs[0];
+        this->originY_ = ys[0];
+        this->xMin_ = this->xMax_ = xs[0];
+        this->yMin_ = this->yMax_ = ys[0];
+    }
+
+    const VkDevice device = this->vk_->data.device;
+    VkResult err;
+    for (size_t first = 0; first < count;) {
+        const size_t n = std::min(kStagingPoints, count - first);
+        float *out = this->stagingMapped_;
+        for (size_t i = 0; i < n; ++i) {
+            const double x = xs[first + i];
+            const double y = ys[first + i];
+            this->xMin_ = std::min(this->xMin_, x);
+            this->xMax_ = std::max(this->xMax_, x);
+            this->yMin_ = std::min(this->yMin_, y);
+            this->yMax_ = std::max(this->yMax_, y);
+            out[2 * i] = static_cast<float>(x - this->originX_);
+            out[2 * i + 1] = static_cast<float>(y - this->originY_);
+        }
+        const VkDeviceSize bytes = n * 2 * sizeof(float);
+        if (!this->stagingCoherent_) {
+            VkMappedMemoryRange range = {};
+            range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = this->stagingMemory_;
+            range.size = VK_WHOLE_SIZE;
+            err = vkFlushMappedMemoryRanges(device, 1, &range);
+            VulkanHelper::check_vk_result(err);
+        }
+
+        err = vkResetCommandPool(device, this->commandPool_, 0);
+        VulkanHelper::check_vk_result(err);
+        VkCommandBufferBeginInfo begin = {};
+        begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        err = vkBeginCommandBuffer(this->commandBuffer_, &begin);
+        VulkanHelper::check_vk_result(err);
+
+        VkBufferCopy region = {};
+        region.dstOffset = (done + first) * 2 * sizeof(float);
+        region.size = bytes;
+        vkCmdCopyBuffer(this->commandBuffer_, this->staging_, this->buffer_, 1, &region);
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = this->buffer_;
+        barrier.offset = region.dstOffset;
+        barrier.size = bytes;
+        vkCmdPipelineBarrier(this->commandBuffer_, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        err = vkEndCommandBuffer(this->commandBuffer_);
+        VulkanHelper::check_vk_result(err);
+
+        VkSubmitInfo submit = {};
+        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &this->commandBuffer_;
+        {
+            std::scoped_lock queue_lock(*this->queue_.mutex);
+            err = vkQueueSubmit(this->queue_.queue, 1, &submit, this->fence_);
+        }
+        VulkanHelper::check_vk_result(err);
+        // The staging buffer is reused by the next chunk.
+        err = vkWaitForFences(device, 1, &this->fence_, VK_TRUE, UINT64_MAX);
+        VulkanHelper::check_vk_result(err);
+        err = vkResetFences(device, 1, &this->fence_);
+        VulkanHelper::check_vk_result(err);
+        first += n;
+    }
+    this->count_.store(done + count, std::memory_order_release);
+}
+
+auto GpuSeries::bounds(double &x_min, double &x_max, double &y_min, double &y_max) const -> bool {
+    std::scoped_lock lock(this->mutex_);
+    if (this->count_.load(std::memory_order_relaxed) == 0)
+        return false;
+    x_min = this->xMin_;
+    x_max = this->xMax_;
+    y_min = this->yMin_;
+    y_max = this->yMax_;
+    return true;
+}
+
+GpuSeriesRenderer::GpuSeriesRenderer(VulkanHelper *vk, VkRenderPass render_pass) : vk_(vk), renderPass_(render_pass) {
+    if (!available())
+        throw std::runtime_error("GpuSeries: built without glslc, shaders unavailable");
+    const VkDevice device = vk->data.device;
+    const VkAllocationCallbacks *allocator = vk->data.allocator;
+
+    this->vert_ = create_shader(device, allocator, kVertSpv, sizeof(kVertSpv));
+    this->frag_ = create_shader(device, allocator, kFragSpv, sizeof(kFragSpv));
+
+    if (vk->features.largePoints) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(vk->data.physicalDevice, &properties);
+        this->pointSizeRange_[0] = properties.limits.pointSizeRange[0];
+        this->pointSizeRange_[1] = properties.limits.pointSizeRange[1];
+    }
+
+    VkPushConstantRange range = {};
+    range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    range.size = sizeof(PushConstants);
+    VkPipelineLayoutCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.pushConstantRangeCount = 1;
+    info.pPushConstantRanges = &range;
+    VkResult err = vkCreatePipelineLayout(device, &info, allocator, &this->layout_);
+    VulkanHelper::check_vk_result(err);
+}
+
+GpuSeriesRenderer::~GpuSeriesRenderer() {
+    const VkDevice device = this->vk_->data.device;
+    const VkAllocationCallbacks *allocator = this->vk_->data.allocator;
+    this->destroy_pipelines();
+    vkDestroyPipelineLayout(device, this->layout_, allocator);
+    vkDestroyShaderModule(device, this->frag_, allocator);
+    vkDestroyShaderModule(device, this->vert_, allocator);
+    if (t_current == this)
+        t_current = nullptr;
+}
+
+auto GpuSeriesRenderer::available() -> bool { return kVertSpv[0] == 0x07230203 && kFragSpv[0] == 0x07230203; }
+
+auto GpuSeriesRenderer::current() -> GpuSeriesRenderer * { return t_current; }
+
+auto GpuSeriesRenderer::set_current(GpuSeriesRenderer *renderer) -> void { t_current = renderer; }
+
+// Called after the swapchain was rebuilt, with the queues idle, so the old pipelines are no longer in use.
+auto GpuSeriesRenderer::set_render_pass(VkRenderPass render_pass) -> void {
+    if (render_pass == this->renderPass_)
+        return;
+    this->destroy_pipelines();
+    this->renderPass_ = render_pass;
+}
+
+auto GpuSeriesRenderer::destroy_pipelines() -> void {
+    for (VkPipeline &pipeline : this->pipelines_) {
+        vkDestroyPipeline(this->vk_->data.device, pipeline, this->vk_->data.allocator);
+        pipeline = VK_NULL_HANDLE;
+    }
+}
+
+// Same fixed-function state as the ImGui backend pipeline (straight alpha blending, no depth, no culling) so the
+// series composes with the rest of the plot; only the topology differs.
+auto GpuSeriesRenderer::pipeline(GpuSeriesMode mode) -> VkPipeline {
+    VkPipeline &pipeline = this->pipelines_[static_cast<size_t>(mode)];
+    if (pipeline)
+        return pipeline;
+
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = this->vert_;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = this->frag_;
+    stages[1].pName = "main";
+
+    VkVertexInputBindingDescription binding = {};
+    binding.stride = 2 * sizeof(float);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    VkVertexInputAttributeDescription attribute = {};
+    attribute.location = 0;
+    attribute.binding = 0;
+    attribute.format = VK_FORMAT_R32G32_SFLOAT;
+    VkPipelineVertexInputStateCreateInfo vertex_info = {};
+    vertex_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_info.vertexBindingDescriptionCount = 1;
+    vertex_info.pVertexBindingDescriptions = &binding;
+    vertex_info.vertexAttributeDescriptionCount = 1;
+    vertex_info.pVertexAttributeDescriptions = &attribute;
+
+    VkPipelineInputAssemblyStateCreateInfo ia_info = {};
+    ia_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    ia_info.topology =
+        mode == GpuSeriesMode::Lines ? VK_PRIMITIVE_TOPOLOGY_LINE_STRIP : VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+
+    VkPipelineViewportStateCreateInfo viewport_info = {};
+    viewport_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_info.viewportCount = 1;
+    viewport_info.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo raster_info = {};
+    raster_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    raster_info.polygonMode = VK_POLYGON_MODE_FILL;
+    raster_info.cullMode = VK_CULL_MODE_NONE;
+    raster_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    raster_info.lineWidth = 1.0f;  // wider lines need the optional wideLines feature
+
+    VkPipelineMultisampleStateCreateInfo ms_info = {};
+    ms_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    ms_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState color_attachment = {};
+    color_attachment.blendEnable = VK_TRUE;
+    color_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    color_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    color_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    color_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    color_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    color_attachment.colorWriteMask =
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depth_info = {};
+    depth_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+
+    VkPipelineColorBlendStateCreateInfo blend_info = {};
+    blend_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    blend_info.attachmentCount = 1;
+    blend_info.pAttachments = &color_attachment;
+
+    VkDynamicState dynamic_states[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic_state = {};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = 2;
+    dynamic_state.pDynamicStates = dynamic_states;
+
+    VkGraphicsPipelineCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    info.stageCount = 2;
+    info.pStages = stages;
+    info.pVertexInputState = &vertex_info;
+    info.pInputAssemblyState = &ia_info;
+    info.pViewportState = &viewport_info;
+    info.pRasterizationState = &raster_info;
+    info.pMultisampleState = &ms_info;
+    info.pDepthStencilState = &depth_info;
+    info.pColorBlendState = &blend_info;
+    info.pDynamicState = &dynamic_state;
+    info.layout = this->layout_;
+    info.renderPass = this->renderPass_;
+    info.subpass = 0;
+    VkResult err = vkCreateGraphicsPipelines(this->vk_->data.device, this->vk_->data.pipelineCache, 1, &info,
+                                             this->vk_->data.allocator, &pipeline);
+    VulkanHelper::check_vk_result(err);
+    return pipeline;
+}
+
+// Runs inside ImGui_ImplVulkan_RenderDrawData; the ImDrawCallback_ResetRenderState queued after this callback
+// restores the backend's pipeline, buffers and scissor.
+auto GpuSeriesRenderer::record(VkCommandBuffer cb, const Draw &draw, const ImVec4 &clip_rect) -> void {
+    if (draw.count < (draw.mode == GpuSeriesMode::Lines ? 2u : 1u))
+        return;
+    const ImDrawData *draw_data = ImGui::GetDrawData();
+    const ImVec2 clip_off = draw_data->DisplayPos;
+    const ImVec2 clip_scale = draw_data->FramebufferScale;
+    const float fb_width = draw_data->DisplaySize.x * clip_scale.x;
+    const float fb_height = draw_data->DisplaySize.y * clip_scale.y;
+
+    const float x0 = std::max((clip_rect.x - clip_off.x) * clip_scale.x, 0.0f);
+    const float y0 = std::max((clip_rect.y - clip_off.y) * clip_scale.y, 0.0f);
+    const float x1 = std::min((clip_rect.z - clip_off.x) * clip_scale.x, fb_width);
+    const float y1 = std::min((clip_rect.w - clip_off.y) * clip_scale.y, fb_height);
+    if (x1 <= x0 || y1 <= y0)
+        return;
+    VkRect2D scissor;
+    scissor.offset.x = static_cast<int32_t>(x0);
+    scissor.offset.y = static_cast<int32_t>(y0);
+    scissor.extent.width = static_cast<uint32_t>(x1 - x0);
+    scissor.extent.height = static_cast<uint32_t>(y1 - y0);
+
+    VkViewport viewport;
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = fb_width;
+    viewport.height = fb_height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    // pixel -> NDC folded into the plot transform in double; only the final affine is rounded to float.
+    const double sx = 2.0 / draw_data->DisplaySize.x;
+    const double sy = 2.0 / draw_data->DisplaySize.y;
+    PushConstants pc;
+    pc.scale[0] = static_cast<float>(draw.ax * sx);
+    pc.scale[1] = static_cast<float>(draw.ay * sy);
+    pc.offset[0] = static_cast<float>((draw.bx - clip_off.x) * sx - 1.0);
+    pc.offset[1] = static_cast<float>((draw.by - clip_off.y) * sy - 1.0);
+    std::memcpy(pc.color, draw.color, sizeof(pc.color));
+    pc.pointSize = std::clamp(draw.point_size * clip_scale.x, this->pointSizeRange_[0], this->pointSizeRange_[1]);
+
+    const VkDeviceSize offset = 0;
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline(draw.mode));
+    vkCmdSetViewport(cb, 0, 1, &viewport);
+    vkCmdSetScissor(cb, 0, 1, &scissor);
+    vkCmdBindVertexBuffers(cb, 0, 1, &draw.buffer, &offset);
+    vkCmdPushConstants(cb, this->layout_, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pc), &pc);
+    vkCmdDraw(cb, draw.count, 1, 0, 0);
+}
+
+auto PlotGpuSeries(const char *label, const GpuSeries &series, GpuSeriesMode mode, ImPlotItemFlags flags) -> void {
+    GpuSeriesRenderer *renderer = GpuSeriesRenderer::current();
+    IM_ASSERT_USER_ERROR(renderer != nullptr, "PlotGpuSeries() needs an ImPlotEngine render thread");
+    if (!renderer)
+        return;
+    if (!ImPlot::BeginItem(label, flags, mode == GpuSeriesMode::Lines ? ImPlotCol_Line : ImPlotCol_MarkerFill))
+        return;
+
+    ImPlotPlot &plot = *ImPlot::GetCurrentPlot();
+    ImPlotAxis &x_axis = plot.Axes[plot.CurrentX];
+    ImPlotAxis &y_axis = plot.Axes[plot.CurrentY];
+    IM_ASSERT_USER_ERROR(x_axis.TransformForward == nullptr && y_axis.TransformForward == nullptr,
+                         "PlotGpuSeries() supports linear axes only");
+
+    // Acquire-loaded first: the origin is published with the first points and never changes afterwards.
+    const size_t count = series.size();
+    double x_min, x_max, y_min, y_max;
+    if (series.bounds(x_min, x_max, y_min, y_max) && plot.FitThisFrame && !ImHasFlag(flags, ImPlotItemFlags_NoFit)) {
+        x_axis.ExtendFitWith(y_axis, x_min, y_min);
+        x_axis.ExtendFitWith(y_axis, x_max, y_max);
+        y_axis.ExtendFitWith(x_axis, y_min, x_min);
+        y_axis.ExtendFitWith(x_axis, y_max, x_max);
+    }
+
+    if (count == 0) {
+        ImPlot::EndItem();
+        return;
+    }
+
+    const ImPlotNextItemData &style = ImPlot::GetItemData();
+    const ImVec4 &color = style.Colors[mode == GpuSeriesMode::Lines ? ImPlotCol_Line : ImPlotCol_MarkerFill];
+    GpuSeriesRenderer::Draw draw;
+    draw.renderer = renderer;
+    draw.buffer = series.buffer();
+    draw.count = static_cast<uint32_t>(count);
+    draw.mode = mode;
+    draw.color[0] = color.x;
+    draw.color[1] = color.y;
+    draw.color[2] = color.z;
+    draw.color[3] = color.w;
+    draw.point_size = 2.0f * style.MarkerSize;
+    // Stored points are offsets from the series origin; fold the origin into b in double precision.
+    const double kx = (x_axis.PixelMax - x_axis.PixelMin) / (x_axis.Range.Max - x_axis.Range.Min);
+    const double ky = (y_axis.PixelMax - y_axis.PixelMin) / (y_axis.Range.Max - y_axis.Range.Min);
+    draw.ax = kx;
+    draw.bx = x_axis.PixelMin + (series.origin_x() - x_axis.Range.Min) * kx;
+    draw.ay = ky;
+    draw.by = y_axis.PixelMin + (series.origin_y() - y_axis.Range.Min) * ky;
+
+    ImDrawList *dl = ImPlot::GetPlotDrawList();
+    ImPlot::PushPlotClipRect();
+    dl->AddCallback(draw_callback, &draw, sizeof(draw));
+    dl->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    ImPlot::PopPlotClipRect();
+    ImPlot::EndItem();
+}
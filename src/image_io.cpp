@@ -0,0 +1,112 @@
+#include "image_io.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+static auto crc_table() -> const std::array<uint32_t, 256> & {
+    static const auto table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+static auto crc32(uint32_t crc, const uint8_t *data, size_t size) -> uint32_t {
+    const auto &table = crc_table();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static auto put_be32(std::vector<uint8_t> &out, uint32_t v) -> void {
+    out.push_back(static_cast<uint8_t>(v >> 24));
+    out.push_back(static_cast<uint8_t>(v >> 16));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+static auto put_chunk(std::ofstream &file, const char type[4], const std::vector<uint8_t> &payload) -> void {
+    std::vector<uint8_t> chunk;
+    chunk.reserve(payload.size() + 12);
+    put_be32(chunk, static_cast<uint32_t>(payload.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), payload.begin(), payload.end());
+    put_be32(chunk, crc32(0, chunk.data() + 4, payload.size() + 4));
+    file.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+auto WritePngRGBA(const std::string &path, const uint8_t *rgba, uint32_t width, uint32_t height) -> void {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+    std::vector<uint8_t> ihdr;
+    put_be32(ihdr, width);
+    put_be32(ihdr, height);
+    ihdr.insert(ihdr.end(), {8, 6, 0, 0, 0});  // 8 bit, RGBA, deflate, adaptive filtering, no interlace
+    put_chunk(file, "IHDR", ihdr);
+
+    // Scanlines with filter byte 0, wrapped in a zlib stream made of stored (uncompressed) deflate blocks.
+    const size_t row = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((row + 1) * height);
+    for (uint32_t y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba + y * row, rgba + (y + 1) * row);
+    }
+
+    std::vector<uint8_t> idat;
+    idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+    uint32_t a = 1, b = 0;
+    size_t pos = 0;
+    do {
+        const size_t len = std::min<size_t>(raw.size() - pos, 65535);
+        const bool last = pos + len == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(static_cast<uint8_t>(len));
+        idat.push_back(static_cast<uint8_t>(len >> 8));
+        idat.push_back(static_cast<uint8_t>(~len));
+        idat.push_back(static_cast<uint8_t>(~len >> 8));
+        idat.insert(idat.end(), raw.begin() + static_cast<ptrdiff_t>(pos),
+                    raw.begin() + static_cast<ptrdiff_t>(pos + len));
+        for (size_t i = pos; i < pos + len; i++) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        pos += len;
+    } while (pos < raw.size());
+    put_be32(idat, (b << 16) | a);
+    put_chunk(file, "IDAT", idat);
+
+    put_chunk(file, "IEND", {});
+    if (!file) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+auto WriteRawRGBA(const std::string &path, const uint8_t *rgba, uint32_t width, uint32_t height) -> void {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    file.write(reinterpret_cast<const char *>(rgba), static_cast<std::streamsize>(width) * height * 4);
+    if (!file) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
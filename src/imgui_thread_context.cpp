@@ -0,0 +1,7 @@
+// Thread-local current contexts declared in imgui_user_config.h. Built into the imgui target, which ImPlot and
+// ImPlot3D link against, so the definitions are found whichever library references them first.
+#include "imgui_user_config.h"
+
+thread_local ImGuiContext *ImPlotUtilImGuiContext = nullptr;
+thread_local ImPlotContext *ImPlotUtilImPlotContext = nullptr;
+thread_local ImPlot3DContext *ImPlotUtilImPlot3DContext = nullptr;
@@ -0,0 +1,248 @@
+#include "implot_decimate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "simd_lanes.h"
+
+namespace {
+
+struct MinMaxIndex {
+    size_t imin;
+    size_t imax;
+};
+
+// Index of the smallest and largest value in v[0, n), first occurrence on ties. n must be > 0.
+auto minmax_index(const double *v, size_t n) -> MinMaxIndex {
+    using L = simd::Lanes;
+    size_t i = 0;
+    MinMaxIndex r{0, 0};
+    if (n >= L::width) {
+        auto vmin = L::load(v);
+        auto vmax = vmin;
+        auto idx = L::iota();
+        auto imin = idx;
+        auto imax = idx;
+        const auto step = L::set1(static_cast<double>(L::width));
+        for (i = L::width; i + L::width <= n; i += L::width) {
+            idx = L::add(idx, step);
+            const auto x = L::load(v + i);
+            const auto lt = L::lt(x, vmin);
+            const auto gt = L::lt(vmax, x);
+            vmin = L::select(lt, x, vmin);
+            imin = L::select(lt, idx, imin);
+            vmax = L::select(gt, x, vmax);
+            imax = L::select(gt, idx, imax);
+        }
+        double lmin[L::width], lmax[L::width], limin[L::width], limax[L::width];
+        L::store(lmin, vmin);
+        L::store(lmax, vmax);
+        L::store(limin, imin);
+        L::store(limax, imax);
+        r = MinMaxIndex{static_cast<size_t>(limin[0]), static_cast<size_t>(limax[0])};
+        for (size_t l = 1; l < L::width; ++l) {
+            const auto cmin = static_cast<size_t>(limin[l]);
+            const auto cmax = static_cast<size_t>(limax[l]);
+            if (lmin[l] < v[r.imin] || (lmin[l] == v[r.imin] && cmin < r.imin))
+                r.imin = cmin;
+            if (lmax[l] > v[r.imax] || (lmax[l] == v[r.imax] && cmax < r.imax))
+                r.imax = cmax;
+        }
+    } else {
+        i = 1;
+    }
+    for (; i < n; ++i) {
+        if (v[i] < v[r.imin])
+            r.imin = i;
+        if (v[i] > v[r.imax])
+            r.imax = i;
+    }
+    return r;
+}
+
+// Index maximising |a * x + b * y + c| over [0, n). This is the LTTB triangle area up to a constant factor.
+auto argmax_abs_affine(const double *xs, const double *ys, size_t n, double a, double b, double c) -> size_t {
+    using L = simd::Lanes;
+    size_t i = 0;
+    size_t best = 0;
+    double best_v = -1.0;
+    if (n >= L::width) {
+        const auto va = L::set1(a);
+        const auto vb = L::set1(b);
+        const auto vc = L::set1(c);
+        const auto step = L::set1(static_cast<double>(L::width));
+        auto idx = L::iota();
+        auto vbest = L::set1(-1.0);
+        auto ibest = idx;
+        for (; i + L::width <= n; i += L::width) {
+            const auto area = L::abs(L::add(L::add(L::mul(va, L::load(xs + i)), L::mul(vb, L::load(ys + i))), vc));
+            const auto gt = L::lt(vbest, area);
+            vbest = L::select(gt, area, vbest);
+            ibest = L::select(gt, idx, ibest);
+            idx = L::add(idx, step);
+        }
+        double lv[L::width], li[L::width];
+        L::store(lv, vbest);
+        L::store(li, ibest);
+        for (size_t l = 0; l < L::width; ++l) {
+            const auto ci = static_cast<size_t>(li[l]);
+            if (lv[l] > best_v || (lv[l] == best_v && ci < best)) {
+                best_v = lv[l];
+                best = ci;
+            }
+        }
+    }
+    for (; i < n; ++i) {
+        const double area = std::abs(a * xs[i] + b * ys[i] + c);
+        if (area > best_v) {
+            best_v = area;
+            best = i;
+        }
+    }
+    return best;
+}
+
+struct VisibleRange {
+    size_t begin;  // first sample with x >= x_min
+    size_t end;    // one past the last sample with x <= x_max
+};
+
+auto visible_range(const double *xs, size_t n, double x_min, double x_max) -> VisibleRange {
+    const auto *b = std::lower_bound(xs, xs + n, x_min);
+    const auto *e = std::upper_bound(b, xs + n, x_max);
+    return VisibleRange{static_cast<size_t>(b - xs), static_cast<size_t>(e - xs)};
+}
+
+}  // namespace
+
+auto SeriesDecimator::minmax(const double *xs, const double *ys, size_t n, double x_min, double x_max,
+                             int pixel_width) -> View {
+    if (n == 0 || pixel_width <= 0 || !(x_max > x_min)) {
+        return View{xs, ys, static_cast<int>(std::min<size_t>(n, INT32_MAX))};
+    }
+    const auto cols = static_cast<size_t>(pixel_width);
+    const auto [vb, ve] = visible_range(xs, n, x_min, x_max);
+    if (ve - vb <= 4 * cols) {
+        const auto first = vb > 0 ? vb - 1 : vb;
+        const auto last = ve < n ? ve + 1 : ve;
+        return View{xs + first, ys + first, static_cast<int>(std::min<size_t>(last - first, INT32_MAX))};
+    }
+
+    this->xs_.clear();
+    this->ys_.clear();
+    this->xs_.reserve(4 * cols + 2);
+    this->ys_.reserve(4 * cols + 2);
+
+    if (vb > 0)
+        this->emit(xs[vb - 1], ys[vb - 1]);
+
+    const double units_per_px = (x_max - x_min) / static_cast<double>(cols);
+    size_t start = vb;
+    for (size_t c = 0; c < cols && start < ve; ++c) {
+        const double edge = x_min + units_per_px * static_cast<double>(c + 1);
+        const auto end = c + 1 == cols ? ve : static_cast<size_t>(std::lower_bound(xs + start, xs + ve, edge) - xs);
+        const auto count = end - start;
+        if (count == 0)
+            continue;
+        if (count <= 4) {
+            for (size_t i = start; i < end; ++i)
+                this->emit(xs[i], ys[i]);
+        } else {
+            const auto [lo, hi] = minmax_index(ys + start, count);
+            const size_t picks[4] = {0, std::min(lo, hi), std::max(lo, hi), count - 1};
+            for (size_t k = 0; k < 4; ++k) {
+                if (k > 0 && picks[k] == picks[k - 1])
+                    continue;
+                this->emit(xs[start + picks[k]], ys[start + picks[k]]);
+            }
+        }
+        start = end;
+    }
+
+    if (ve < n)
+        this->emit(xs[ve], ys[ve]);
+
+    return this->view();
+}
+
+auto SeriesDecimator::lttb(const double *xs, const double *ys, size_t n, double x_min, double x_max,
+                           size_t threshold) -> View {
+    if (n == 0 || !(x_max > x_min)) {
+        return View{xs, ys, static_cast<int>(std::min<size_t>(n, INT32_MAX))};
+    }
+    auto [vb, ve] = visible_range(xs, n, x_min, x_max);
+    // Keep the neighbouring samples so the line reaches the plot edges; LTTB always keeps the endpoints.
+    if (vb > 0)
+        --vb;
+    if (ve < n)
+        ++ve;
+    const auto count = ve - vb;
+    threshold = std::max<size_t>(threshold, 3);
+    if (count <= threshold) {
+        return View{xs + vb, ys + vb, static_cast<int>(std::min<size_t>(count, INT32_MAX))};
+    }
+
+    const double *x = xs + vb;
+    const double *y = ys + vb;
+
+    this->xs_.clear();
+    this->ys_.clear();
+    this->xs_.reserve(threshold);
+    this->ys_.reserve(threshold);
+
+    const double bucket = static_cast<double>(count - 2) / static_cast<double>(threshold - 2);
+    size_t a = 0;
+    this->emit(x[0], y[0]);
+    for (size_t b = 0; b < threshold - 2; ++b) {
+        const auto cur_begin = static_cast<size_t>(std::floor(static_cast<double>(b) * bucket)) + 1;
+        const auto cur_end = std::min(static_cast<size_t>(std::floor(static_cast<double>(b + 1) * bucket)) + 1,
+                                      count - 1);
+        const auto next_begin = cur_end;
+        const auto next_end =
+            std::min(static_cast<size_t>(std::floor(static_cast<double>(b + 2) * bucket)) + 1, count);
+
+        // Average of the next bucket is the third triangle vertex.
+        double cx = 0.0, cy = 0.0;
+        for (size_t i = next_begin; i < next_end; ++i) {
+            cx += x[i];
+            cy += y[i];
+        }
+        const auto next_n = static_cast<double>(std::max<size_t>(next_end - next_begin, 1));
+        cx /= next_n;
+        cy /= next_n;
+
+        // |(ax - cx)(y - ay) - (ax - x)(cy - ay)| expanded into a * x + b * y + c.
+        const double ax = x[a], ay = y[a];
+        const double ka = cy - ay;
+        const double kb = ax - cx;
+        const double kc = -ax * ka - ay * kb;
+        const auto pick = cur_begin + argmax_abs_affine(x + cur_begin, y + cur_begin, cur_end - cur_begin, ka, kb, kc);
+
+        this->emit(x[pick], y[pick]);
+        a = pick;
+    }
+    this->emit(x[count - 1], y[count - 1]);
+
+    return this->view();
+}
+
+auto SeriesDecimator::decimate(DecimateMode mode, const double *xs, const double *ys, size_t n, double x_min,
+                               double x_max, int pixel_width) -> View {
+    switch (mode) {
+    case DecimateMode::Lttb:
+        return this->lttb(xs, ys, n, x_min, x_max, 2 * static_cast<size_t>(std::max(pixel_width, 1)));
+    case DecimateMode::MinMax:
+    default:
+        return this->minmax(xs, ys, n, x_min, x_max, pixel_width);
+    }
+}
+
+auto PlotLineDecimated(const char *label, const double *xs, const double *ys, size_t n, SeriesDecimator &decimator,
+                       DecimateMode mode, ImPlotLineFlags flags) -> void {
+    const ImPlotRect limits = ImPlot::GetPlotLimits();
+    const int width = static_cast<int>(ImPlot::GetPlotSize().x);
+    const auto v = decimator.decimate(mode, xs, ys, n, limits.X.Min, limits.X.Max, width);
+    ImPlot::PlotLine(label, v.xs, v.ys, v.count, flags);
+}
@@ -1,6 +1,8 @@
 #include "implot_engine.h"
 
+#include <algorithm>
 #include <cassert>
+#include <shared_mutex>
 #include <thread>
 
 // Include ImGui / ImPlot headers
@@ -16,6 +18,7 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include "image_io.h"
 #include "scope_helper.h"
 #include "vulkan_helper.h"
 
@@ -23,52 +26,217 @@ static void glfw_error_callback(int error, const char *description) {
     fprintf(stderr, "GLFW Error %d: %s\n", error, description);
 }
 
+namespace {
+
+// GPU measurements of frames the profiler did not record.
+constexpr uint64_t kUntaggedFrame = UINT64_MAX;
+
+// Decided when the library is built, not in the header, so every includer sees the same class.
+#ifdef APP_USE_UNLIMITED_FRAME_RATE
+constexpr VkPresentModeKHR kDefaultPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+#else
+constexpr VkPresentModeKHR kDefaultPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+#endif
+
+// GLFW is process-wide: one glfwInit()/glfwTerminate() pair for all engines, and a single event queue that only
+// one thread at a time may pump. `state` also guards the GLFW backend's global window -> ImGui context table.
+struct GlfwRuntime {
+    std::shared_mutex state;
+    int users = 0;
+    std::mutex pump;
+    std::atomic<int> pumpWaiters{0};
+};
+
+auto glfw_runtime() -> GlfwRuntime & {
+    static GlfwRuntime runtime;
+    return runtime;
+}
+
+auto acquire_glfw() -> void {
+    auto &rt = glfw_runtime();
+    std::scoped_lock state(rt.state);
+    if (rt.users == 0) {
+        glfwSetErrorCallback(glfw_error_callback);
+        if (!glfwInit()) {
+            throw std::runtime_error("Failed to initialize GLFW");
+        }
+    }
+    ++rt.users;
+}
+
+auto release_glfw() -> void {
+    auto &rt = glfw_runtime();
+    std::scoped_lock state(rt.state);
+    if (--rt.users == 0)
+        glfwTerminate();
+}
+
+// Takes the event queue, kicking an engine that sleeps in glfwWaitEventsTimeout() out of it.
+auto lock_pump() -> std::unique_lock<std::mutex> {
+    auto &rt = glfw_runtime();
+    std::unique_lock pump(rt.pump, std::try_to_lock);
+    if (!pump.owns_lock()) {
+        rt.pumpWaiters.fetch_add(1, std::memory_order_acq_rel);
+        glfwPostEmptyEvent();
+        pump.lock();
+        rt.pumpWaiters.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    return pump;
+}
+
+}  // namespace
+
+auto ImPlotEngine::create() -> std::unique_ptr<ImPlotEngine> { return std::unique_ptr<ImPlotEngine>(new ImPlotEngine()); }
+
+// Function-local statics are destroyed in reverse order of construction: constructing the shared pool first keeps
+// it alive for the destructor of an engine that is itself a static (instance()).
+ImPlotEngine::ImPlotEngine() : presentModeRequest_(kDefaultPresentMode) { ThreadPool::shared(); }
+
+ImPlotEngine::~ImPlotEngine() {
+    this->show_stop();
+    this->show_wait();
+    // A detached show thread can be neither stopped nor joined from here, so it must have returned already.
+    IM_ASSERT(!this->showRunning_.load(std::memory_order_acquire));
+    // An engine that was initialized but never shown still owns its contexts and Vulkan objects.
+    this->deinit();
+}
+
 auto ImPlotEngine::init(const std::string &title) -> void {
     std::scoped_lock guard(drawers_mutex_);
-    if (this->window_) {
+    if (this->initialized()) {
         return;
     }
+    this->begin_init();
+    ScopeFail failed([&]() { this->readiness_.store(EngineReadiness::Failed, std::memory_order_release); });
 
     this->title_ = title;
 
-    glfwSetErrorCallback(glfw_error_callback);
-    if (!glfwInit()) {
-        throw std::runtime_error("Failed to initialize GLFW");
-    }
-
-    // Create window with Vulkan context
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    float main_scale = ImGui_ImplGlfw_GetContentScaleForMonitor(glfwGetPrimaryMonitor());  // Valid on GLFW 3.3+ only
-    this->window_ =
-        glfwCreateWindow((int)(1920 * main_scale), (int)(1080 * main_scale), title.c_str(), nullptr, nullptr);
+    acquire_glfw();
+    ScopeFail rollback_glfw([&]() { release_glfw(); });
     if (!glfwVulkanSupported()) {
         throw std::runtime_error("GLFW: Vulkan Not Supported");
     }
 
+    // Instance and device creation is the slowest step of start-up; only the instance extensions depend on GLFW, so
+    // it runs while the window is being created.
     ImVector<const char *> extensions;
     uint32_t extensions_count = 0;
     const char **glfw_extensions = glfwGetRequiredInstanceExtensions(&extensions_count);
     for (uint32_t i = 0; i < extensions_count; i++)
         extensions.push_back(glfw_extensions[i]);
-    this->vulkanHelper_.Setup(extensions);
-    ScopeFail rollback([&]() { this->vulkanHelper_.Cleanup(); });
+    auto device = std::async(std::launch::async, [&extensions]() { return VulkanHelper::Acquire(extensions); });
+
+    // Create window with Vulkan context
+    float main_scale;
+    {
+        auto pump = lock_pump();
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        main_scale = ImGui_ImplGlfw_GetContentScaleForMonitor(glfwGetPrimaryMonitor());  // Valid on GLFW 3.3+ only
+        this->window_ =
+            glfwCreateWindow((int)(1920 * main_scale), (int)(1080 * main_scale), title.c_str(), nullptr, nullptr);
+    }
+    ScopeFail rollback_window([&]() {
+        auto pump = lock_pump();
+        glfwDestroyWindow(this->window_);
+        this->window_ = nullptr;
+    });
+    // Joins the device task even when the window failed, so the reference it returns is released by the rollback.
+    this->vulkanHelper_ = device.get();
+    ScopeFail rollback_device([&]() {
+        this->queue_ = VulkanQueue{};
+        this->vulkanHelper_.reset();
+    });
+    if (!this->window_) {
+        throw std::runtime_error("GLFW: cannot create window");
+    }
+    this->queue_ = this->vulkanHelper_->AcquireQueue();
+    this->descriptorPool_ = this->vulkanHelper_->CreateDescriptorPool();
+    ScopeFail rollback_pool([&]() {
+        this->vulkanHelper_->DestroyDescriptorPool(this->descriptorPool_);
+        this->descriptorPool_ = VK_NULL_HANDLE;
+    });
 
     // Create Window Surface
     VkSurfaceKHR surface;
-    VkResult err = glfwCreateWindowSurface(this->vulkanHelper_.data.instance, this->window_,
-                                           this->vulkanHelper_.data.allocator, &surface);
+    VkResult err = glfwCreateWindowSurface(this->vulkanHelper_->data.instance, this->window_,
+                                           this->vulkanHelper_->data.allocator, &surface);
     VulkanHelper::check_vk_result(err);
+    ImGui_ImplVulkanH_Window *wd = &this->mainWindowData_;
+    wd->Surface = surface;
+    // Destroys the surface, and whatever SetupVulkanWindow() built before it failed (null handles are skipped).
+    ScopeFail rollback_vulkan_window([&]() { this->CleanupVulkanWindow(); });
 
     // Create Framebuffers
     int w, h;
     glfwGetFramebufferSize(this->window_, &w, &h);
-    ImGui_ImplVulkanH_Window *wd = &this->mainWindowData_;
     this->SetupVulkanWindow(wd, surface, w, h);
 
-    // Setup Dear ImGui context
+    this->setup_imgui(main_scale);
+    ScopeFail rollback_contexts([&]() { this->destroy_contexts(); });
+
+    // Setup Platform/Renderer backends. The backend does not install GLFW callbacks: ours queue the input, and the
+    // render thread forwards it (see forward_input()) so this context is only touched from its own thread.
+    this->install_input_callbacks();
+    {
+        std::scoped_lock state(glfw_runtime().state);
+        ImGui_ImplGlfw_InitForVulkan(this->window_, false);
+    }
+    ScopeFail rollback_glfw_backend([&]() {
+        std::scoped_lock state(glfw_runtime().state);
+        ImGui_ImplGlfw_Shutdown();
+    });
+    this->wakeable_.store(true, std::memory_order_release);
+    ScopeFail rollback_wakeable([&]() { this->wakeable_.store(false, std::memory_order_release); });
+    this->init_imgui_vulkan(wd->RenderPass, wd->ImageCount);
+    this->finish_init();
+}
+
+auto ImPlotEngine::init_headless(const std::string &title, uint32_t width, uint32_t height) -> void {
+    std::scoped_lock guard(drawers_mutex_);
+    if (this->initialized()) {
+        return;
+    }
+    this->begin_init();
+    ScopeFail failed([&]() { this->readiness_.store(EngineReadiness::Failed, std::memory_order_release); });
+
+    this->title_ = title;
+
+    // No window system: the instance needs no surface extensions and the device no swapchain.
+    this->vulkanHelper_ = VulkanHelper::Acquire(ImVector<const char *>(), true);
+    ScopeFail rollback_device([&]() {
+        this->queue_ = VulkanQueue{};
+        this->vulkanHelper_.reset();
+    });
+    this->queue_ = this->vulkanHelper_->AcquireQueue();
+    this->descriptorPool_ = this->vulkanHelper_->CreateDescriptorPool();
+    ScopeFail rollback_pool([&]() {
+        this->vulkanHelper_->DestroyDescriptorPool(this->descriptorPool_);
+        this->descriptorPool_ = VK_NULL_HANDLE;
+    });
+
+    this->offscreen_.Create(this->vulkanHelper_.get(), this->queue_, width, height,
+                            this->framesInFlight_.load(std::memory_order_relaxed));
+    ScopeFail rollback_offscreen([&]() { this->offscreen_.Destroy(); });
+
+    this->setup_imgui(1.0f);
+    ScopeFail rollback_contexts([&]() { this->destroy_contexts(); });
+    ImGuiIO &io = ImGui::GetIO();
+    io.DisplaySize = ImVec2((float)width, (float)height);
+    io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
+    io.IniFilename = nullptr;  // Headless runs must not depend on, or rewrite, a user's window layout
+
+    this->init_imgui_vulkan(this->offscreen_.renderPass, this->minImageCount_);
+    this->headless_ = true;
+    this->finish_init();
+}
+
+auto ImPlotEngine::setup_imgui(float main_scale) -> void {
+    // Setup Dear ImGui context. CreateContext() leaves an already current context in place, so bind ours explicitly.
     IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImPlot3D::CreateContext();
+    this->imguiContext_ = ImGui::CreateContext();
+    ImGui::SetCurrentContext(this->imguiContext_);
+    this->implot3dContext_ = ImPlot3D::CreateContext();
+    ImPlot3D::SetCurrentContext(this->implot3dContext_);
     ImGuiIO &io = ImGui::GetIO();
     (void)io;
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;  // Enable Keyboard Controls
@@ -84,7 +252,8 @@ auto ImPlotEngine::init(const std::string &title) -> void {
         IM_ASSERT(io.BackendFlags & ImGuiBackendFlags_RendererHasVtxOffset);
     }
 
-    ImPlot::CreateContext();
+    this->implotContext_ = ImPlot::CreateContext();
+    ImPlot::SetCurrentContext(this->implotContext_);
 
     // Setup Dear ImGui style
     ImGui::StyleColorsDark();
@@ -96,27 +265,50 @@ auto ImPlotEngine::init(const std::string &title) -> void {
                                       // changing this requires resetting Style + calling this again)
     style.FontScaleDpi = main_scale;  // Set initial font scale. (using io.ConfigDpiScaleFonts=true makes this
                                       // unnecessary. We leave both here for documentation purpose)
+}
 
-    // Setup Platform/Renderer backends
-    ImGui_ImplGlfw_InitForVulkan(this->window_, true);
+auto ImPlotEngine::destroy_contexts() -> void {
+    ImPlot3D::DestroyContext(this->implot3dContext_);
+    ImPlot::DestroyContext(this->implotContext_);
+    ImGui::DestroyContext(this->imguiContext_);
+    this->implot3dContext_ = nullptr;
+    this->implotContext_ = nullptr;
+    this->imguiContext_ = nullptr;
+}
+
+auto ImPlotEngine::init_imgui_vulkan(VkRenderPass render_pass, uint32_t image_count) -> void {
     ImGui_ImplVulkan_InitInfo init_info = {};
     // init_info.ApiVersion = VK_API_VERSION_1_3;              // Pass in your value of VkApplicationInfo::apiVersion,
     // otherwise will default to header version.
-    init_info.Instance = this->vulkanHelper_.data.instance;
-    init_info.PhysicalDevice = this->vulkanHelper_.data.physicalDevice;
-    init_info.Device = this->vulkanHelper_.data.device;
-    init_info.QueueFamily = this->vulkanHelper_.data.queueFamily;
-    init_info.Queue = this->vulkanHelper_.data.queue;
-    init_info.PipelineCache = this->vulkanHelper_.data.pipelineCache;
-    init_info.DescriptorPool = this->vulkanHelper_.data.descriptorPool;
+    init_info.Instance = this->vulkanHelper_->data.instance;
+    init_info.PhysicalDevice = this->vulkanHelper_->data.physicalDevice;
+    init_info.Device = this->vulkanHelper_->data.device;
+    init_info.QueueFamily = this->vulkanHelper_->data.queueFamily;
+    init_info.Queue = this->queue_.queue;
+    init_info.PipelineCache = this->vulkanHelper_->data.pipelineCache;
+    init_info.DescriptorPool = this->descriptorPool_;
     init_info.MinImageCount = this->minImageCount_;
-    init_info.ImageCount = wd->ImageCount;
-    init_info.Allocator = this->vulkanHelper_.data.allocator;
-    init_info.PipelineInfoMain.RenderPass = wd->RenderPass;
+    // The backend cycles its vertex/index buffers over ImageCount frames; enough for any frames in flight.
+    init_info.ImageCount = std::max(image_count, VulkanFrameRing::kMaxFrames);
+    init_info.Allocator = this->vulkanHelper_->data.allocator;
+    init_info.PipelineInfoMain.RenderPass = render_pass;
     init_info.PipelineInfoMain.Subpass = 0;
     init_info.PipelineInfoMain.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
     init_info.CheckVkResultFn = VulkanHelper::check_vk_result;
+    const auto start = std::chrono::steady_clock::now();
     ImGui_ImplVulkan_Init(&init_info);
+    ScopeFail rollback_backend([&]() {
+        this->gpuSeriesRenderer_.reset();
+        this->gpuTimer_.reset();
+        ImGui_ImplVulkan_Shutdown();
+    });
+    this->startupStats_.imgui_vulkan_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    this->gpuTimer_ = std::make_unique<GpuFrameTimer>(this->vulkanHelper_.get(), VulkanFrameRing::kMaxFrames);
+    if (GpuSeriesRenderer::available()) {
+        this->gpuSeriesRenderer_ = std::make_unique<GpuSeriesRenderer>(this->vulkanHelper_.get(), render_pass);
+        GpuSeriesRenderer::set_current(this->gpuSeriesRenderer_.get());
+    }
 
     // Load Fonts
     // - If no fonts are loaded, dear imgui will use the default font. You can also load multiple fonts and use
@@ -139,27 +331,141 @@ auto ImPlotEngine::init(const std::string &title) -> void {
     // IM_ASSERT(font != nullptr);
 }
 
+auto ImPlotEngine::init_async(const std::string &title) -> std::shared_future<void> {
+    std::scoped_lock guard(drawers_mutex_);
+    const EngineReadiness state = this->readiness();
+    if (this->initFuture_.valid() && state != EngineReadiness::Failed && state != EngineReadiness::Uninitialized)
+        return this->initFuture_;
+    if (this->initialized()) {
+        std::promise<void> done;
+        done.set_value();
+        return done.get_future().share();
+    }
+    // Set here rather than in init(), so the time to first frame includes the wait for the worker thread.
+    this->initStart_ = std::chrono::steady_clock::now();
+    this->readiness_.store(EngineReadiness::Initializing, std::memory_order_release);
+    this->initFuture_ = std::async(std::launch::async, [this, title]() { this->init(title); }).share();
+    return this->initFuture_;
+}
+
+auto ImPlotEngine::time_to_first_frame() const -> std::optional<std::chrono::nanoseconds> {
+    const int64_t ns = this->firstFrameNs_.load(std::memory_order_acquire);
+    if (ns < 0)
+        return std::nullopt;
+    return std::chrono::nanoseconds(ns);
+}
+
+auto ImPlotEngine::vulkan_host_memory() const -> VulkanHostAllocStats {
+    const EngineReadiness state = this->readiness_.load(std::memory_order_acquire);
+    if (state != EngineReadiness::Ready && state != EngineReadiness::Presented)
+        return {};
+    // deinit() may release the device between the check above and here.
+    std::shared_ptr<VulkanHelper> vk;
+    {
+        std::scoped_lock guard(drawers_mutex_);
+        vk = this->vulkanHelper_;
+    }
+    return vk ? vk->HostAllocStats() : VulkanHostAllocStats{};
+}
+
+auto ImPlotEngine::begin_init() -> void {
+    if (this->readiness() != EngineReadiness::Initializing) {
+        this->initStart_ = std::chrono::steady_clock::now();
+        this->readiness_.store(EngineReadiness::Initializing, std::memory_order_release);
+    }
+    this->firstFrameNs_.store(-1, std::memory_order_relaxed);
+}
+
+auto ImPlotEngine::finish_init() -> void {
+    this->startupStats_.init_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - this->initStart_).count();
+    this->startupStats_.vulkan = this->vulkanHelper_->startup;
+    this->readiness_.store(EngineReadiness::Ready, std::memory_order_release);
+}
+
+// Waits for a pending init_async() and rethrows its exception. The future is copied under the lock, which an
+// in-progress init holds, so this also orders the caller after it.
+auto ImPlotEngine::await_init() -> void {
+    std::shared_future<void> pending;
+    {
+        std::scoped_lock guard(drawers_mutex_);
+        pending = this->initFuture_;
+    }
+    if (pending.valid())
+        pending.get();
+}
+
+auto ImPlotEngine::mark_frame_done() -> void {
+    if (this->readiness_.load(std::memory_order_relaxed) != EngineReadiness::Ready)
+        return;
+    const auto elapsed = std::chrono::steady_clock::now() - this->initStart_;
+    this->firstFrameNs_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                              std::memory_order_release);
+    this->readiness_.store(EngineReadiness::Presented, std::memory_order_release);
+}
+
 auto ImPlotEngine::deinit() -> void {
     std::scoped_lock guard(drawers_mutex_);
-    if (!this->window_) {
+    if (!this->initialized()) {
+        return;
+    }
+    this->readiness_.store(EngineReadiness::Uninitialized, std::memory_order_release);
+    this->initFuture_ = {};
+
+    // Cleanup. The device is shared with other engines, so wait for our queue only.
+    ThreadPool::shared().wait(this->prepares_);
+    this->stop_capture();
+    this->stop_draw_recording();
+    this->bind_context();
+    this->wakeable_.store(false, std::memory_order_release);
+    {
+        std::scoped_lock queue_lock(*this->queue_.mutex);
+        VkResult err = vkQueueWaitIdle(this->queue_.queue);
+        VulkanHelper::check_vk_result(err);
+        ImGui_ImplVulkan_Shutdown();
+    }
+    this->gpuSeriesRenderer_.reset();
+    this->gpuTimer_.reset();
+    this->lastGpuNs_.store(-1, std::memory_order_relaxed);
+    if (!this->headless_) {
+        std::scoped_lock state(glfw_runtime().state);
+        ImGui_ImplGlfw_Shutdown();
+    }
+    this->destroy_contexts();
+    this->vulkanHelper_->DestroyDescriptorPool(this->descriptorPool_);
+    this->descriptorPool_ = VK_NULL_HANDLE;
+
+    if (this->headless_) {
+        this->offscreen_.Destroy();
+        this->vulkanHelper_.reset();
+        this->queue_ = VulkanQueue{};
+        this->headless_ = false;
         return;
     }
-
-    // Cleanup
-    VkResult err = vkDeviceWaitIdle(this->vulkanHelper_.data.device);
-    VulkanHelper::check_vk_result(err);
-    ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImPlot3D::DestroyContext();
-    ImPlot::DestroyContext();
-    ImGui::DestroyContext();
 
     CleanupVulkanWindow();
-    this->vulkanHelper_.Cleanup();
+    this->vulkanHelper_.reset();
+    this->queue_ = VulkanQueue{};
 
-    glfwDestroyWindow(this->window_);
+    {
+        auto pump = lock_pump();
+        glfwDestroyWindow(this->window_);
+    }
     this->window_ = nullptr;
-    glfwTerminate();
+    {
+        std::scoped_lock lock(this->inputMutex_);
+        this->inputEvents_.clear();
+    }
+    release_glfw();
+}
+
+// ImGui, ImPlot and ImPlot3D keep their current context in a thread-local (imgui_user_config.h); every entry point
+// that runs on a render thread binds this engine's contexts first.
+auto ImPlotEngine::bind_context() -> void {
+    ImGui::SetCurrentContext(this->imguiContext_);
+    ImPlot::SetCurrentContext(this->implotContext_);
+    ImPlot3D::SetCurrentContext(this->implot3dContext_);
+    GpuSeriesRenderer::set_current(this->gpuSeriesRenderer_.get());
 }
 
 // All the ImGui_ImplVulkanH_XXX structures/functions are optional helpers used by the demo.
@@ -170,8 +476,8 @@ auto ImPlotEngine::SetupVulkanWindow(ImGui_ImplVulkanH_Window *wd, VkSurfaceKHR
 
     // Check for WSI support
     VkBool32 res;
-    vkGetPhysicalDeviceSurfaceSupportKHR(this->vulkanHelper_.data.physicalDevice, this->vulkanHelper_.data.queueFamily,
-                                         wd->Surface, &res);
+    vkGetPhysicalDeviceSurfaceSupportKHR(this->vulkanHelper_->data.physicalDevice,
+                                         this->vulkanHelper_->data.queueFamily, wd->Surface, &res);
     if (res != VK_TRUE) {
         fprintf(stderr, "Error no WSI support on physical device 0\n");
         exit(-1);
@@ -182,37 +488,82 @@ auto ImPlotEngine::SetupVulkanWindow(ImGui_ImplVulkanH_Window *wd, VkSurfaceKHR
                                                   VK_FORMAT_B8G8R8_UNORM, VK_FORMAT_R8G8B8_UNORM};
     const VkColorSpaceKHR requestSurfaceColorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
     wd->SurfaceFormat = ImGui_ImplVulkanH_SelectSurfaceFormat(
-        this->vulkanHelper_.data.physicalDevice, wd->Surface, requestSurfaceImageFormat,
+        this->vulkanHelper_->data.physicalDevice, wd->Surface, requestSurfaceImageFormat,
         (size_t)IM_ARRAYSIZE(requestSurfaceImageFormat), requestSurfaceColorSpace);
 
+    // Swapchain images double as the copy source of start_capture() where the surface allows it
+    VkSurfaceCapabilitiesKHR caps;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(this->vulkanHelper_->data.physicalDevice, wd->Surface, &caps);
+    this->swapchainUsage_ = caps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
     // Select Present Mode
-#ifdef APP_USE_UNLIMITED_FRAME_RATE
-    VkPresentModeKHR present_modes[] = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR,
-                                        VK_PRESENT_MODE_FIFO_KHR};
-#else
-    VkPresentModeKHR present_modes[] = {VK_PRESENT_MODE_FIFO_KHR};
-#endif
-    wd->PresentMode = ImGui_ImplVulkanH_SelectPresentMode(this->vulkanHelper_.data.physicalDevice, wd->Surface,
-                                                          &present_modes[0], IM_ARRAYSIZE(present_modes));
+    wd->PresentMode = this->select_present_mode(wd->Surface);
     // printf("[vulkan] Selected PresentMode = %d\n", wd->PresentMode);
 
     // Create SwapChain, RenderPass, Framebuffer, etc.
+    // (the helper calls vkDeviceWaitIdle(), which must not overlap a submit on any queue)
     IM_ASSERT(this->minImageCount_ >= 2);
-    ImGui_ImplVulkanH_CreateOrResizeWindow(this->vulkanHelper_.data.instance, this->vulkanHelper_.data.physicalDevice,
-                                           this->vulkanHelper_.data.device, wd, this->vulkanHelper_.data.queueFamily,
-                                           this->vulkanHelper_.data.allocator, width, height, this->minImageCount_, 0);
+    auto queues = this->vulkanHelper_->LockQueues();
+    ImGui_ImplVulkanH_CreateOrResizeWindow(this->vulkanHelper_->data.instance, this->vulkanHelper_->data.physicalDevice,
+                                           this->vulkanHelper_->data.device, wd, this->vulkanHelper_->data.queueFamily,
+                                           this->vulkanHelper_->data.allocator, width, height, this->minImageCount_,
+                                           this->swapchainUsage_);
+    this->frames_.Create(this->vulkanHelper_.get(), this->framesInFlight_.load(std::memory_order_relaxed),
+                         wd->ImageCount);
+}
+
+// Requested mode first, then the other low-latency mode for MAILBOX/IMMEDIATE, then FIFO which is always there.
+auto ImPlotEngine::select_present_mode(VkSurfaceKHR surface) -> VkPresentModeKHR {
+    const VkPresentModeKHR requested = this->presentModeRequest_.load(std::memory_order_relaxed);
+    VkPresentModeKHR present_modes[3] = {requested, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    if (requested == VK_PRESENT_MODE_MAILBOX_KHR)
+        present_modes[1] = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    else if (requested == VK_PRESENT_MODE_IMMEDIATE_KHR)
+        present_modes[1] = VK_PRESENT_MODE_MAILBOX_KHR;
+    const VkPresentModeKHR mode = ImGui_ImplVulkanH_SelectPresentMode(
+        this->vulkanHelper_->data.physicalDevice, surface, &present_modes[0], IM_ARRAYSIZE(present_modes));
+    this->presentMode_.store(mode, std::memory_order_relaxed);
+    return mode;
+}
+
+auto ImPlotEngine::set_present_mode(VkPresentModeKHR mode) -> void {
+    this->presentModeRequest_.store(mode, std::memory_order_relaxed);
+    this->swapchainConfigDirty_.store(true, std::memory_order_release);
+    this->invalidate();
+}
+
+auto ImPlotEngine::set_min_image_count(uint32_t count) -> void {
+    this->minImageCountRequest_.store(std::max(count, 2u), std::memory_order_relaxed);
+    this->swapchainConfigDirty_.store(true, std::memory_order_release);
+    this->invalidate();
+}
+
+auto ImPlotEngine::set_frames_in_flight(uint32_t frames) -> void {
+    this->framesInFlight_.store(std::clamp(frames, 1u, VulkanFrameRing::kMaxFrames), std::memory_order_relaxed);
+    this->swapchainConfigDirty_.store(true, std::memory_order_release);
+    this->invalidate();
 }
 
 auto ImPlotEngine::CleanupVulkanWindow() -> void {
-    ImGui_ImplVulkanH_DestroyWindow(this->vulkanHelper_.data.instance, this->vulkanHelper_.data.device,
-                                    &this->mainWindowData_, this->vulkanHelper_.data.allocator);
+    auto queues = this->vulkanHelper_->LockQueues();
+    ImGui_ImplVulkanH_DestroyWindow(this->vulkanHelper_->data.instance, this->vulkanHelper_->data.device,
+                                    &this->mainWindowData_, this->vulkanHelper_->data.allocator);
+    this->frames_.Destroy();  // the device is idle after the call above
 }
 
 auto ImPlotEngine::FrameRender(ImGui_ImplVulkanH_Window *wd, ImDrawData *draw_data) -> void {
-    VkSemaphore image_acquired_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].ImageAcquiredSemaphore;
-    VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
-    VkResult err = vkAcquireNextImageKHR(this->vulkanHelper_.data.device, wd->Swapchain, UINT64_MAX,
-                                         image_acquired_semaphore, VK_NULL_HANDLE, &wd->FrameIndex);
+    // This slot's previous frame, frames_in_flight() frames ago, has to be done before its resources are reused;
+    // the frames after it keep the GPU busy meanwhile.
+    this->profiler_.begin_phase(FramePhase::FenceWait);
+    VulkanFrameSlot &frame = this->frames_.Next();
+    this->profiler_.end_phase(FramePhase::FenceWait);
+    const uint32_t slot = this->frames_.Index();
+    this->gpuTimer_->collect(slot);
+    if (this->profiler_.frame_active())
+        this->profiler_.record_in_flight_render(this->frames_.Pending());
+
+    VkResult err = vkAcquireNextImageKHR(this->vulkanHelper_->data.device, wd->Swapchain, UINT64_MAX,
+                                         frame.imageAcquired, VK_NULL_HANDLE, &wd->FrameIndex);
     if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
         this->swapChainRebuild_ = true;
     if (err == VK_ERROR_OUT_OF_DATE_KHR)
@@ -220,23 +571,22 @@ auto ImPlotEngine::FrameRender(ImGui_ImplVulkanH_Window *wd, ImDrawData *draw_da
     if (err != VK_SUBOPTIMAL_KHR)
         VulkanHelper::check_vk_result(err);
 
+    // Framebuffer and image only; command buffers and fences are the ring's
     ImGui_ImplVulkanH_Frame *fd = &wd->Frames[wd->FrameIndex];
     {
-        err = vkWaitForFences(this->vulkanHelper_.data.device, 1, &fd->Fence, VK_TRUE,
-                              UINT64_MAX);  // wait indefinitely instead of periodically checking
-        VulkanHelper::check_vk_result(err);
-
-        err = vkResetFences(this->vulkanHelper_.data.device, 1, &fd->Fence);
+        this->frames_.ClaimImage(wd->FrameIndex);
+        err = vkResetFences(this->vulkanHelper_->data.device, 1, &frame.fence);
         VulkanHelper::check_vk_result(err);
     }
     {
-        err = vkResetCommandPool(this->vulkanHelper_.data.device, fd->CommandPool, 0);
+        err = vkResetCommandPool(this->vulkanHelper_->data.device, frame.commandPool, 0);
         VulkanHelper::check_vk_result(err);
         VkCommandBufferBeginInfo info = {};
         info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-        err = vkBeginCommandBuffer(fd->CommandBuffer, &info);
+        err = vkBeginCommandBuffer(frame.commandBuffer, &info);
         VulkanHelper::check_vk_result(err);
+        this->gpuTimer_->begin(frame.commandBuffer, slot, this->gpu_tag());
     }
     {
         VkRenderPassBeginInfo info = {};
@@ -247,37 +597,51 @@ auto ImPlotEngine::FrameRender(ImGui_ImplVulkanH_Window *wd, ImDrawData *draw_da
         info.renderArea.extent.height = wd->Height;
         info.clearValueCount = 1;
         info.pClearValues = &wd->ClearValue;
-        vkCmdBeginRenderPass(fd->CommandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(frame.commandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
     }
 
-    // Record dear imgui primitives into command buffer
-    ImGui_ImplVulkan_RenderDrawData(draw_data, fd->CommandBuffer);
+    // Record dear imgui primitives into command buffer (texture uploads submit on the queue from inside the backend)
+    {
+        std::unique_lock queue_lock(*this->queue_.mutex, std::defer_lock);
+        if (VulkanHelper::TexturesPending(draw_data))
+            queue_lock.lock();
+        ImGui_ImplVulkan_RenderDrawData(draw_data, frame.commandBuffer);
+    }
 
     // Submit command buffer
-    vkCmdEndRenderPass(fd->CommandBuffer);
+    vkCmdEndRenderPass(frame.commandBuffer);
+    this->gpuTimer_->end(frame.commandBuffer, slot);
+    std::scoped_lock capture_lock(this->captureMutex_);
+    if (this->capture_)
+        this->capture_->record(frame.commandBuffer, fd->Backbuffer, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                               wd->SurfaceFormat.format, (uint32_t)wd->Width, (uint32_t)wd->Height);
     {
+        VkSemaphore render_complete_semaphore = this->frames_.RenderComplete(wd->FrameIndex);
         VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
         VkSubmitInfo info = {};
         info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         info.waitSemaphoreCount = 1;
-        info.pWaitSemaphores = &image_acquired_semaphore;
+        info.pWaitSemaphores = &frame.imageAcquired;
         info.pWaitDstStageMask = &wait_stage;
         info.commandBufferCount = 1;
-        info.pCommandBuffers = &fd->CommandBuffer;
+        info.pCommandBuffers = &frame.commandBuffer;
         info.signalSemaphoreCount = 1;
         info.pSignalSemaphores = &render_complete_semaphore;
 
-        err = vkEndCommandBuffer(fd->CommandBuffer);
+        err = vkEndCommandBuffer(frame.commandBuffer);
         VulkanHelper::check_vk_result(err);
-        err = vkQueueSubmit(this->vulkanHelper_.data.queue, 1, &info, fd->Fence);
+        std::scoped_lock queue_lock(*this->queue_.mutex);
+        err = vkQueueSubmit(this->queue_.queue, 1, &info, frame.fence);
         VulkanHelper::check_vk_result(err);
+        if (this->capture_)
+            this->capture_->submitted(this->queue_.queue);
     }
 }
 
 auto ImPlotEngine::FramePresent(ImGui_ImplVulkanH_Window *wd) -> void {
     if (this->swapChainRebuild_)
         return;
-    VkSemaphore render_complete_semaphore = wd->FrameSemaphores[wd->SemaphoreIndex].RenderCompleteSemaphore;
+    VkSemaphore render_complete_semaphore = this->frames_.RenderComplete(wd->FrameIndex);
     VkPresentInfoKHR info = {};
     info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     info.waitSemaphoreCount = 1;
@@ -285,26 +649,32 @@ auto ImPlotEngine::FramePresent(ImGui_ImplVulkanH_Window *wd) -> void {
     info.swapchainCount = 1;
     info.pSwapchains = &wd->Swapchain;
     info.pImageIndices = &wd->FrameIndex;
-    VkResult err = vkQueuePresentKHR(this->vulkanHelper_.data.queue, &info);
+    VkResult err;
+    {
+        std::scoped_lock queue_lock(*this->queue_.mutex);
+        err = vkQueuePresentKHR(this->queue_.queue, &info);
+    }
     if (err == VK_ERROR_OUT_OF_DATE_KHR || err == VK_SUBOPTIMAL_KHR)
         this->swapChainRebuild_ = true;
     if (err == VK_ERROR_OUT_OF_DATE_KHR)
         return;
     if (err != VK_SUBOPTIMAL_KHR)
         VulkanHelper::check_vk_result(err);
-    wd->SemaphoreIndex = (wd->SemaphoreIndex + 1) % wd->SemaphoreCount;  // Now we can use the next set of semaphores
 }
 
 auto ImPlotEngine::show_async() -> void {
+    this->showRunning_.store(true, std::memory_order_release);
     show_thread_ = std::jthread([this](std::stop_token st) {
         this->stop_token_ = st;
         this->show();
+        this->showRunning_.store(false, std::memory_order_release);
     });
 }
 
 auto ImPlotEngine::show_stop() -> void {
     if (show_thread_.joinable()) {
         show_thread_.request_stop();
+        this->wake();
     }
 }
 
@@ -321,8 +691,12 @@ auto ImPlotEngine::show_detach() -> void {
 }
 
 auto ImPlotEngine::show(std::optional<std::string> title, bool clear_entries) -> void {
+    this->await_init();
     {
         std::scoped_lock guard(drawers_mutex_);
+        if (this->headless_) {
+            throw std::logic_error("ImPlotEngine::show() is not available in headless mode, use render_headless()");
+        }
         if (title.has_value()) {
             this->title_ = title.value();
             if (this->window_) {
@@ -333,11 +707,9 @@ auto ImPlotEngine::show(std::optional<std::string> title, bool clear_entries) ->
             this->init(this->title_);
         }
     }
-    // Our state
-    bool show_demo_window = false;
-    ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     // Main loop
+    this->bind_context();
     while (!glfwWindowShouldClose(this->window_)) {
         if (this->stop_token_.stop_requested()) {
             break;
@@ -350,7 +722,17 @@ auto ImPlotEngine::show(std::optional<std::string> title, bool clear_entries) ->
         // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application, or
         // clear/overwrite your copy of the keyboard data. Generally you may always pass all inputs to dear imgui, and
         // hide them from your application based on those two flags.
-        glfwPollEvents();
+        this->wait_for_frame();
+        if (this->stop_token_.stop_requested() || glfwWindowShouldClose(this->window_)) {
+            this->profiler_.end_frame();
+            break;
+        }
+
+        // Present mode or image count changed at runtime?
+        if (this->swapchainConfigDirty_.exchange(false, std::memory_order_acq_rel)) {
+            this->minImageCount_ = this->minImageCountRequest_.load(std::memory_order_relaxed);
+            this->swapChainRebuild_ = true;
+        }
 
         // Resize swap chain?
         int fb_width, fb_height;
@@ -358,124 +740,657 @@ auto ImPlotEngine::show(std::optional<std::string> title, bool clear_entries) ->
         if (fb_width > 0 && fb_height > 0 &&
             (this->swapChainRebuild_ || this->mainWindowData_.Width != fb_width ||
              this->mainWindowData_.Height != fb_height)) {
+            this->profiler_.begin_phase(FramePhase::SwapchainResize);
+            this->mainWindowData_.PresentMode = this->select_present_mode(this->mainWindowData_.Surface);
+            auto queues = this->vulkanHelper_->LockQueues();  // both calls below use vkDeviceWaitIdle()
             ImGui_ImplVulkan_SetMinImageCount(this->minImageCount_);
             ImGui_ImplVulkanH_CreateOrResizeWindow(
-                this->vulkanHelper_.data.instance, this->vulkanHelper_.data.physicalDevice,
-                this->vulkanHelper_.data.device, &this->mainWindowData_, this->vulkanHelper_.data.queueFamily,
-                this->vulkanHelper_.data.allocator, fb_width, fb_height, this->minImageCount_, 0);
+                this->vulkanHelper_->data.instance, this->vulkanHelper_->data.physicalDevice,
+                this->vulkanHelper_->data.device, &this->mainWindowData_, this->vulkanHelper_->data.queueFamily,
+                this->vulkanHelper_->data.allocator, fb_width, fb_height, this->minImageCount_,
+                this->swapchainUsage_);
+            if (this->gpuSeriesRenderer_)
+                this->gpuSeriesRenderer_->set_render_pass(this->mainWindowData_.RenderPass);
+            this->frames_.Destroy();
+            this->frames_.Create(this->vulkanHelper_.get(), this->framesInFlight_.load(std::memory_order_relaxed),
+                                 this->mainWindowData_.ImageCount);
+            this->gpuTimer_->reset(VulkanFrameRing::kMaxFrames);
             this->mainWindowData_.FrameIndex = 0;
             this->swapChainRebuild_ = false;
+            this->profiler_.end_phase(FramePhase::SwapchainResize);
         }
         if (glfwGetWindowAttrib(this->window_, GLFW_ICONIFIED) != 0) {
+            this->profiler_.end_frame();
             ImGui_ImplGlfw_Sleep(10);
             continue;
         }
 
         // Start the Dear ImGui frame
+        this->profiler_.begin_phase(FramePhase::NewFrame);
         ImGui_ImplVulkan_NewFrame();
         ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        // 1. Show the big demo window (Most of the sample code is in ImGui::ShowDemoWindow()! You can browse its code
-        // to learn more about Dear ImGui!).
-        if (show_demo_window) {
-            ImGui::ShowDemoWindow(&show_demo_window);
-            ImPlot::ShowDemoWindow();
-        }
-
-        auto snap = this->drawers_.load(std::memory_order_acquire);
-        if (!snap)
+        ImDrawData *draw_data = this->build_frame();
+        if (!draw_data) {
+            this->profiler_.end_frame();
             break;
-
-        for (const auto &item : *snap) {
-            item->fn();
         }
 
-        // Rendering
-        ImGui::Render();
-        ImDrawData *draw_data = ImGui::GetDrawData();
         const bool is_minimized = (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f);
         if (!is_minimized) {
-            this->mainWindowData_.ClearValue.color.float32[0] = clear_color.x * clear_color.w;
-            this->mainWindowData_.ClearValue.color.float32[1] = clear_color.y * clear_color.w;
-            this->mainWindowData_.ClearValue.color.float32[2] = clear_color.z * clear_color.w;
-            this->mainWindowData_.ClearValue.color.float32[3] = clear_color.w;
+            this->mainWindowData_.ClearValue.color.float32[0] = this->clearColor_.x * this->clearColor_.w;
+            this->mainWindowData_.ClearValue.color.float32[1] = this->clearColor_.y * this->clearColor_.w;
+            this->mainWindowData_.ClearValue.color.float32[2] = this->clearColor_.z * this->clearColor_.w;
+            this->mainWindowData_.ClearValue.color.float32[3] = this->clearColor_.w;
+            this->profiler_.begin_phase(FramePhase::FrameRender);
             FrameRender(&this->mainWindowData_, draw_data);
+            this->profiler_.end_phase(FramePhase::FrameRender);
+            this->collect_gpu_timings();
+            this->profiler_.begin_phase(FramePhase::FramePresent);
             FramePresent(&this->mainWindowData_);
+            this->profiler_.end_phase(FramePhase::FramePresent);
+            this->mark_frame_done();
         }
+        this->profiler_.end_frame();
+
+        // FPS cap on top of whatever the present mode does
+        this->pacer_.pace();
     }
+    // A closed window ends the session for everything tied to stop_token(), e.g. a CsvLoader still loading.
+    if (std::this_thread::get_id() == this->show_thread_.get_id())
+        this->show_thread_.request_stop();
 
     {
         std::scoped_lock guard(drawers_mutex_);
         this->deinit();
         if (clear_entries) {
             this->remove_drawers();
+            this->apply_drawer_commands();  // no frame boundary follows; release the closures now
         }
     }
 }
 
-auto ImPlotEngine::draw(EntryPtr item) -> uint32_t {
-    std::scoped_lock guard(drawers_mutex_);
-    auto snap = this->drawers_.load(std::memory_order_acquire);
+// Polls events and, in on-demand mode, blocks until there is a reason to draw: input (plus a few settle frames
+// so ImGui can finish hover/animation state), an invalidate(), or a frame deadline requested by a drawer.
+// Opens the frame record; idle time spent waiting is not part of it.
+auto ImPlotEngine::wait_for_frame() -> void {
+    using namespace std::chrono;
+    constexpr double kMaxWaitSeconds = 0.5;  // upper bound so a missed wake-up can never stall the loop for long
+
+    for (;;) {
+        this->profiler_.begin_frame();
+        this->sync_frame_start();
+        this->profiler_.begin_phase(FramePhase::PollEvents);
+        this->poll_events();
+        this->profiler_.end_phase(FramePhase::PollEvents);
+
+        if (this->inputPending_.exchange(false, std::memory_order_acq_rel)) {
+            this->settleFrames_ = this->settleFrameCount_.load(std::memory_order_relaxed);
+        }
+        if (this->renderMode_.load(std::memory_order_relaxed) == RenderMode::Continuous ||
+            this->stop_token_.stop_requested() || glfwWindowShouldClose(this->window_)) {
+            return;
+        }
+        if (this->settleFrames_ > 0) {
+            --this->settleFrames_;
+            return;
+        }
+        if (this->dirty_.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+        const int64_t now = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+        int64_t deadline = this->nextFrameNs_.load(std::memory_order_acquire);
+        if (deadline <= now) {
+            this->nextFrameNs_.compare_exchange_strong(deadline, INT64_MAX, std::memory_order_acq_rel);
+            return;
+        }
+
+        // Nothing to draw: discard the frame record and sleep in the event queue.
+        this->profiler_.discard_frame();
+        const double timeout = deadline == INT64_MAX ? kMaxWaitSeconds
+                                                     : std::min(kMaxWaitSeconds, (double)(deadline - now) * 1e-9);
+        this->wait_events(timeout);
+    }
+}
+
+// Events for other engines' windows are queued to them by the callbacks; ours are forwarded after the pump.
+auto ImPlotEngine::poll_events() -> void {
+    {
+        auto pump = lock_pump();
+        glfwPollEvents();
+    }
+    this->forward_input();
+}
+
+// Only one thread can block in glfwWaitEventsTimeout(). The others sleep on their own wake-up signal, which input
+// routed to their window also raises, and retry the event queue every few milliseconds.
+auto ImPlotEngine::wait_events(double timeout) -> void {
+    constexpr double kPumpRetrySeconds = 0.008;
+
+    auto &rt = glfw_runtime();
+    if (rt.pumpWaiters.load(std::memory_order_acquire) == 0) {
+        std::unique_lock pump(rt.pump, std::try_to_lock);
+        if (pump.owns_lock()) {
+            glfwWaitEventsTimeout(timeout);
+            return;
+        }
+    }
+    std::unique_lock lock(this->wakeMutex_);
+    this->wakeCv_.wait_for(lock, std::chrono::duration<double>(std::min(timeout, kPumpRetrySeconds)),
+                           [this]() { return this->wakeSignal_; });
+    this->wakeSignal_ = false;
+}
+
+// Replays queued input into the GLFW backend of this engine's (bound) context.
+auto ImPlotEngine::forward_input() -> void {
+    {
+        std::scoped_lock lock(this->inputMutex_);
+        if (this->inputEvents_.empty())
+            return;
+        this->inputDrain_.swap(this->inputEvents_);
+    }
+    std::shared_lock state(glfw_runtime().state);  // the backend looks the window up in its context table
+    GLFWwindow *w = this->window_;
+    for (const InputEvent &e : this->inputDrain_) {
+        switch (e.type) {
+        case InputEvent::Type::CursorPos:
+            ImGui_ImplGlfw_CursorPosCallback(w, e.x, e.y);
+            break;
+        case InputEvent::Type::MouseButton:
+            ImGui_ImplGlfw_MouseButtonCallback(w, e.a, e.b, e.c);
+            break;
+        case InputEvent::Type::Scroll:
+            ImGui_ImplGlfw_ScrollCallback(w, e.x, e.y);
+            break;
+        case InputEvent::Type::Key:
+            ImGui_ImplGlfw_KeyCallback(w, e.a, e.b, e.c, e.d);
+            break;
+        case InputEvent::Type::Char:
+            ImGui_ImplGlfw_CharCallback(w, (unsigned int)e.a);
+            break;
+        case InputEvent::Type::CursorEnter:
+            ImGui_ImplGlfw_CursorEnterCallback(w, e.a);
+            break;
+        case InputEvent::Type::Focus:
+            ImGui_ImplGlfw_WindowFocusCallback(w, e.a);
+            break;
+        }
+    }
+    this->inputDrain_.clear();
+}
 
-    std::shared_ptr<std::vector<EntryPtr>> next;
-    if (!snap)
-        next = std::make_shared<std::vector<EntryPtr>>();
-    else
-        next = std::make_shared<std::vector<EntryPtr>>(*snap);
+auto ImPlotEngine::set_render_mode(RenderMode mode) -> void {
+    this->renderMode_.store(mode, std::memory_order_relaxed);
+    this->invalidate();
+}
 
-    item->id = ++this->lastDrawerId_;
-    next->push_back(std::move(item));
+auto ImPlotEngine::invalidate() -> void {
+    this->invalidations_.fetch_add(1, std::memory_order_acq_rel);
+    this->dirty_.store(true, std::memory_order_release);
+    this->wake();
+}
 
-    drawers_.store(std::shared_ptr<const std::vector<EntryPtr>>(std::move(next)), std::memory_order_release);
+auto ImPlotEngine::request_frame_at(std::chrono::steady_clock::time_point deadline) -> void {
+    using namespace std::chrono;
+    const int64_t ns = duration_cast<nanoseconds>(deadline.time_since_epoch()).count();
+    int64_t cur = this->nextFrameNs_.load(std::memory_order_relaxed);
+    while (ns < cur && !this->nextFrameNs_.compare_exchange_weak(cur, ns, std::memory_order_acq_rel)) {
+    }
+    if (ns < cur)
+        this->wake();
+}
+
+// Wakes the render thread out of wait_events(). Safe to call from any thread.
+auto ImPlotEngine::signal() -> void {
+    {
+        std::scoped_lock lock(this->wakeMutex_);
+        this->wakeSignal_ = true;
+    }
+    this->wakeCv_.notify_one();
+}
 
-    return this->lastDrawerId_;
+// Also interrupts glfwWaitEventsTimeout() in case this engine is the one blocked in the event queue.
+auto ImPlotEngine::wake() -> void {
+    this->signal();
+    if (this->wakeable_.load(std::memory_order_acquire)) {
+        glfwPostEmptyEvent();
+    }
 }
 
-auto ImPlotEngine::remove_drawer(uint32_t id) -> void {
-    std::scoped_lock guard(drawers_mutex_);
-    auto snap = this->drawers_.load(std::memory_order_acquire);
+// GLFW callbacks run on whichever render thread pumps the event queue, not necessarily the window's own.
+auto ImPlotEngine::note_input(GLFWwindow *window) -> void {
+    auto *engine = static_cast<ImPlotEngine *>(glfwGetWindowUserPointer(window));
+    engine->inputPending_.store(true, std::memory_order_release);
+    engine->signal();
+}
 
-    if (!snap)
+auto ImPlotEngine::queue_input(GLFWwindow *window, const InputEvent &event) -> void {
+    auto *engine = static_cast<ImPlotEngine *>(glfwGetWindowUserPointer(window));
+    {
+        std::scoped_lock lock(engine->inputMutex_);
+        engine->inputEvents_.push_back(event);
+    }
+    note_input(window);
+}
+
+auto ImPlotEngine::install_input_callbacks() -> void {
+    using T = InputEvent::Type;
+    glfwSetWindowUserPointer(this->window_, this);
+    glfwSetCursorPosCallback(this->window_, [](GLFWwindow *w, double x, double y) {
+        queue_input(w, InputEvent{T::CursorPos, 0, 0, 0, 0, x, y});
+    });
+    glfwSetMouseButtonCallback(this->window_, [](GLFWwindow *w, int button, int action, int mods) {
+        queue_input(w, InputEvent{T::MouseButton, button, action, mods, 0, 0.0, 0.0});
+    });
+    glfwSetScrollCallback(this->window_, [](GLFWwindow *w, double x, double y) {
+        queue_input(w, InputEvent{T::Scroll, 0, 0, 0, 0, x, y});
+    });
+    glfwSetKeyCallback(this->window_, [](GLFWwindow *w, int key, int scancode, int action, int mods) {
+        queue_input(w, InputEvent{T::Key, key, scancode, action, mods, 0.0, 0.0});
+    });
+    glfwSetCharCallback(this->window_, [](GLFWwindow *w, unsigned int c) {
+        queue_input(w, InputEvent{T::Char, (int)c, 0, 0, 0, 0.0, 0.0});
+    });
+    glfwSetCursorEnterCallback(this->window_, [](GLFWwindow *w, int entered) {
+        queue_input(w, InputEvent{T::CursorEnter, entered, 0, 0, 0, 0.0, 0.0});
+    });
+    glfwSetWindowFocusCallback(this->window_, [](GLFWwindow *w, int focused) {
+        queue_input(w, InputEvent{T::Focus, focused, 0, 0, 0, 0.0, 0.0});
+    });
+    glfwSetFramebufferSizeCallback(this->window_, [](GLFWwindow *w, int, int) { note_input(w); });
+    glfwSetWindowRefreshCallback(this->window_, [](GLFWwindow *w) { note_input(w); });
+}
+
+// Runs one ImGui frame over the drawer list. Returns nullptr when there is no drawer list to show.
+// The caller opens the NewFrame phase before starting the backend frames.
+auto ImPlotEngine::build_frame() -> ImDrawData * {
+    ImGui::NewFrame();
+    this->profiler_.end_phase(FramePhase::NewFrame);
+
+    std::shared_ptr<DrawDataReplay> replay;
+    size_t replay_index = 0;
+    {
+        std::scoped_lock lock(this->replayMutex_);
+        replay = this->replay_;
+        replay_index = this->replayFrame_++;
+    }
+    if (replay) {
+        return this->replay_frame(*replay, replay_index);
+    }
+
+    // 1. Show the big demo window (Most of the sample code is in ImGui::ShowDemoWindow()! You can browse its code
+    // to learn more about Dear ImGui!).
+    if (this->showDemoWindow_) {
+        ImGui::ShowDemoWindow(&this->showDemoWindow_);
+        ImPlot::ShowDemoWindow();
+    }
+
+    // Prepares launched after the previous frame must be done before the registry changes or anything emits.
+    this->profiler_.begin_phase(FramePhase::PrepareWait);
+    ThreadPool::shared().wait(this->prepares_);
+    this->apply_drawer_commands();
+    this->finish_prepares();
+    this->profiler_.end_phase(FramePhase::PrepareWait);
+    if (!this->drawersLive_) {
+        ImGui::EndFrame();
+        return nullptr;
+    }
+
+    this->profiler_.begin_phase(FramePhase::Drawers);
+    const uint64_t epoch = DrawerCache::context_epoch();
+    const int64_t now_ns = this->profiler_.now_ns();
+    if (this->profiler_.frame_active()) {
+        this->drawers_.for_each([&](Entry &item) {
+            const auto t0 = this->profiler_.now_ns();
+            this->run_drawer(item, epoch, now_ns);
+            this->profiler_.record_drawer(item.id, item.key, t0);
+        });
+    } else {
+        this->drawers_.for_each([&](Entry &item) { this->run_drawer(item, epoch, now_ns); });
+    }
+    this->profiler_.end_phase(FramePhase::Drawers);
+
+    if (this->showProfiler_.load(std::memory_order_relaxed)) {
+        bool open = true;
+        this->profiler_.draw_overlay(&open);
+        if (!open)
+            this->showProfiler_.store(false, std::memory_order_relaxed);
+    }
+
+    // Rendering
+    this->profiler_.begin_phase(FramePhase::Render);
+    ImGui::Render();
+    this->profiler_.end_phase(FramePhase::Render);
+    this->launch_prepares();  // overlap the next frame's prepare stage with rendering this one
+    ImDrawData *draw_data = ImGui::GetDrawData();
+    this->profiler_.record_draw_data(draw_data);
+    this->check_window_budget(draw_data);
+    this->record_frame(draw_data);
+    return draw_data;
+}
+
+auto ImPlotEngine::replay_frame(DrawDataReplay &replay, size_t index) -> ImDrawData * {
+    // ImGui still ends its (empty) frame: input, atlas uploads and frame counters move on as usual.
+    this->profiler_.begin_phase(FramePhase::Render);
+    ImGui::Render();
+    this->profiler_.end_phase(FramePhase::Render);
+    ImDrawData *draw_data = replay.frame(index % replay.frame_count());
+    this->profiler_.record_draw_data(draw_data);
+    this->check_window_budget(draw_data);
+    return draw_data;
+}
+
+auto ImPlotEngine::record_frame(const ImDrawData *draw_data) -> void {
+    std::scoped_lock lock(this->replayMutex_);
+    if (!this->recorder_)
         return;
+    try {
+        this->recorder_->record(draw_data);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "[record] %s, recording stopped after %llu frame(s)\n", e.what(),
+                (unsigned long long)this->recorder_->frames());
+        this->recorder_.reset();
+    }
+}
 
-    auto next = std::make_shared<std::vector<EntryPtr>>(*snap);
+auto ImPlotEngine::render_headless(uint32_t frames, float delta_time) -> void {
+    if (!this->headless_) {
+        throw std::logic_error("ImPlotEngine::render_headless() requires init_headless()");
+    }
+    this->bind_context();
+
+    VkClearValue clear = {};
+    clear.color.float32[0] = this->clearColor_.x * this->clearColor_.w;
+    clear.color.float32[1] = this->clearColor_.y * this->clearColor_.w;
+    clear.color.float32[2] = this->clearColor_.z * this->clearColor_.w;
+    clear.color.float32[3] = this->clearColor_.w;
+
+    const uint32_t in_flight = this->framesInFlight_.load(std::memory_order_relaxed);
+    if (in_flight != this->offscreen_.FramesInFlight()) {
+        this->offscreen_.SetFramesInFlight(in_flight);
+        this->gpuTimer_->reset(VulkanFrameRing::kMaxFrames);
+    }
 
-    bool erased = false;
-    for (auto it = next->begin(); it != next->end();) {
-        if ((*it)->id == id) {
-            it = next->erase(it);
-            erased = true;
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        if (this->stop_token_.stop_requested()) {
             break;
-        } else {
-            ++it;
         }
+        this->profiler_.begin_frame();
+        this->sync_frame_start();
+        ImGuiIO &io = ImGui::GetIO();
+        io.DisplaySize = ImVec2((float)this->offscreen_.width, (float)this->offscreen_.height);
+        io.DeltaTime = delta_time;
+
+        this->profiler_.begin_phase(FramePhase::NewFrame);
+        ImGui_ImplVulkan_NewFrame();
+        ImDrawData *draw_data = this->build_frame();
+        if (!draw_data) {
+            this->profiler_.end_frame();
+            break;
+        }
+
+        // Only the last frame is copied out; earlier ones exist to let ImGui/ImPlot settle layout and fit axes.
+        this->profiler_.begin_phase(FramePhase::FrameRender);
+        this->profiler_.record_in_flight_render(this->offscreen_.Pending());
+        {
+            std::scoped_lock capture_lock(this->captureMutex_);
+            this->offscreen_.Render(draw_data, clear, frame + 1 == frames, this->capture_.get(),
+                                    this->gpuTimer_.get(), this->gpu_tag());
+        }
+        this->profiler_.end_phase(FramePhase::FrameRender);
+        this->collect_gpu_timings();
+        this->mark_frame_done();
+        this->profiler_.end_frame();
     }
+    // Everything submitted is done; read the remaining slots oldest first.
+    this->offscreen_.Wait();
+    const uint32_t slots = this->offscreen_.FramesInFlight();
+    for (uint32_t i = 1; i <= slots; ++i)
+        this->gpuTimer_->collect((this->offscreen_.FrameIndex() + i) % slots);
+    this->collect_gpu_timings();
+}
 
-    if (erased) {
-        drawers_.store(std::shared_ptr<const std::vector<EntryPtr>>(std::move(next)), std::memory_order_release);
+auto ImPlotEngine::read_pixels() -> std::vector<uint8_t> {
+    std::vector<uint8_t> rgba;
+    if (!this->headless_ || !this->offscreen_.Readback(rgba)) {
+        throw std::logic_error("ImPlotEngine::read_pixels() needs a frame rendered by render_headless()");
     }
+    return rgba;
 }
 
-auto ImPlotEngine::remove_drawer(const std::string &name) -> void {
+auto ImPlotEngine::save_png(const std::string &path) -> void {
+    auto rgba = this->read_pixels();
+    WritePngRGBA(path, rgba.data(), this->offscreen_.width, this->offscreen_.height);
+}
+
+auto ImPlotEngine::save_raw(const std::string &path) -> void {
+    auto rgba = this->read_pixels();
+    WriteRawRGBA(path, rgba.data(), this->offscreen_.width, this->offscreen_.height);
+}
+
+auto ImPlotEngine::start_capture(const std::string &path, FrameCaptureOptions options) -> void {
     std::scoped_lock guard(drawers_mutex_);
-    auto snap = this->drawers_.load(std::memory_order_acquire);
+    if (!this->initialized()) {
+        throw std::logic_error("ImPlotEngine::start_capture() requires an initialized engine");
+    }
+    if (!this->headless_ && !(this->swapchainUsage_ & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+        throw std::runtime_error("ImPlotEngine::start_capture(): the surface does not allow copying its images");
+    }
+    this->stop_capture();  // first: `path` may be the file it writes
+    auto capture = std::make_unique<VulkanFrameCapture>(this->vulkanHelper_.get(), path, options);
+    std::scoped_lock lock(this->captureMutex_);
+    this->capture_ = std::move(capture);
+}
 
-    if (!snap)
+auto ImPlotEngine::stop_capture() -> void {
+    std::scoped_lock lock(this->captureMutex_);
+    if (!this->capture_)
         return;
+    this->capture_->close();
+    this->captureStats_ = this->capture_->stats();
+    this->capture_.reset();
+}
+
+auto ImPlotEngine::capture_stats() const -> FrameCaptureStats {
+    std::scoped_lock lock(this->captureMutex_);
+    return this->capture_ ? this->capture_->stats() : this->captureStats_;
+}
+
+// Profiler frame a GPU measurement belongs to.
+auto ImPlotEngine::gpu_tag() const -> uint64_t {
+    return this->profiler_.frame_active() ? this->profiler_.active_frame() : kUntaggedFrame;
+}
+
+// Start of a frame record, before input is read: in low latency mode this is where the CPU waits for the GPU to
+// drain, so the frame's input is as fresh as possible. Also samples how many frames the GPU still has queued.
+auto ImPlotEngine::sync_frame_start() -> void {
+    if (this->frameLatency_.load(std::memory_order_relaxed) == FrameLatency::Low) {
+        this->profiler_.begin_phase(FramePhase::GpuWait);
+        if (this->headless_)
+            this->offscreen_.Wait();
+        else
+            this->frames_.WaitIdle();
+        this->profiler_.end_phase(FramePhase::GpuWait);
+    }
+    if (this->profiler_.frame_active())
+        this->profiler_.record_in_flight_begin(this->headless_ ? this->offscreen_.Pending() : this->frames_.Pending());
+}
+
+auto ImPlotEngine::check_window_budget(const ImDrawData *draw_data) -> void {
+    const uint32_t budget = this->budgetWindowVtx_.load(std::memory_order_relaxed);
+    this->overBudgetNext_.clear();
+    if (budget) {
+        for (const ImDrawList *dl : draw_data->CmdLists) {
+            if (static_cast<uint32_t>(dl->VtxBuffer.Size) <= budget)
+                continue;
+            const char *name = dl->_OwnerName ? dl->_OwnerName : "";
+            if (std::find(this->overBudget_.begin(), this->overBudget_.end(), name) == this->overBudget_.end())
+                fprintf(stderr, "[budget] Window \"%s\": %d vertices, budget %u\n", name, dl->VtxBuffer.Size, budget);
+            this->overBudgetNext_.emplace_back(name);
+        }
+    }
+    this->overBudget_.swap(this->overBudgetNext_);
+}
+
+auto ImPlotEngine::collect_gpu_timings() -> void {
+    this->gpuTimer_->take(this->gpuTimings_);
+    if (this->gpuTimings_.empty())
+        return;
+    const double budget = this->budgetGpuMs_.load(std::memory_order_relaxed);
+    for (const GpuFrameTiming &t : this->gpuTimings_) {
+        if (t.tag != kUntaggedFrame)
+            this->profiler_.record_gpu(t.tag, t.ns);
+        const double ms = static_cast<double>(t.ns) * 1e-6;
+        const bool over = budget > 0.0 && ms > budget;
+        if (over && !this->gpuOverBudget_)
+            fprintf(stderr, "[budget] GPU frame %.2f ms, budget %.2f ms\n", ms, budget);
+        this->gpuOverBudget_ = over;
+    }
+    this->lastGpuNs_.store(static_cast<int64_t>(this->gpuTimings_.back().ns), std::memory_order_relaxed);
+}
+
+auto ImPlotEngine::set_render_budget(RenderBudget budget) -> void {
+    this->budgetWindowVtx_.store(budget.window_vtx, std::memory_order_relaxed);
+    this->budgetGpuMs_.store(budget.gpu_ms, std::memory_order_relaxed);
+}
+
+auto ImPlotEngine::render_budget() const -> RenderBudget {
+    return RenderBudget{this->budgetWindowVtx_.load(std::memory_order_relaxed),
+                        this->budgetGpuMs_.load(std::memory_order_relaxed)};
+}
+
+auto ImPlotEngine::gpu_frame_ms() const -> std::optional<double> {
+    const int64_t ns = this->lastGpuNs_.load(std::memory_order_relaxed);
+    if (ns < 0)
+        return std::nullopt;
+    return static_cast<double>(ns) * 1e-6;
+}
+
+auto ImPlotEngine::start_draw_recording(const std::string &path) -> void {
+    this->stop_draw_recording();  // first: `path` may be the file it writes
+    auto recorder = std::make_unique<DrawDataRecorder>(path);
+    std::scoped_lock lock(this->replayMutex_);
+    this->recorder_ = std::move(recorder);
+}
+
+auto ImPlotEngine::stop_draw_recording() -> void {
+    std::scoped_lock lock(this->replayMutex_);
+    this->recorder_.reset();
+}
 
-    auto next = std::make_shared<std::vector<EntryPtr>>(*snap);
+auto ImPlotEngine::set_replay(std::shared_ptr<DrawDataReplay> replay) -> void {
+    {
+        std::scoped_lock lock(this->replayMutex_);
+        this->replay_ = std::move(replay);
+        this->replayFrame_ = 0;
+    }
+    this->invalidate();
+}
+
+// Pipelined prepare stage for the next frame. Entries stay alive: the registry only changes after the wait.
+auto ImPlotEngine::launch_prepares() -> void {
+    auto &pool = ThreadPool::shared();
+    this->preparesEpoch_ = this->invalidations_.load(std::memory_order_acquire);
+    this->drawers_.for_each([&](Entry &item) {
+        if (item.prepare) {
+            pool.submit(this->prepares_, [&item]() {
+                item.prepare();
+                item.prepared = true;
+            });
+        }
+    });
+}
 
-    auto old_size = next->size();
-    std::erase_if(*next, [&](const EntryPtr &item) { return item->key == name; });
+// Runs, in parallel, the prepares still missing for this frame: drawers added since the last launch, or all of
+// them when something was invalidated after that launch.
+auto ImPlotEngine::finish_prepares() -> void {
+    auto &pool = ThreadPool::shared();
+    const bool stale = this->invalidations_.load(std::memory_order_acquire) != this->preparesEpoch_;
+    this->drawers_.for_each([&](Entry &item) {
+        if (item.prepare && (stale || !item.prepared)) {
+            pool.submit(this->prepares_, [&item]() {
+                item.prepare();
+                item.prepared = true;
+            });
+        }
+    });
+    pool.wait(this->prepares_);
+}
 
-    if (next->size() != old_size) {
-        drawers_.store(std::shared_ptr<const std::vector<EntryPtr>>(std::move(next)), std::memory_order_release);
+auto ImPlotEngine::run_drawer(Entry &item, uint64_t epoch, int64_t now_ns) -> void {
+    item.prepared = false;
+    if (!item.update.cached()) {
+        item.fn();
+        return;
     }
+    const uint64_t version = item.version.load(std::memory_order_acquire);
+    if (!item.cache.needs_run(item.update, version, now_ns, epoch)) {
+        item.cache.replay();
+        return;
+    }
+    item.cache.begin_capture();
+    item.fn();
+    item.cache.end_capture(version, now_ns, epoch);
+    // An interval drawer has to be woken up for its next update when rendering on demand.
+    if (item.update.interval.count() > 0)
+        this->request_frame_in(item.update.interval);
+}
+
+// Frame boundary: everything queued so far, including mutations made by drawers during the previous frame.
+auto ImPlotEngine::apply_drawer_commands() -> void {
+    std::vector<DrawerCommand> commands;
+    while (this->drawerCommands_.pop(commands)) {
+        for (auto &cmd : commands)
+            this->drawers_.apply(cmd);
+        this->drawersLive_ = true;
+    }
+}
+
+auto ImPlotEngine::draw(EntryPtr item) -> uint32_t {
+    auto b = this->batch();
+    const uint32_t id = b.draw(std::move(item));
+    this->submit(std::move(b));
+    return id;
+}
+
+auto ImPlotEngine::remove_drawer(uint32_t id) -> void {
+    auto b = this->batch();
+    b.remove(id);
+    this->submit(std::move(b));
+}
+
+auto ImPlotEngine::remove_drawer(const std::string &name) -> void {
+    auto b = this->batch();
+    b.remove(name);
+    this->submit(std::move(b));
 }
 
 auto ImPlotEngine::remove_drawers() -> void {
+    auto b = this->batch();
+    b.clear();
+    this->submit(std::move(b));
+}
+
+auto ImPlotEngine::touch_drawer(uint32_t id) -> void {
+    auto b = this->batch();
+    b.touch(id);
+    this->submit(std::move(b));
+}
+
+auto ImPlotEngine::create_gpu_series(size_t capacity) -> std::shared_ptr<GpuSeries> {
+    this->await_init();
     std::scoped_lock guard(drawers_mutex_);
+    if (!this->initialized())
+        throw std::runtime_error("create_gpu_series: engine not initialized");
+    if (!GpuSeriesRenderer::available())
+        throw std::runtime_error("create_gpu_series: built without glslc, shaders unavailable");
+    return std::make_shared<GpuSeries>(this->vulkanHelper_, this->queue_, capacity);
+}
 
-    drawers_.store(std::make_shared<const std::vector<EntryPtr>>(), std::memory_order_release);
-}
\ No newline at end of file
+auto ImPlotEngine::submit(DrawerBatch &&batch) -> void {
+    if (batch.empty())
+        return;
+    this->drawerCommands_.push(std::move(batch.commands_));
+    // Not invalidate(): registry changes alone do not make the pipelined prepares of other drawers stale.
+    this->dirty_.store(true, std::memory_order_release);
+    this->wake();
+}
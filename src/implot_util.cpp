@@ -2,9 +2,12 @@
 
 #include <algorithm>  // std::min
 #include <cmath>      // std::sqrt
+#include <cstdint>
+#include <vector>
 
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include <implot.h>
+#include <implot_internal.h>
 
 static auto set_major_grid() {
     auto alpha = 0.05f;
@@ -97,27 +100,222 @@ auto ImPlotEndSub() -> void {
     ImGui::End();
 }
 
-static inline ImVec2 v2_add(ImVec2 a, ImVec2 b) { return ImVec2(a.x + b.x, a.y + b.y); }
-static inline ImVec2 v2_sub(ImVec2 a, ImVec2 b) { return ImVec2(a.x - b.x, a.y - b.y); }
-static inline ImVec2 v2_mul(ImVec2 v, float s) { return ImVec2(v.x * s, v.y * s); }
+namespace {
 
-static inline float v2_len(ImVec2 v) { return std::sqrt(v.x * v.x + v.y * v.y); }
+// Dash pieces of one polyline segment, in pattern coordinates: dash k covers [k * period, k * period + dash) and
+// the segment covers [start, end) after clipping.
+struct SegmentDashes {
+    ImVec2 p0;
+    ImVec2 dir;
+    double origin;  // pattern coordinate of p0
+    double start;
+    double end;
+    int64_t first;
+    int64_t last;
+    auto count() const -> size_t { return last >= first ? static_cast<size_t>(last - first + 1) : 0; }
+};
+
+// Liang-Barsky: narrows [t0, t1] to the part of p + t * (dx, dy) inside `clip`.
+auto clip_segment(ImVec2 p, float dx, float dy, const ImVec4 &clip, float &t0, float &t1) -> bool {
+    const float pq[4][2] = {{-dx, p.x - clip.x}, {dx, clip.z - p.x}, {-dy, p.y - clip.y}, {dy, clip.w - p.y}};
+    for (const auto &[pk, qk] : pq) {
+        if (pk == 0.0f) {
+            if (qk < 0.0f)
+                return false;
+            continue;
+        }
+        const float r = qk / pk;
+        if (pk < 0.0f) {
+            if (r > t1)
+                return false;
+            t0 = std::max(t0, r);
+        } else {
+            if (r < t0)
+                return false;
+            t1 = std::min(t1, r);
+        }
+    }
+    return t0 < t1;
+}
+
+// Walks the polyline keeping the pattern continuous across vertices and calls fn(SegmentDashes) for every segment
+// that has visible dashes. Only the clipped part of a segment is considered, so off-screen dashes cost nothing.
+// The counting and the writing pass both go through here, so they agree on the number of dashes exactly.
+// Returns the pattern coordinate at the last point.
+template <class F>
+auto walk_dashes(const ImVec2 *points, int count, double phase, double dash, double period, const ImVec4 &clip,
+                 F &&fn) -> double {
+    double dist = phase;
+    for (int i = 1; i < count; ++i) {
+        const ImVec2 p0 = points[i - 1];
+        const float dx = points[i].x - p0.x;
+        const float dy = points[i].y - p0.y;
+        const float len = std::sqrt(dx * dx + dy * dy);
+        if (!(len > 0.0f))  // also skips segments touching a NaN point
+            continue;
+        float t0 = 0.0f, t1 = 1.0f;
+        if (clip_segment(p0, dx, dy, clip, t0, t1)) {
+            SegmentDashes seg;
+            seg.p0 = p0;
+            seg.dir = ImVec2(dx / len, dy / len);
+            seg.origin = dist;
+            seg.start = dist + static_cast<double>(t0) * len;
+            seg.end = dist + static_cast<double>(t1) * len;
+            seg.first = static_cast<int64_t>(std::floor((seg.start - dash) / period)) + 1;
+            seg.last = static_cast<int64_t>(std::ceil(seg.end / period)) - 1;
+            if (seg.last >= seg.first)
+                fn(seg);
+        }
+        dist += len;
+    }
+    return dist;
+}
+
+// Writes dashes as quads straight into the draw list: a solid core plus, with anti-aliased lines, a transparent
+// fringe on each side, like ImDrawList::AddPolyline. Vertices are reserved up front (in chunks only when 16-bit
+// indices would overflow) and whatever is left unused is given back at the end.
+class DashWriter {
+  public:
+    DashWriter(ImDrawList *draw_list, ImU32 color, float thickness, size_t total)
+        : dl_(draw_list), color_(color), remaining_(total) {
+        this->aa_ = (draw_list->Flags & ImDrawListFlags_AntiAliasedLines) != 0;
+        const float fringe = this->aa_ ? draw_list->_FringeScale : 0.0f;
+        this->inner_ = this->aa_ ? std::max(thickness - fringe, 0.0f) * 0.5f : std::max(thickness, 1.0f) * 0.5f;
+        this->outer_ = this->inner_ + fringe;
+        this->uv_ = draw_list->_Data->TexUvWhitePixel;
+        this->colorTransparent_ = color & ~IM_COL32_A_MASK;
+    }
+
+    ~DashWriter() {
+        if (this->reserved_ > 0)
+            this->dl_->PrimUnreserve(static_cast<int>(this->reserved_ * idx_per()),
+                                     static_cast<int>(this->reserved_ * vtx_per()));
+    }
+
+    auto add(ImVec2 a, ImVec2 b, ImVec2 dir) -> void {
+        if (this->reserved_ == 0)
+            this->reserve();
+        --this->reserved_;
+        const ImVec2 n(-dir.y, dir.x);
+        const ImDrawIdx base = static_cast<ImDrawIdx>(this->dl_->_VtxCurrentIdx);
+        if (!this->aa_) {
+            const ImVec2 h(n.x * this->inner_, n.y * this->inner_);
+            this->dl_->PrimWriteVtx(ImVec2(a.x + h.x, a.y + h.y), this->uv_, this->color_);
+            this->dl_->PrimWriteVtx(ImVec2(a.x - h.x, a.y - h.y), this->uv_, this->color_);
+            this->dl_->PrimWriteVtx(ImVec2(b.x - h.x, b.y - h.y), this->uv_, this->color_);
+            this->dl_->PrimWriteVtx(ImVec2(b.x + h.x, b.y + h.y), this->uv_, this->color_);
+            this->quad(base, base + 1, base + 2, base + 3);
+            return;
+        }
+        // Rows across the dash: +outer (transparent), +inner, -inner, -outer (transparent); one row per end.
+        const float offsets[4] = {this->outer_, this->inner_, -this->inner_, -this->outer_};
+        for (const ImVec2 p : {a, b})
+            for (int r = 0; r < 4; ++r)
+                this->dl_->PrimWriteVtx(ImVec2(p.x + n.x * offsets[r], p.y + n.y * offsets[r]), this->uv_,
+                                        r == 0 || r == 3 ? this->colorTransparent_ : this->color_);
+        for (int r = 0; r < 3; ++r)
+            this->quad(base + r, base + r + 1, base + 4 + r + 1, base + 4 + r);
+    }
+
+  private:
+    auto vtx_per() const -> size_t { return this->aa_ ? 8 : 4; }
+    auto idx_per() const -> size_t { return this->aa_ ? 18 : 6; }
+
+    auto reserve() -> void {
+        const size_t limit = sizeof(ImDrawIdx) == 2 ? 65536 / vtx_per() : INT32_MAX / idx_per();
+        const size_t n = std::min(this->remaining_, limit);
+        IM_ASSERT(n > 0);
+        this->dl_->PrimReserve(static_cast<int>(n * idx_per()), static_cast<int>(n * vtx_per()));
+        this->remaining_ -= n;
+        this->reserved_ = n;
+    }
+
+    auto quad(unsigned a, unsigned b, unsigned c, unsigned d) -> void {
+        this->dl_->PrimWriteIdx(static_cast<ImDrawIdx>(a));
+        this->dl_->PrimWriteIdx(static_cast<ImDrawIdx>(b));
+        this->dl_->PrimWriteIdx(static_cast<ImDrawIdx>(c));
+        this->dl_->PrimWriteIdx(static_cast<ImDrawIdx>(a));
+        this->dl_->PrimWriteIdx(static_cast<ImDrawIdx>(c));
+        this->dl_->PrimWriteIdx(static_cast<ImDrawIdx>(d));
+    }
+
+    ImDrawList *dl_;
+    ImU32 color_;
+    ImU32 colorTransparent_;
+    ImVec2 uv_;
+    bool aa_;
+    float inner_;
+    float outer_;
+    size_t remaining_;
+    size_t reserved_{0};
+};
+
+}  // namespace
+
+auto AddDashedPolyline(ImDrawList *draw_list, const ImVec2 *points, int count, ImU32 color, float thickness,
+                       float dash_len, float gap_len, float phase) -> float {
+    const double dash = dash_len;
+    const double period = static_cast<double>(dash_len) + gap_len;
+    if (count < 2 || (color & IM_COL32_A_MASK) == 0 || !(dash > 0.0))
+        return phase;
+
+    // Dashes reaching into the clip rect by less than their half width still show, so widen it accordingly.
+    const float pad = thickness * 0.5f + draw_list->_FringeScale;
+    const ImVec2 clip_min = draw_list->GetClipRectMin();
+    const ImVec2 clip_max = draw_list->GetClipRectMax();
+    const ImVec4 clip(clip_min.x - pad, clip_min.y - pad, clip_max.x + pad, clip_max.y + pad);
+
+    size_t total = 0;
+    const double end =
+        walk_dashes(points, count, phase, dash, period, clip, [&](const SegmentDashes &seg) { total += seg.count(); });
+    if (total > 0) {
+        DashWriter writer(draw_list, color, thickness, total);
+        walk_dashes(points, count, phase, dash, period, clip, [&](const SegmentDashes &seg) {
+            for (int64_t k = seg.first; k <= seg.last; ++k) {
+                const double from = std::max(static_cast<double>(k) * period, seg.start) - seg.origin;
+                const double to = std::min(static_cast<double>(k) * period + dash, seg.end) - seg.origin;
+                const ImVec2 a(seg.p0.x + seg.dir.x * static_cast<float>(from),
+                               seg.p0.y + seg.dir.y * static_cast<float>(from));
+                const ImVec2 b(seg.p0.x + seg.dir.x * static_cast<float>(to),
+                               seg.p0.y + seg.dir.y * static_cast<float>(to));
+                writer.add(a, b, seg.dir);
+            }
+        });
+    }
+    return static_cast<float>(std::fmod(end, period));
+}
 
 auto AddDashedLine(ImDrawList *draw_list, ImVec2 p1, ImVec2 p2, ImU32 color, float thickness, float dash_len,
                    float gap_len) -> void {
-    const ImVec2 delta = v2_sub(p2, p1);
-    const float len = v2_len(delta);
-    if (len <= 0.0f)
-        return;
+    const ImVec2 points[2] = {p1, p2};
+    AddDashedPolyline(draw_list, points, 2, color, thickness, dash_len, gap_len);
+}
 
-    const ImVec2 dir = v2_mul(delta, 1.0f / len);
+auto PlotDashedLine(const char *label, const double *xs, const double *ys, int count, float dash_len, float gap_len,
+                    ImPlotItemFlags flags) -> void {
+    if (!ImPlot::BeginItem(label, flags, ImPlotCol_Line))
+        return;
 
-    float dist = 0.0f;
-    while (dist < len) {
-        const float seg_len = std::min(dash_len, len - dist);
-        const ImVec2 a = v2_add(p1, v2_mul(dir, dist));
-        const ImVec2 b = v2_add(p1, v2_mul(dir, dist + seg_len));
-        draw_list->AddLine(a, b, color, thickness);
-        dist += dash_len + gap_len;
+    ImPlotPlot &plot = *ImPlot::GetCurrentPlot();
+    ImPlotAxis &x_axis = plot.Axes[plot.CurrentX];
+    ImPlotAxis &y_axis = plot.Axes[plot.CurrentY];
+    if (plot.FitThisFrame && !ImHasFlag(flags, ImPlotItemFlags_NoFit)) {
+        for (int i = 0; i < count; ++i) {
+            x_axis.ExtendFitWith(y_axis, xs[i], ys[i]);
+            y_axis.ExtendFitWith(x_axis, ys[i], xs[i]);
+        }
     }
+
+    // Scratch for the pixel-space polyline, reused across calls on this render thread.
+    thread_local std::vector<ImVec2> pixels;
+    pixels.resize(static_cast<size_t>(std::max(count, 0)));
+    for (int i = 0; i < count; ++i)
+        pixels[i] = ImVec2(x_axis.PlotToPixels(xs[i]), y_axis.PlotToPixels(ys[i]));
+
+    const ImPlotNextItemData &style = ImPlot::GetItemData();
+    ImPlot::PushPlotClipRect();
+    AddDashedPolyline(ImPlot::GetPlotDrawList(), pixels.data(), count, ImGui::GetColorU32(style.Colors[ImPlotCol_Line]),
+                      style.LineWeight, dash_len, gap_len);
+    ImPlot::PopPlotClipRect();
+    ImPlot::EndItem();
 }
@@ -0,0 +1,300 @@
+#include "mapped_columns.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <implot.h>
+#include <implot_internal.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'I', 'P', 'U', 'C', 'O', 'L', 'S', 0};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kSorted = 1u << 0;
+constexpr uint64_t kDataAlign = 64;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t columnCount;
+    uint64_t rows;
+    uint64_t reserved;
+};
+static_assert(sizeof(FileHeader) == 32);
+
+struct ColumnHeader {
+    char name[40];  // NUL-terminated
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t stride;
+    double scale;
+    double min;
+    double max;
+    uint64_t reserved;
+};
+static_assert(sizeof(ColumnHeader) == 96);
+
+auto type_size(ColumnType type) -> size_t { return type == ColumnType::F32 ? 4 : 8; }
+
+auto read_value(const unsigned char *p, ColumnType type, double scale) -> double {
+    switch (type) {
+    case ColumnType::F32: {
+        float v;
+        std::memcpy(&v, p, sizeof(v));
+        return static_cast<double>(v) * scale;
+    }
+    case ColumnType::I64: {
+        int64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return static_cast<double>(v) * scale;
+    }
+    case ColumnType::F64:
+    default: {
+        double v;
+        std::memcpy(&v, p, sizeof(v));
+        return v * scale;
+    }
+    }
+}
+
+auto sys_error(const std::string &what, const std::string &path) -> std::runtime_error {
+    return std::runtime_error("MappedColumns: " + what + " " + path + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+auto WriteMappedColumns(const std::string &path, const std::vector<MappedColumnSpec> &columns, size_t rows) -> void {
+    const size_t header_bytes = sizeof(FileHeader) + columns.size() * sizeof(ColumnHeader);
+    std::vector<ColumnHeader> headers(columns.size());
+    uint64_t offset = (header_bytes + kDataAlign - 1) / kDataAlign * kDataAlign;
+    for (size_t c = 0; c < columns.size(); ++c) {
+        const MappedColumnSpec &spec = columns[c];
+        if (spec.name.size() >= sizeof(ColumnHeader::name))
+            throw std::runtime_error("WriteMappedColumns: column name too long: " + spec.name);
+        ColumnHeader &h = headers[c];
+        h = ColumnHeader{};
+        std::memcpy(h.name, spec.name.data(), spec.name.size());
+        h.type = static_cast<uint32_t>(spec.type);
+        h.offset = offset;
+        h.stride = type_size(spec.type);
+        h.scale = spec.scale;
+        h.min = std::numeric_limits<double>::infinity();
+        h.max = -std::numeric_limits<double>::infinity();
+        bool sorted = true;
+        double prev = -std::numeric_limits<double>::infinity();
+        const auto *bytes = static_cast<const unsigned char *>(spec.data);
+        for (size_t r = 0; r < rows; ++r) {
+            const double v = read_value(bytes + r * h.stride, spec.type, spec.scale);
+            if (std::isnan(v)) {
+                sorted = false;
+                continue;
+            }
+            h.min = std::min(h.min, v);
+            h.max = std::max(h.max, v);
+            sorted = sorted && v >= prev;
+            prev = v;
+        }
+        h.flags = sorted ? kSorted : 0;
+        offset += (rows * h.stride + kDataAlign - 1) / kDataAlign * kDataAlign;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        throw std::runtime_error("WriteMappedColumns: cannot open " + path);
+    FileHeader fh{};
+    std::memcpy(fh.magic, kMagic, sizeof(kMagic));
+    fh.version = kVersion;
+    fh.columnCount = static_cast<uint32_t>(columns.size());
+    fh.rows = rows;
+    file.write(reinterpret_cast<const char *>(&fh), sizeof(fh));
+    file.write(reinterpret_cast<const char *>(headers.data()),
+               static_cast<std::streamsize>(headers.size() * sizeof(ColumnHeader)));
+    const char zeros[kDataAlign] = {};
+    uint64_t written = header_bytes;
+    for (size_t c = 0; c < columns.size(); ++c) {
+        file.write(zeros, static_cast<std::streamsize>(headers[c].offset - written));
+        const uint64_t bytes = rows * headers[c].stride;
+        file.write(static_cast<const char *>(columns[c].data), static_cast<std::streamsize>(bytes));
+        written = headers[c].offset + bytes;
+    }
+    if (!file)
+        throw std::runtime_error("WriteMappedColumns: cannot write " + path);
+}
+
+MappedColumns::MappedColumns(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw sys_error("cannot open", path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        const auto err = sys_error("cannot stat", path);
+        ::close(fd);
+        throw err;
+    }
+    this->mapSize_ = static_cast<size_t>(st.st_size);
+    if (this->mapSize_ < sizeof(FileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("MappedColumns: " + path + " is too small");
+    }
+    this->map_ = ::mmap(nullptr, this->mapSize_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // the mapping keeps the file referenced
+    if (this->map_ == MAP_FAILED) {
+        this->map_ = nullptr;
+        throw sys_error("cannot map", path);
+    }
+
+    try {
+        const auto *base = static_cast<const unsigned char *>(this->map_);
+        FileHeader fh;
+        std::memcpy(&fh, base, sizeof(fh));
+        if (std::memcmp(fh.magic, kMagic, sizeof(kMagic)) != 0 || fh.version != kVersion)
+            throw std::runtime_error("MappedColumns: " + path + " is not a column file");
+        if (fh.columnCount > (this->mapSize_ - sizeof(FileHeader)) / sizeof(ColumnHeader))
+            throw std::runtime_error("MappedColumns: " + path + " is truncated");
+        this->rows_ = fh.rows;
+
+        for (uint32_t c = 0; c < fh.columnCount; ++c) {
+            ColumnHeader h;
+            std::memcpy(&h, base + sizeof(FileHeader) + c * sizeof(ColumnHeader), sizeof(h));
+            const auto type = static_cast<ColumnType>(h.type);
+            if (type != ColumnType::F32 && type != ColumnType::F64 && type != ColumnType::I64)
+                throw std::runtime_error("MappedColumns: " + path + " has a column of unknown type");
+            // Last value must end inside the file; checked without overflow for hostile headers.
+            const uint64_t size = type_size(type);
+            if (this->rows_ > 0) {
+                const uint64_t last = this->rows_ - 1;
+                if (h.stride < size || h.offset > this->mapSize_ || last > (this->mapSize_ - h.offset) / h.stride ||
+                    last * h.stride + size > this->mapSize_ - h.offset)
+                    throw std::runtime_error("MappedColumns: " + path + " has a column outside the file");
+            }
+            h.name[sizeof(h.name) - 1] = 0;
+            this->columns_.push_back(Column{h.name, type, h.offset, h.stride, h.scale != 0.0 ? h.scale : 1.0, h.min,
+                                            h.max, (h.flags & kSorted) != 0});
+        }
+    } catch (...) {
+        ::munmap(this->map_, this->mapSize_);
+        throw;
+    }
+}
+
+MappedColumns::~MappedColumns() {
+    if (this->map_)
+        ::munmap(this->map_, this->mapSize_);
+}
+
+auto MappedColumns::find(const std::string &name) const -> int {
+    for (size_t c = 0; c < this->columns_.size(); ++c)
+        if (this->columns_[c].name == name)
+            return static_cast<int>(c);
+    return -1;
+}
+
+auto MappedColumns::value(int column, size_t row) const -> double {
+    const Column &c = this->columns_[column];
+    return read_value(static_cast<const unsigned char *>(this->map_) + c.offset + row * c.stride, c.type, c.scale);
+}
+
+auto MappedColumns::advise(MappedAccess access) const -> void {
+    const int advice = access == MappedAccess::Sequential ? MADV_SEQUENTIAL
+                       : access == MappedAccess::Random   ? MADV_RANDOM
+                                                          : MADV_NORMAL;
+    ::madvise(this->map_, this->mapSize_, advice);  // a hint; failure changes nothing
+}
+
+auto MappedColumns::prefetch(int column, size_t first, size_t count) const -> void {
+    if (count == 0 || first >= this->rows_)
+        return;
+    count = std::min(count, this->rows_ - first);
+    const Column &c = this->columns_[column];
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t begin = (c.offset + first * c.stride) / page * page;
+    const size_t end = std::min(c.offset + (first + count - 1) * c.stride + type_size(c.type), this->mapSize_);
+    ::madvise(static_cast<unsigned char *>(this->map_) + begin, end - begin, MADV_WILLNEED);
+}
+
+auto MappedColumns::visible_rows(int x, double x_min, double x_max, size_t &first, size_t &count) const -> void {
+    first = 0;
+    count = this->rows_;
+    if (!this->columns_[x].sorted || !(x_max > x_min) || this->rows_ == 0)
+        return;
+    // Binary searches touch O(log rows) pages, the rest of the column stays on disk.
+    auto lower = [&](double v, bool upper) {
+        size_t lo = 0, hi = this->rows_;
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            const double m = this->value(x, mid);
+            if (upper ? m <= v : m < v)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    };
+    size_t b = lower(x_min, false);
+    size_t e = lower(x_max, true);
+    if (b > 0)
+        --b;
+    if (e < this->rows_)
+        ++e;
+    first = b;
+    count = e - b;
+}
+
+auto MappedColumns::getter(int idx, void *data) -> ImPlotPoint {
+    const auto *c = static_cast<const Cursor *>(data);
+    const size_t row = c->first + static_cast<size_t>(idx);
+    return ImPlotPoint(c->source->value(c->x, row), c->source->value(c->y, row));
+}
+
+// Fits from the header, picks the visible rows and prefetches around them. Returns the number of rows to plot.
+auto MappedColumns::prepare_plot(int x, int y, ImPlotItemFlags flags, Cursor &cursor) const -> int {
+    ImPlotPlot &plot = *ImPlot::GetCurrentPlot();
+    const Column &cx = this->columns_[x];
+    const Column &cy = this->columns_[y];
+    if (plot.FitThisFrame && !ImHasFlag(flags, ImPlotItemFlags_NoFit) && std::isfinite(cx.min) &&
+        std::isfinite(cy.min)) {
+        ImPlotAxis &x_axis = plot.Axes[plot.CurrentX];
+        ImPlotAxis &y_axis = plot.Axes[plot.CurrentY];
+        x_axis.ExtendFitWith(y_axis, cx.min, cy.min);
+        x_axis.ExtendFitWith(y_axis, cx.max, cy.max);
+        y_axis.ExtendFitWith(x_axis, cy.min, cx.min);
+        y_axis.ExtendFitWith(x_axis, cy.max, cx.max);
+    }
+
+    const ImPlotRect limits = ImPlot::GetPlotLimits();
+    size_t first = 0, count = 0;
+    this->visible_rows(x, limits.X.Min, limits.X.Max, first, count);
+    if (count < this->rows_) {
+        const size_t ahead_first = first > count ? first - count : 0;
+        const size_t ahead_count = std::min(first + 2 * count, this->rows_) - ahead_first;
+        this->prefetch(x, ahead_first, ahead_count);
+        if (y != x)
+            this->prefetch(y, ahead_first, ahead_count);
+    }
+    cursor = Cursor{this, x, y, first};
+    return static_cast<int>(std::min<size_t>(count, INT_MAX));
+}
+
+auto MappedColumns::plot_line(const char *label, int x, int y, ImPlotLineFlags flags) const -> void {
+    Cursor cursor;
+    const int count = this->prepare_plot(x, y, flags, cursor);
+    ImPlot::PlotLineG(label, &getter, &cursor, count, flags | ImPlotItemFlags_NoFit);
+}
+
+auto MappedColumns::plot_scatter(const char *label, int x, int y, ImPlotScatterFlags flags) const -> void {
+    Cursor cursor;
+    const int count = this->prepare_plot(x, y, flags, cursor);
+    ImPlot::PlotScatterG(label, &getter, &cursor, count, flags | ImPlotItemFlags_NoFit);
+}
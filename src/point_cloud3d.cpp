@@ -0,0 +1,264 @@
+#include "point_cloud3d.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+
+#include <implot3d.h>
+#include <implot3d_internal.h>
+
+namespace {
+
+// Below this a node is not split further even if it holds more than leaf_size points (duplicates).
+constexpr int kMaxDepth = 21;
+// A visible leaf contributes at least this many points, so distant parts of the cloud never vanish entirely.
+constexpr double kMinLeafPoints = 8.0;
+
+struct Box {
+    float min[3];
+    float max[3];
+};
+
+auto overlaps(const float *min, const float *max, const Box &box) -> bool {
+    for (int a = 0; a < 3; ++a)
+        if (max[a] < box.min[a] || min[a] > box.max[a])
+            return false;
+    return true;
+}
+
+// Screen-space area, in pixels, of the part of [min, max] inside `box`.
+auto projected_area(const float *min, const float *max, const Box &box) -> double {
+    float lo[3], hi[3];
+    for (int a = 0; a < 3; ++a) {
+        lo[a] = std::max(min[a], box.min[a]);
+        hi[a] = std::min(max[a], box.max[a]);
+    }
+    float x0 = FLT_MAX, y0 = FLT_MAX, x1 = -FLT_MAX, y1 = -FLT_MAX;
+    for (int c = 0; c < 8; ++c) {
+        const ImVec2 p = ImPlot3D::PlotToPixels(
+            ImPlot3DPoint((c & 1) ? hi[0] : lo[0], (c & 2) ? hi[1] : lo[1], (c & 4) ? hi[2] : lo[2]));
+        x0 = std::min(x0, p.x);
+        y0 = std::min(y0, p.y);
+        x1 = std::max(x1, p.x);
+        y1 = std::max(y1, p.y);
+    }
+    return static_cast<double>(x1 - x0) * static_cast<double>(y1 - y0);
+}
+
+}  // namespace
+
+PointCloud3D::PointCloud3D(std::vector<float> xs, std::vector<float> ys, std::vector<float> zs, size_t leaf_size)
+    : xs_(std::move(xs)), ys_(std::move(ys)), zs_(std::move(zs)),
+      count_(std::min({this->xs_.size(), this->ys_.size(), this->zs_.size(), static_cast<size_t>(UINT32_MAX)})),
+      leafSize_(std::max<size_t>(leaf_size, 16)) {
+    this->builder_ = std::jthread([this](std::stop_token st) { this->build(st); });
+}
+
+PointCloud3D::~PointCloud3D() { this->builder_.request_stop(); }
+
+auto PointCloud3D::build(std::stop_token st) -> void {
+    auto tree = std::make_unique<Tree>();
+
+    // Non-finite points are dropped here, so every comparison below is well defined.
+    std::vector<uint32_t> idx;
+    idx.reserve(this->count_);
+    Box root{{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+    for (uint32_t i = 0; i < this->count_; ++i) {
+        const float p[3] = {this->xs_[i], this->ys_[i], this->zs_[i]};
+        if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2]))
+            continue;
+        idx.push_back(i);
+        for (int a = 0; a < 3; ++a) {
+            root.min[a] = std::min(root.min[a], p[a]);
+            root.max[a] = std::max(root.max[a], p[a]);
+        }
+    }
+
+    if (!idx.empty()) {
+        std::vector<uint32_t> tmp(idx.size());
+        std::vector<Box> boxes;  // split box per node; children halve it
+        std::vector<uint8_t> depth;
+        tree->nodes.push_back(Node{{}, {}, 0, static_cast<uint32_t>(idx.size()), 0, 0});
+        boxes.push_back(root);
+        depth.push_back(0);
+
+        // Children are appended after their parent, so processing in index order is breadth-first.
+        for (size_t n = 0; n < tree->nodes.size(); ++n) {
+            if (st.stop_requested())
+                return;
+            const uint32_t first = tree->nodes[n].first;
+            const uint32_t count = tree->nodes[n].count;
+            const Box box = boxes[n];
+            if (count <= this->leafSize_ || depth[n] >= kMaxDepth) {
+                // Shuffle, so that a prefix of the leaf is a uniform sample of it.
+                uint64_t state = 0x9e3779b97f4a7c15ull ^ first;
+                for (uint32_t i = count; i > 1; --i) {
+                    state ^= state << 13;
+                    state ^= state >> 7;
+                    state ^= state << 17;
+                    std::swap(idx[first + i - 1], idx[first + static_cast<uint32_t>(state % i)]);
+                }
+                continue;
+            }
+
+            const float center[3] = {0.5f * (box.min[0] + box.max[0]), 0.5f * (box.min[1] + box.max[1]),
+                                     0.5f * (box.min[2] + box.max[2])};
+            auto octant = [&](uint32_t i) {
+                return (this->xs_[i] >= center[0] ? 1 : 0) | (this->ys_[i] >= center[1] ? 2 : 0) |
+                       (this->zs_[i] >= center[2] ? 4 : 0);
+            };
+            uint32_t counts[8] = {};
+            for (uint32_t i = first; i < first + count; ++i)
+                ++counts[octant(idx[i])];
+            uint32_t offsets[8];
+            uint32_t at = first;
+            for (int o = 0; o < 8; ++o) {
+                offsets[o] = at;
+                at += counts[o];
+            }
+            for (uint32_t i = first; i < first + count; ++i)
+                tmp[offsets[octant(idx[i])]++] = idx[i];
+            std::copy(tmp.begin() + first, tmp.begin() + first + count, idx.begin() + first);
+
+            tree->nodes[n].firstChild = static_cast<uint32_t>(tree->nodes.size());
+            uint32_t child_first = first;
+            for (int o = 0; o < 8; ++o) {
+                if (counts[o] == 0)
+                    continue;
+                Box child;
+                for (int a = 0; a < 3; ++a) {
+                    const bool upper = (o >> a) & 1;
+                    child.min[a] = upper ? center[a] : box.min[a];
+                    child.max[a] = upper ? box.max[a] : center[a];
+                }
+                tree->nodes.push_back(Node{{}, {}, child_first, counts[o], 0, 0});
+                boxes.push_back(child);
+                depth.push_back(static_cast<uint8_t>(depth[n] + 1));
+                child_first += counts[o];
+                ++tree->nodes[n].childCount;
+            }
+        }
+
+        tree->xs.resize(idx.size());
+        tree->ys.resize(idx.size());
+        tree->zs.resize(idx.size());
+        for (size_t i = 0; i < idx.size(); ++i) {
+            tree->xs[i] = this->xs_[idx[i]];
+            tree->ys[i] = this->ys_[idx[i]];
+            tree->zs[i] = this->zs_[idx[i]];
+        }
+
+        // Tight bounds, children before parents.
+        for (size_t n = tree->nodes.size(); n-- > 0;) {
+            Node &node = tree->nodes[n];
+            std::fill(node.min, node.min + 3, FLT_MAX);
+            std::fill(node.max, node.max + 3, -FLT_MAX);
+            if (node.childCount == 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const float p[3] = {tree->xs[i], tree->ys[i], tree->zs[i]};
+                    for (int a = 0; a < 3; ++a) {
+                        node.min[a] = std::min(node.min[a], p[a]);
+                        node.max[a] = std::max(node.max[a], p[a]);
+                    }
+                }
+            } else {
+                for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c) {
+                    for (int a = 0; a < 3; ++a) {
+                        node.min[a] = std::min(node.min[a], tree->nodes[c].min[a]);
+                        node.max[a] = std::max(node.max[a], tree->nodes[c].max[a]);
+                    }
+                }
+            }
+        }
+    }
+
+    this->tree_ = std::move(tree);
+    this->ready_.store(true, std::memory_order_release);
+}
+
+auto PointCloud3D::plot(const char *label, ImPlot3DScatterFlags flags) -> void {
+    if (!this->ready()) {
+        const size_t stride = std::max<size_t>(1, (this->count_ + this->budget_ - 1) / this->budget_);
+        const size_t n = (this->count_ + stride - 1) / stride;
+        this->drawnPoints_ = n;
+        this->drawnLeaves_ = 0;
+        ImPlot3D::PlotScatter(label, this->xs_.data(), this->ys_.data(), this->zs_.data(),
+                              static_cast<int>(std::min<size_t>(n, INT_MAX)), flags, 0,
+                              static_cast<int>(stride * sizeof(float)));
+        return;
+    }
+    if (!this->released_) {
+        // The builder is done with them.
+        this->xs_ = {};
+        this->ys_ = {};
+        this->zs_ = {};
+        this->released_ = true;
+    }
+
+    const Tree &tree = *this->tree_;
+    this->gx_.clear();
+    this->gy_.clear();
+    this->gz_.clear();
+    this->picks_.clear();
+    this->drawnPoints_ = 0;
+    this->drawnLeaves_ = 0;
+    if (tree.nodes.empty())
+        return;
+
+    ImPlot3DPlot &plot = *ImPlot3D::GetCurrentPlot();
+    // Fitting goes to the cloud's bounds, which the root holds, rather than to the sampled points; the walk then
+    // sees the view the axes are about to get.
+    const Node &root = tree.nodes[0];
+    const bool fitting = plot.FitThisFrame && !(flags & ImPlot3DItemFlags_NoFit);
+    Box view;
+    for (int a = 0; a < 3; ++a) {
+        if (fitting) {
+            plot.Axes[a].ExtendFit(root.min[a]);
+            plot.Axes[a].ExtendFit(root.max[a]);
+            view.min[a] = root.min[a];
+            view.max[a] = root.max[a];
+        } else {
+            view.min[a] = static_cast<float>(plot.Axes[a].Range.Min);
+            view.max[a] = static_cast<float>(plot.Axes[a].Range.Max);
+        }
+    }
+
+    double total = 0.0;
+    this->stack_.assign(1, 0);
+    while (!this->stack_.empty()) {
+        const Node &node = tree.nodes[this->stack_.back()];
+        const uint32_t index = this->stack_.back();
+        this->stack_.pop_back();
+        if (!overlaps(node.min, node.max, view))
+            continue;
+        if (node.childCount > 0) {
+            for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c)
+                this->stack_.push_back(c);
+            continue;
+        }
+        const double area = projected_area(node.min, node.max, view);
+        const double want = std::min<double>(node.count, std::max(kMinLeafPoints, area * this->density_));
+        this->picks_.push_back(Pick{index, want});
+        total += want;
+    }
+
+    const double scale = total > static_cast<double>(this->budget_) ? static_cast<double>(this->budget_) / total : 1.0;
+    for (const Pick &pick : this->picks_) {
+        // At least one point per leaf keeps sparse regions visible, but never past the budget: with more visible
+        // leaves than budget the later ones are skipped.
+        const size_t left = this->budget_ - this->gx_.size();
+        if (left == 0)
+            break;
+        const Node &node = tree.nodes[pick.node];
+        const auto take = std::min(std::clamp<size_t>(static_cast<size_t>(pick.want * scale), 1, node.count), left);
+        ++this->drawnLeaves_;
+        this->gx_.insert(this->gx_.end(), tree.xs.begin() + node.first, tree.xs.begin() + node.first + take);
+        this->gy_.insert(this->gy_.end(), tree.ys.begin() + node.first, tree.ys.begin() + node.first + take);
+        this->gz_.insert(this->gz_.end(), tree.zs.begin() + node.first, tree.zs.begin() + node.first + take);
+    }
+    this->drawnPoints_ = this->gx_.size();
+    ImPlot3D::PlotScatter(label, this->gx_.data(), this->gy_.data(), this->gz_.data(),
+                          static_cast<int>(std::min<size_t>(this->gx_.size(), INT_MAX)),
+                          flags | ImPlot3DItemFlags_NoFit);
+}
@@ -0,0 +1,220 @@
+#include "pyramid_series.h"
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <mutex>
+#include <stdexcept>
+
+#include <implot.h>
+#include <implot_internal.h>
+
+namespace {
+
+// Levels are added until the top one is this small, so a whole-series view always has a level to draw from.
+constexpr size_t kTopBuckets = 64;
+// Raw samples are drawn as they are while there are at most this many per pixel column.
+constexpr size_t kRawPerColumn = 4;
+
+}  // namespace
+
+PyramidSeries::PyramidSeries(size_t base_bucket) : base_(std::bit_ceil(std::max<size_t>(base_bucket, 2))) {}
+
+auto PyramidSeries::reserve(size_t count) -> void {
+    std::unique_lock lock(this->mutex_);
+    this->xs_.reserve(count);
+    this->ys_.reserve(count);
+}
+
+auto PyramidSeries::size() const -> size_t {
+    std::shared_lock lock(this->mutex_);
+    return this->xs_.size();
+}
+
+auto PyramidSeries::levels() const -> size_t {
+    std::shared_lock lock(this->mutex_);
+    return this->levels_.size();
+}
+
+auto PyramidSeries::append(const double *xs, const double *ys, size_t count) -> void {
+    if (count == 0)
+        return;
+    std::unique_lock lock(this->mutex_);
+    double last = this->xs_.empty() ? xs[0] : this->xs_.back();
+    for (size_t i = 0; i < count; ++i) {
+        if (xs[i] < last)
+            throw std::invalid_argument("PyramidSeries: x must be non-decreasing");
+        last = xs[i];
+    }
+    const size_t old_size = this->xs_.size();
+    this->xs_.insert(this->xs_.end(), xs, xs + count);
+    this->ys_.insert(this->ys_.end(), ys, ys + count);
+    this->rebuild_from(old_size);
+}
+
+auto PyramidSeries::merge(const Bucket &a, const Bucket &b) const -> Bucket {
+    // a precedes b in time, so keeping a on ties keeps the first occurrence.
+    return Bucket{this->ys_[b.imin] < this->ys_[a.imin] ? b.imin : a.imin,
+                  this->ys_[b.imax] > this->ys_[a.imax] ? b.imax : a.imax, a.sum + b.sum};
+}
+
+// Recomputes every bucket that covers a sample at or after `old_size`: the trailing, possibly partial, bucket of
+// each level and whatever the new samples added after it.
+auto PyramidSeries::rebuild_from(size_t old_size) -> void {
+    const size_t n = this->xs_.size();
+    if (this->levels_.empty())
+        this->levels_.emplace_back();
+
+    size_t changed = old_size / this->base_;
+    {
+        std::vector<Bucket> &level = this->levels_[0];
+        level.resize((n + this->base_ - 1) / this->base_);
+        for (size_t b = changed; b < level.size(); ++b) {
+            const size_t begin = b * this->base_;
+            const size_t end = std::min(begin + this->base_, n);
+            Bucket out{begin, begin, this->ys_[begin]};
+            for (size_t i = begin + 1; i < end; ++i) {
+                const double y = this->ys_[i];
+                if (y < this->ys_[out.imin])
+                    out.imin = i;
+                if (y > this->ys_[out.imax])
+                    out.imax = i;
+                out.sum += y;
+            }
+            level[b] = out;
+        }
+    }
+
+    for (size_t l = 1;; ++l) {
+        if (l == this->levels_.size()) {
+            if (this->levels_.back().size() <= kTopBuckets)
+                break;
+            this->levels_.emplace_back();
+            changed = 0;
+        } else {
+            changed /= 2;
+        }
+        const std::vector<Bucket> &child = this->levels_[l - 1];
+        std::vector<Bucket> &level = this->levels_[l];
+        level.resize((child.size() + 1) / 2);
+        for (size_t b = changed; b < level.size(); ++b)
+            level[b] = 2 * b + 1 < child.size() ? this->merge(child[2 * b], child[2 * b + 1]) : child[2 * b];
+    }
+}
+
+auto PyramidSeries::bucket_mid_x(int level, size_t bucket) const -> double {
+    const size_t s = this->bucket_size(level);
+    const size_t begin = bucket * s;
+    const size_t last = std::min(begin + s, this->xs_.size()) - 1;
+    return 0.5 * (this->xs_[begin] + this->xs_[last]);
+}
+
+auto PyramidSeries::bucket_mean(int level, size_t bucket) const -> double {
+    const size_t s = this->bucket_size(level);
+    const size_t begin = bucket * s;
+    const size_t count = std::min(begin + s, this->xs_.size()) - begin;
+    return this->levels_[level - 1][bucket].sum / static_cast<double>(count);
+}
+
+auto PyramidSeries::select(double x_min, double x_max, int pixel_width) const -> Selection {
+    std::shared_lock lock(this->mutex_);
+    return this->select_locked(x_min, x_max, pixel_width);
+}
+
+auto PyramidSeries::select_locked(double x_min, double x_max, int pixel_width) const -> Selection {
+    const size_t n = this->xs_.size();
+    if (n == 0)
+        return {};
+    size_t first = 0, last = n;
+    if (x_max > x_min) {
+        const auto b = std::lower_bound(this->xs_.begin(), this->xs_.end(), x_min);
+        const auto e = std::upper_bound(b, this->xs_.end(), x_max);
+        first = static_cast<size_t>(b - this->xs_.begin());
+        last = static_cast<size_t>(e - this->xs_.begin());
+        if (first > 0)
+            --first;
+        if (last < n)
+            ++last;
+    }
+
+    const size_t visible = last - first;
+    const size_t cols = static_cast<size_t>(std::max(pixel_width, 1));
+    int level = 0;
+    if (visible > kRawPerColumn * cols) {
+        // Coarsest level with at least one bucket per column.
+        const size_t per_column = visible / cols;
+        while (level < static_cast<int>(this->levels_.size()) && this->bucket_size(level + 1) <= per_column)
+            ++level;
+    }
+    if (level == 0)
+        return Selection{0, first, visible};
+    const size_t s = this->bucket_size(level);
+    return Selection{level, first / s, (last - 1) / s - first / s + 1};
+}
+
+auto PyramidSeries::raw_getter(int idx, void *data) -> ImPlotPoint {
+    const auto *c = static_cast<const Cursor *>(data);
+    const size_t i = c->sel.first + static_cast<size_t>(idx);
+    return ImPlotPoint(c->series->xs_[i], c->series->ys_[i]);
+}
+
+// Two points per bucket, min and max in the order they occur.
+auto PyramidSeries::minmax_getter(int idx, void *data) -> ImPlotPoint {
+    const auto *c = static_cast<const Cursor *>(data);
+    const Bucket &b = c->series->levels_[c->sel.level - 1][c->sel.first + static_cast<size_t>(idx / 2)];
+    const size_t i = (idx & 1) ? std::max(b.imin, b.imax) : std::min(b.imin, b.imax);
+    return ImPlotPoint(c->series->xs_[i], c->series->ys_[i]);
+}
+
+auto PyramidSeries::mean_getter(int idx, void *data) -> ImPlotPoint {
+    const auto *c = static_cast<const Cursor *>(data);
+    const size_t b = c->sel.first + static_cast<size_t>(idx);
+    return ImPlotPoint(c->series->bucket_mid_x(c->sel.level, b), c->series->bucket_mean(c->sel.level, b));
+}
+
+auto PyramidSeries::low_getter(int idx, void *data) -> ImPlotPoint {
+    const auto *c = static_cast<const Cursor *>(data);
+    const size_t b = c->sel.first + static_cast<size_t>(idx);
+    const Bucket &bucket = c->series->levels_[c->sel.level - 1][b];
+    return ImPlotPoint(c->series->bucket_mid_x(c->sel.level, b), c->series->ys_[bucket.imin]);
+}
+
+auto PyramidSeries::high_getter(int idx, void *data) -> ImPlotPoint {
+    const auto *c = static_cast<const Cursor *>(data);
+    const size_t b = c->sel.first + static_cast<size_t>(idx);
+    const Bucket &bucket = c->series->levels_[c->sel.level - 1][b];
+    return ImPlotPoint(c->series->bucket_mid_x(c->sel.level, b), c->series->ys_[bucket.imax]);
+}
+
+auto PyramidSeries::plot(const char *label, PyramidStyle style, ImPlotLineFlags flags) const -> void {
+    std::shared_lock lock(this->mutex_);
+    const int width = static_cast<int>(ImPlot::GetPlotSize().x);
+    Cursor cursor{this, {}};
+    if (ImPlot::GetCurrentPlot()->FitThisFrame && !this->xs_.empty()) {
+        cursor.sel = this->select_locked(this->xs_.front(), this->xs_.back(), width);
+    } else {
+        const ImPlotRect limits = ImPlot::GetPlotLimits();
+        cursor.sel = this->select_locked(limits.X.Min, limits.X.Max, width);
+    }
+    const int count = static_cast<int>(std::min<size_t>(cursor.sel.count, INT_MAX / 2));
+
+    if (cursor.sel.level == 0) {
+        ImPlot::PlotLineG(label, &raw_getter, &cursor, count, flags);
+        return;
+    }
+    switch (style) {
+    case PyramidStyle::Mean:
+        ImPlot::PlotLineG(label, &mean_getter, &cursor, count, flags);
+        break;
+    case PyramidStyle::Band:
+        // Same label, so the band and the line are one legend item with one colour.
+        ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.25f);
+        ImPlot::PlotShadedG(label, &low_getter, &cursor, &high_getter, &cursor, count);
+        ImPlot::PlotLineG(label, &mean_getter, &cursor, count, flags);
+        break;
+    case PyramidStyle::MinMax:
+    default:
+        ImPlot::PlotLineG(label, &minmax_getter, &cursor, 2 * count, flags);
+        break;
+    }
+}
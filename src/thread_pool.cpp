@@ -0,0 +1,130 @@
+#include "thread_pool.h"
+
+namespace {
+
+thread_local unsigned t_worker_index = UINT32_MAX;
+thread_local const ThreadPool *t_worker_pool = nullptr;
+
+}  // namespace
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        const unsigned hw = std::thread::hardware_concurrency();
+        threads = hw > 1 ? hw - 1 : 1;
+    }
+    this->workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+        this->workers_.push_back(std::make_unique<Worker>());
+    this->threads_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+        this->threads_.emplace_back([this, i](std::stop_token st) { this->run(i, st); });
+}
+
+ThreadPool::~ThreadPool() {
+    for (auto &t : this->threads_)
+        t.request_stop();
+    this->sleepCv_.notify_all();
+    this->threads_.clear();  // joins
+}
+
+auto ThreadPool::shared() -> ThreadPool & {
+    static ThreadPool pool;
+    return pool;
+}
+
+// From a worker of this pool the task goes onto its own deque (LIFO, cache-warm); otherwise round-robin.
+auto ThreadPool::submit(TaskGroup &group, std::move_only_function<void()> fn) -> void {
+    group.pending_.fetch_add(1, std::memory_order_relaxed);
+    const unsigned n = this->size();
+    const unsigned target =
+        t_worker_pool == this ? t_worker_index : this->next_.fetch_add(1, std::memory_order_relaxed) % n;
+    {
+        std::scoped_lock lock(this->workers_[target]->mutex);
+        this->workers_[target]->tasks.push_back(Task{std::move(fn), &group});
+    }
+    this->queued_.fetch_add(1, std::memory_order_release);
+    {
+        // Empty critical section: a worker between its queued_ check and its wait cannot miss this notify.
+        std::scoped_lock lock(this->sleepMutex_);
+    }
+    this->sleepCv_.notify_one();
+}
+
+auto ThreadPool::try_pop(unsigned self, Task &out) -> bool {
+    const unsigned n = this->size();
+    if (self < n) {
+        Worker &own = *this->workers_[self];
+        std::scoped_lock lock(own.mutex);
+        if (!own.tasks.empty()) {
+            out = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            this->queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    const unsigned start = self < n ? self + 1 : 0;
+    for (unsigned k = 0; k < n; ++k) {
+        Worker &victim = *this->workers_[(start + k) % n];
+        std::unique_lock lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty())
+            continue;
+        out = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        this->queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+auto ThreadPool::execute(Task &task) -> void {
+    TaskGroup *group = task.group;
+    try {
+        task.fn();
+    } catch (...) {
+        std::scoped_lock lock(group->errorMutex_);
+        if (!group->error_)
+            group->error_ = std::current_exception();
+    }
+    task.fn = nullptr;
+    // Under the group mutex, which wait() takes before returning, so the group outlives the notify.
+    std::scoped_lock lock(group->errorMutex_);
+    if (group->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        group->pending_.notify_all();
+}
+
+auto ThreadPool::run(unsigned self, std::stop_token st) -> void {
+    t_worker_index = self;
+    t_worker_pool = this;
+    Task task;
+    while (!st.stop_requested()) {
+        if (this->try_pop(self, task)) {
+            this->execute(task);
+            continue;
+        }
+        std::unique_lock lock(this->sleepMutex_);
+        this->sleepCv_.wait(lock, st, [this]() { return this->queued_.load(std::memory_order_acquire) != 0; });
+    }
+}
+
+auto ThreadPool::wait(TaskGroup &group) -> void {
+    const unsigned self = t_worker_pool == this ? t_worker_index : UINT32_MAX;
+    Task task;
+    for (;;) {
+        const uint32_t pending = group.pending_.load(std::memory_order_acquire);
+        if (pending == 0)
+            break;
+        if (this->try_pop(self, task)) {
+            this->execute(task);
+            continue;
+        }
+        group.pending_.wait(pending, std::memory_order_acquire);
+    }
+
+    std::exception_ptr error;
+    {
+        std::scoped_lock lock(group.errorMutex_);
+        std::swap(error, group.error_);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
@@ -0,0 +1,209 @@
+#include "vulkan_allocator.h"
+
+#include <imgui.h>
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// In front of every returned pointer. `offset` leads back to the block start, which the alignment padding moves.
+struct Header {
+    uint64_t size;
+    uint32_t offset;
+    uint8_t cls;  // kLarge: allocated outside the pools
+    uint8_t scope;
+    uint16_t magic;
+};
+static_assert(sizeof(Header) == 16);
+
+constexpr uint8_t kLarge = 0xff;
+constexpr uint16_t kMagic = 0x7a11;
+
+auto header_of(void *memory) -> Header * { return reinterpret_cast<Header *>(static_cast<char *>(memory) - 16); }
+
+auto class_index(size_t total) -> int {
+    const size_t c = std::bit_ceil(std::max(total, VulkanHostAllocator::kMinClass));
+    return std::countr_zero(c) - std::countr_zero(VulkanHostAllocator::kMinClass);
+}
+
+auto class_size(int cls) -> size_t { return VulkanHostAllocator::kMinClass << cls; }
+
+auto scope_index(VkSystemAllocationScope scope) -> int {
+    return std::clamp(static_cast<int>(scope), 0, VulkanHostAllocStats::kScopes - 1);
+}
+
+auto raise_peak(std::atomic<uint64_t> &peak, uint64_t value) -> void {
+    uint64_t prev = peak.load(std::memory_order_relaxed);
+    while (prev < value && !peak.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+VulkanHostAllocator::VulkanHostAllocator() {
+    this->callbacks_.pUserData = this;
+    this->callbacks_.pfnAllocation = Allocate;
+    this->callbacks_.pfnReallocation = Reallocate;
+    this->callbacks_.pfnFree = Free;
+    this->callbacks_.pfnInternalAllocation = InternalAllocate;
+    this->callbacks_.pfnInternalFree = InternalFree;
+}
+
+VulkanHostAllocator::~VulkanHostAllocator() {
+    for (Arena &arena : this->arenas_)
+        for (void *slab : arena.slabs)
+            std::free(slab);
+}
+
+auto VulkanHostAllocator::stats() const -> VulkanHostAllocStats {
+    VulkanHostAllocStats out;
+    auto read = [](const Counters &c, VulkanHostScopeStats &s) {
+        s.live_bytes = c.liveBytes.load(std::memory_order_relaxed);
+        s.live_count = c.liveCount.load(std::memory_order_relaxed);
+        s.peak_bytes = c.peakBytes.load(std::memory_order_relaxed);
+        s.total_count = c.totalCount.load(std::memory_order_relaxed);
+        s.internal_bytes = c.internalBytes.load(std::memory_order_relaxed);
+    };
+    for (int i = 0; i < VulkanHostAllocStats::kScopes; i++)
+        read(this->scopes_[i], out.scopes[i]);
+    VulkanHostScopeStats total;
+    read(this->total_, total);
+    out.live_bytes = total.live_bytes;
+    out.live_count = total.live_count;
+    out.peak_bytes = total.peak_bytes;
+    out.total_count = total.total_count;
+    out.large_count = this->largeCount_.load(std::memory_order_relaxed);
+    out.pooled_bytes = this->pooledBytes_.load(std::memory_order_relaxed);
+    return out;
+}
+
+auto VulkanHostAllocator::count_alloc(int scope, size_t size) -> void {
+    for (Counters *c : {&this->scopes_[scope], &this->total_}) {
+        const uint64_t live = c->liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        c->liveCount.fetch_add(1, std::memory_order_relaxed);
+        c->totalCount.fetch_add(1, std::memory_order_relaxed);
+        raise_peak(c->peakBytes, live);
+    }
+}
+
+auto VulkanHostAllocator::count_free(int scope, size_t size) -> void {
+    for (Counters *c : {&this->scopes_[scope], &this->total_}) {
+        c->liveBytes.fetch_sub(size, std::memory_order_relaxed);
+        c->liveCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// Caller holds arena.mutex.
+auto VulkanHostAllocator::pop(Arena &arena, int cls) -> void * {
+    if (FreeBlock *block = arena.free[cls]) {
+        arena.free[cls] = block->next;
+        return block;
+    }
+    const size_t size = class_size(cls);
+    if (arena.bump[cls] == arena.bumpEnd[cls]) {
+        void *slab = std::aligned_alloc(kMaxClass, kSlabSize);
+        if (!slab)
+            return nullptr;
+        arena.slabs.push_back(slab);
+        arena.bump[cls] = static_cast<char *>(slab);
+        arena.bumpEnd[cls] = arena.bump[cls] + kSlabSize;
+        this->pooledBytes_.fetch_add(kSlabSize, std::memory_order_relaxed);
+    }
+    void *block = arena.bump[cls];
+    arena.bump[cls] += size;
+    return block;
+}
+
+auto VulkanHostAllocator::allocate(size_t size, size_t alignment, int scope) -> void * {
+    if (size == 0)
+        return nullptr;
+    const size_t pad = std::max<size_t>(alignment, sizeof(Header));
+    const size_t total = size + pad;
+    uint8_t cls = kLarge;
+    void *block;
+    if (total <= kMaxClass) {
+        cls = static_cast<uint8_t>(class_index(total));
+        Arena &arena = this->arenas_[scope];
+        std::scoped_lock lock(arena.mutex);
+        block = this->pop(arena, cls);
+    } else {
+        block = std::aligned_alloc(pad, (total + pad - 1) / pad * pad);
+        if (block)
+            this->largeCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!block)
+        return nullptr;  // the driver turns this into VK_ERROR_OUT_OF_HOST_MEMORY
+
+    void *memory = static_cast<char *>(block) + pad;
+    *header_of(memory) = Header{size, static_cast<uint32_t>(pad), cls, static_cast<uint8_t>(scope), kMagic};
+    this->count_alloc(scope, size);
+    return memory;
+}
+
+auto VulkanHostAllocator::release(void *memory) -> void {
+    const Header header = *header_of(memory);
+    IM_ASSERT(header.magic == kMagic && "VkAllocationCallbacks: pointer not allocated here");
+    void *block = static_cast<char *>(memory) - header.offset;
+    this->count_free(header.scope, header.size);
+    if (header.cls == kLarge) {
+        std::free(block);
+        this->largeCount_.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+    Arena &arena = this->arenas_[header.scope];
+    std::scoped_lock lock(arena.mutex);
+    auto *free_block = static_cast<FreeBlock *>(block);
+    free_block->next = arena.free[header.cls];
+    arena.free[header.cls] = free_block;
+}
+
+VKAPI_ATTR void *VKAPI_CALL VulkanHostAllocator::Allocate(void *user, size_t size, size_t alignment,
+                                                          VkSystemAllocationScope scope) {
+    return static_cast<VulkanHostAllocator *>(user)->allocate(size, alignment, scope_index(scope));
+}
+
+// Grows in place while the block's size class still fits; the alignment is the original one (Vulkan requires it).
+VKAPI_ATTR void *VKAPI_CALL VulkanHostAllocator::Reallocate(void *user, void *original, size_t size,
+                                                            size_t alignment, VkSystemAllocationScope scope) {
+    auto *self = static_cast<VulkanHostAllocator *>(user);
+    if (!original)
+        return self->allocate(size, alignment, scope_index(scope));
+    if (size == 0) {
+        self->release(original);
+        return nullptr;
+    }
+    Header *header = header_of(original);
+    if (header->cls != kLarge && size + header->offset <= class_size(header->cls)) {
+        self->count_free(header->scope, header->size);
+        self->count_alloc(header->scope, size);
+        header->size = size;
+        return original;
+    }
+    void *memory = self->allocate(size, alignment, scope_index(scope));
+    if (!memory)
+        return nullptr;  // the original stays valid, as the spec requires
+    std::memcpy(memory, original, std::min<size_t>(size, header->size));
+    self->release(original);
+    return memory;
+}
+
+VKAPI_ATTR void VKAPI_CALL VulkanHostAllocator::Free(void *user, void *memory) {
+    if (memory)
+        static_cast<VulkanHostAllocator *>(user)->release(memory);
+}
+
+VKAPI_ATTR void VKAPI_CALL VulkanHostAllocator::InternalAllocate(void *user, size_t size, VkInternalAllocationType,
+                                                                 VkSystemAllocationScope scope) {
+    auto *self = static_cast<VulkanHostAllocator *>(user);
+    self->scopes_[scope_index(scope)].internalBytes.fetch_add(size, std::memory_order_relaxed);
+    self->total_.internalBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+VKAPI_ATTR void VKAPI_CALL VulkanHostAllocator::InternalFree(void *user, size_t size, VkInternalAllocationType,
+                                                             VkSystemAllocationScope scope) {
+    auto *self = static_cast<VulkanHostAllocator *>(user);
+    self->scopes_[scope_index(scope)].internalBytes.fetch_sub(size, std::memory_order_relaxed);
+    self->total_.internalBytes.fetch_sub(size, std::memory_order_relaxed);
+}
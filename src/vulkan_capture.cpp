@@ -0,0 +1,396 @@
+#include "vulkan_capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+auto ms_since(Clock::time_point start) -> double {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// 1 for B8G8R8A8, 0 for R8G8B8A8, -1 for anything else.
+auto channel_order(VkFormat format) -> int {
+    switch (format) {
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        return 1;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+// BT.601, limited range, 8-bit fixed point.
+auto luma(int r, int g, int b) -> uint8_t {
+    return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+auto chroma_u(int r, int g, int b) -> uint8_t {
+    return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+auto chroma_v(int r, int g, int b) -> uint8_t {
+    return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+}  // namespace
+
+VulkanFrameCapture::VulkanFrameCapture(VulkanHelper *vk, const std::string &path, FrameCaptureOptions options)
+    : vk_(vk), options_(options), file_(path, std::ios::binary | std::ios::trunc),
+      slotCount_(std::max(options.ring_size, 2u)) {
+    if (!this->file_) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    this->options_.fps = std::max(options.fps, 1u);
+    this->slots_ = std::make_unique<Slot[]>(this->slotCount_);
+    this->writer_ = std::jthread([this](std::stop_token st) { this->write_loop(st); });
+}
+
+VulkanFrameCapture::~VulkanFrameCapture() { this->close(); }
+
+auto VulkanFrameCapture::close() -> void {
+    if (this->closed_)
+        return;
+    this->closed_ = true;
+
+    // A copy recorded into a command buffer that never got submitted is abandoned with it.
+    if (this->recorded_ >= 0) {
+        this->slots_[this->recorded_].state.store(SlotState::Free, std::memory_order_relaxed);
+        this->recorded_ = -1;
+    }
+    // Copies still on the GPU are waited for and written, so the file ends with the last captured frame.
+    this->collect(true);
+    this->writer_.request_stop();
+    this->writer_.join();
+    this->file_.close();
+
+    const VkDevice device = this->vk_->data.device;
+    const VkAllocationCallbacks *allocator = this->vk_->data.allocator;
+    for (uint32_t i = 0; i < this->slotCount_; i++) {
+        Slot &slot = this->slots_[i];
+        if (slot.mapped)
+            vkUnmapMemory(device, slot.memory);
+        vkDestroyBuffer(device, slot.buffer, allocator);
+        vkFreeMemory(device, slot.memory, allocator);
+        vkDestroyFence(device, slot.fence, allocator);
+        slot.mapped = nullptr;
+        slot.buffer = VK_NULL_HANDLE;
+        slot.memory = VK_NULL_HANDLE;
+        slot.fence = VK_NULL_HANDLE;
+    }
+}
+
+auto VulkanFrameCapture::stats() const -> FrameCaptureStats {
+    std::scoped_lock lock(this->mutex_);
+    return this->stats_;
+}
+
+// Host-cached memory first: the writer reads every byte, and reads from uncached (write-combined) memory are an
+// order of magnitude slower.
+auto VulkanFrameCapture::create_slots() -> void {
+    const VkDevice device = this->vk_->data.device;
+    const VkAllocationCallbacks *allocator = this->vk_->data.allocator;
+    VkResult err;
+
+    for (uint32_t i = 0; i < this->slotCount_; i++) {
+        Slot &slot = this->slots_[i];
+
+        VkBufferCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.size = this->frameBytes_;
+        info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        err = vkCreateBuffer(device, &info, allocator, &slot.buffer);
+        VulkanHelper::check_vk_result(err);
+
+        VkMemoryRequirements req;
+        vkGetBufferMemoryRequirements(device, slot.buffer, &req);
+        const VkMemoryPropertyFlags candidates[] = {
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+                VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+        };
+        VkMemoryAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = req.size;
+        alloc_info.memoryTypeIndex = UINT32_MAX;
+        for (VkMemoryPropertyFlags flags : candidates) {
+            alloc_info.memoryTypeIndex = this->vk_->FindMemoryType(req.memoryTypeBits, flags);
+            if (alloc_info.memoryTypeIndex != UINT32_MAX) {
+                this->coherent_ = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+                break;
+            }
+        }
+        if (alloc_info.memoryTypeIndex == UINT32_MAX)
+            throw std::runtime_error("Vulkan: no host-visible memory type for frame capture");
+        err = vkAllocateMemory(device, &alloc_info, allocator, &slot.memory);
+        VulkanHelper::check_vk_result(err);
+        err = vkBindBufferMemory(device, slot.buffer, slot.memory, 0);
+        VulkanHelper::check_vk_result(err);
+        void *mapped = nullptr;
+        err = vkMapMemory(device, slot.memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+        VulkanHelper::check_vk_result(err);
+        slot.mapped = static_cast<const uint8_t *>(mapped);
+
+        VkFenceCreateInfo fence_info = {};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        err = vkCreateFence(device, &fence_info, allocator, &slot.fence);
+        VulkanHelper::check_vk_result(err);
+    }
+}
+
+auto VulkanFrameCapture::note_record_time(double ms) -> void {
+    std::scoped_lock lock(this->mutex_);
+    this->stats_.record_ms += ms;
+    this->stats_.record_ms_max = std::max(this->stats_.record_ms_max, ms);
+}
+
+auto VulkanFrameCapture::record(VkCommandBuffer cmd, VkImage image, VkImageLayout layout, VkFormat format,
+                                uint32_t width, uint32_t height) -> bool {
+    const auto start = Clock::now();
+    this->collect(false);
+    if (this->failed_.load(std::memory_order_relaxed)) {
+        this->note_record_time(ms_since(start));
+        return false;
+    }
+
+    const int order = channel_order(format);
+    if (this->width_ == 0 && order >= 0 && width > 0 && height > 0) {
+        this->width_ = width;
+        this->height_ = height;
+        this->bgra_ = order == 1;
+        this->frameBytes_ = static_cast<VkDeviceSize>(width) * height * 4;
+        this->create_slots();
+        std::scoped_lock lock(this->mutex_);
+        this->stats_.width = width;
+        this->stats_.height = height;
+    }
+    if (width != this->width_ || height != this->height_ || order != (this->bgra_ ? 1 : 0)) {
+        {
+            std::scoped_lock lock(this->mutex_);
+            ++this->stats_.frames_skipped;
+        }
+        this->note_record_time(ms_since(start));
+        return false;
+    }
+
+    Slot &slot = this->slots_[this->next_];
+    if (slot.state.load(std::memory_order_acquire) != SlotState::Free) {
+        {
+            std::scoped_lock lock(this->mutex_);
+            ++this->stats_.frames_dropped;
+        }
+        this->note_record_time(ms_since(start));
+        return false;
+    }
+
+    // The render pass leaves no dependency for a transfer: wait for its colour writes, copy, and put the image back
+    // into the layout the caller expects (PRESENT_SRC for a swapchain image).
+    VkImageMemoryBarrier to_transfer = {};
+    to_transfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    to_transfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    to_transfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    to_transfer.oldLayout = layout;
+    to_transfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.image = image;
+    to_transfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    to_transfer.subresourceRange.levelCount = 1;
+    to_transfer.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                         nullptr, 0, nullptr, 1, &to_transfer);
+
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {width, height, 1};
+    vkCmdCopyImageToBuffer(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+    VkBufferMemoryBarrier to_host = {};
+    to_host.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    to_host.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    to_host.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    to_host.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_host.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_host.buffer = slot.buffer;
+    to_host.size = VK_WHOLE_SIZE;
+    if (layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+        VkImageMemoryBarrier back = to_transfer;
+        back.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        back.dstAccessMask = 0;
+        back.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        back.newLayout = layout;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1,
+                             &to_host, 1, &back);
+    } else {
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1,
+                             &to_host, 0, nullptr);
+    }
+
+    slot.state.store(SlotState::Recorded, std::memory_order_relaxed);
+    this->recorded_ = static_cast<int>(this->next_);
+    this->next_ = (this->next_ + 1) % this->slotCount_;
+    {
+        std::scoped_lock lock(this->mutex_);
+        ++this->stats_.frames_captured;
+    }
+    this->note_record_time(ms_since(start));
+    return true;
+}
+
+// An empty submit signals its fence once everything submitted before it on the queue, the frame included, is done.
+auto VulkanFrameCapture::submitted(VkQueue queue) -> void {
+    if (this->recorded_ < 0)
+        return;
+    const auto start = Clock::now();
+    Slot &slot = this->slots_[this->recorded_];
+    this->recorded_ = -1;
+    VkResult err = vkQueueSubmit(queue, 0, nullptr, slot.fence);
+    VulkanHelper::check_vk_result(err);
+    slot.state.store(SlotState::InFlight, std::memory_order_relaxed);
+    this->note_record_time(ms_since(start));
+}
+
+// Hands finished copies to the writer in submission order. Never blocks unless `wait`.
+auto VulkanFrameCapture::collect(bool wait) -> void {
+    if (!this->slots_ || this->width_ == 0)
+        return;
+    const VkDevice device = this->vk_->data.device;
+    for (;;) {
+        Slot &slot = this->slots_[this->collect_];
+        if (slot.state.load(std::memory_order_relaxed) != SlotState::InFlight)
+            return;
+        VkResult err = wait ? vkWaitForFences(device, 1, &slot.fence, VK_TRUE, UINT64_MAX)
+                            : vkGetFenceStatus(device, slot.fence);
+        if (err == VK_NOT_READY)
+            return;
+        VulkanHelper::check_vk_result(err);
+        err = vkResetFences(device, 1, &slot.fence);
+        VulkanHelper::check_vk_result(err);
+
+        slot.state.store(SlotState::Queued, std::memory_order_release);
+        {
+            std::scoped_lock lock(this->mutex_);
+            this->queue_.push_back(this->collect_);
+        }
+        this->queued_.notify_one();
+        this->collect_ = (this->collect_ + 1) % this->slotCount_;
+    }
+}
+
+// Drains the queue before honouring a stop request.
+auto VulkanFrameCapture::write_loop(std::stop_token st) -> void {
+    for (;;) {
+        uint32_t index;
+        {
+            std::unique_lock lock(this->mutex_);
+            this->queued_.wait(lock, st, [this] { return !this->queue_.empty(); });
+            if (this->queue_.empty())
+                return;
+            index = this->queue_.front();
+            this->queue_.pop_front();
+        }
+        Slot &slot = this->slots_[index];
+        if (!this->failed_.load(std::memory_order_relaxed))
+            this->write_frame(slot);
+        slot.state.store(SlotState::Free, std::memory_order_release);
+    }
+}
+
+auto VulkanFrameCapture::write_frame(const Slot &slot) -> void {
+    const auto start = Clock::now();
+    if (!this->coherent_) {
+        VkMappedMemoryRange range = {};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = slot.memory;
+        range.size = VK_WHOLE_SIZE;
+        VkResult err = vkInvalidateMappedMemoryRanges(this->vk_->data.device, 1, &range);
+        VulkanHelper::check_vk_result(err);
+    }
+
+    const uint32_t w = this->width_;
+    const uint32_t h = this->height_;
+    const size_t pixels = static_cast<size_t>(w) * h;
+    const uint8_t *src = slot.mapped;
+    const int ri = this->bgra_ ? 2 : 0;
+    const int bi = this->bgra_ ? 0 : 2;
+    uint64_t bytes = 0;
+
+    if (this->options_.format == FrameCaptureFormat::Y4M) {
+        if (!this->headerWritten_) {
+            char header[96];
+            const int n = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", w, h,
+                                        this->options_.fps);
+            this->file_.write(header, n);
+            bytes += static_cast<uint64_t>(n);
+            this->headerWritten_ = true;
+        }
+        const uint32_t cw = (w + 1) / 2;
+        const uint32_t ch = (h + 1) / 2;
+        this->scratch_.resize(pixels + 2 * static_cast<size_t>(cw) * ch);
+        uint8_t *y_plane = this->scratch_.data();
+        uint8_t *u_plane = y_plane + pixels;
+        uint8_t *v_plane = u_plane + static_cast<size_t>(cw) * ch;
+        for (size_t i = 0; i < pixels; i++) {
+            const uint8_t *p = src + i * 4;
+            y_plane[i] = luma(p[ri], p[1], p[bi]);
+        }
+        // Chroma of each 2x2 block from its average colour (centred siting, as C420jpeg says).
+        for (uint32_t cy = 0; cy < ch; cy++) {
+            const uint32_t y0 = cy * 2;
+            const uint32_t y1 = std::min(y0 + 1, h - 1);
+            for (uint32_t cx = 0; cx < cw; cx++) {
+                const uint32_t x0 = cx * 2;
+                const uint32_t x1 = std::min(x0 + 1, w - 1);
+                const uint8_t *q[4] = {src + (static_cast<size_t>(y0) * w + x0) * 4,
+                                       src + (static_cast<size_t>(y0) * w + x1) * 4,
+                                       src + (static_cast<size_t>(y1) * w + x0) * 4,
+                                       src + (static_cast<size_t>(y1) * w + x1) * 4};
+                const int r = (q[0][ri] + q[1][ri] + q[2][ri] + q[3][ri] + 2) >> 2;
+                const int g = (q[0][1] + q[1][1] + q[2][1] + q[3][1] + 2) >> 2;
+                const int b = (q[0][bi] + q[1][bi] + q[2][bi] + q[3][bi] + 2) >> 2;
+                u_plane[static_cast<size_t>(cy) * cw + cx] = chroma_u(r, g, b);
+                v_plane[static_cast<size_t>(cy) * cw + cx] = chroma_v(r, g, b);
+            }
+        }
+        this->file_.write("FRAME\n", 6);
+        this->file_.write(reinterpret_cast<const char *>(this->scratch_.data()),
+                          static_cast<std::streamsize>(this->scratch_.size()));
+        bytes += 6 + this->scratch_.size();
+    } else {
+        const uint8_t *out = src;
+        if (this->bgra_) {
+            this->scratch_.resize(pixels * 4);
+            for (size_t i = 0; i < pixels; i++) {
+                this->scratch_[i * 4 + 0] = src[i * 4 + 2];
+                this->scratch_[i * 4 + 1] = src[i * 4 + 1];
+                this->scratch_[i * 4 + 2] = src[i * 4 + 0];
+                this->scratch_[i * 4 + 3] = src[i * 4 + 3];
+            }
+            out = this->scratch_.data();
+        }
+        this->file_.write(reinterpret_cast<const char *>(out), static_cast<std::streamsize>(pixels * 4));
+        bytes += pixels * 4;
+    }
+
+    std::scoped_lock lock(this->mutex_);
+    if (!this->file_) {
+        this->failed_.store(true, std::memory_order_relaxed);
+        this->stats_.failed = true;
+        fprintf(stderr, "[capture] Write failed, capture stopped after %llu frame(s)\n",
+                (unsigned long long)this->stats_.frames_written);
+        return;
+    }
+    ++this->stats_.frames_written;
+    this->stats_.bytes_written += bytes;
+    this->stats_.encode_ms += ms_since(start);
+}
@@ -0,0 +1,102 @@
+#include "vulkan_frame_ring.h"
+
+#include <algorithm>
+
+auto VulkanFrameRing::Create(VulkanHelper *vk, uint32_t frames, uint32_t images) -> void {
+    this->vk_ = vk;
+    const VkDevice device = vk->data.device;
+    const VkAllocationCallbacks *allocator = vk->data.allocator;
+    VkResult err;
+
+    VkSemaphoreCreateInfo semaphore_info = {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    this->slots_.resize(std::clamp(frames, 1u, kMaxFrames));
+    for (VulkanFrameSlot &slot : this->slots_) {
+        VkCommandPoolCreateInfo pool_info = {};
+        pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.queueFamilyIndex = vk->data.queueFamily;
+        err = vkCreateCommandPool(device, &pool_info, allocator, &slot.commandPool);
+        VulkanHelper::check_vk_result(err);
+
+        VkCommandBufferAllocateInfo cmd_info = {};
+        cmd_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        cmd_info.commandPool = slot.commandPool;
+        cmd_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        cmd_info.commandBufferCount = 1;
+        err = vkAllocateCommandBuffers(device, &cmd_info, &slot.commandBuffer);
+        VulkanHelper::check_vk_result(err);
+
+        // Signaled, so the first pass around the ring does not block
+        VkFenceCreateInfo fence_info = {};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        err = vkCreateFence(device, &fence_info, allocator, &slot.fence);
+        VulkanHelper::check_vk_result(err);
+
+        if (images > 0) {
+            err = vkCreateSemaphore(device, &semaphore_info, allocator, &slot.imageAcquired);
+            VulkanHelper::check_vk_result(err);
+        }
+    }
+
+    this->renderComplete_.resize(images);
+    for (VkSemaphore &semaphore : this->renderComplete_) {
+        err = vkCreateSemaphore(device, &semaphore_info, allocator, &semaphore);
+        VulkanHelper::check_vk_result(err);
+    }
+    this->imageFences_.assign(images, VK_NULL_HANDLE);
+    // Next() starts at slot 0
+    this->index_ = this->FrameCount() - 1;
+}
+
+auto VulkanFrameRing::Destroy() -> void {
+    if (!this->vk_)
+        return;
+    const VkDevice device = this->vk_->data.device;
+    const VkAllocationCallbacks *allocator = this->vk_->data.allocator;
+
+    for (VulkanFrameSlot &slot : this->slots_) {
+        vkDestroySemaphore(device, slot.imageAcquired, allocator);
+        vkDestroyFence(device, slot.fence, allocator);
+        vkDestroyCommandPool(device, slot.commandPool, allocator);
+    }
+    for (VkSemaphore semaphore : this->renderComplete_)
+        vkDestroySemaphore(device, semaphore, allocator);
+
+    *this = VulkanFrameRing{};
+}
+
+auto VulkanFrameRing::Next() -> VulkanFrameSlot & {
+    this->index_ = (this->index_ + 1) % this->FrameCount();
+    VulkanFrameSlot &slot = this->slots_[this->index_];
+    VkResult err = vkWaitForFences(this->vk_->data.device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+    VulkanHelper::check_vk_result(err);
+    return slot;
+}
+
+auto VulkanFrameRing::WaitIdle() -> void {
+    VkFence fences[kMaxFrames];
+    for (uint32_t i = 0; i < this->FrameCount(); ++i)
+        fences[i] = this->slots_[i].fence;
+    VkResult err = vkWaitForFences(this->vk_->data.device, this->FrameCount(), fences, VK_TRUE, UINT64_MAX);
+    VulkanHelper::check_vk_result(err);
+}
+
+auto VulkanFrameRing::Pending() const -> uint32_t {
+    uint32_t pending = 0;
+    for (const VulkanFrameSlot &slot : this->slots_)
+        if (vkGetFenceStatus(this->vk_->data.device, slot.fence) == VK_NOT_READY)
+            ++pending;
+    return pending;
+}
+
+auto VulkanFrameRing::ClaimImage(uint32_t image) -> void {
+    VkFence &owner = this->imageFences_[image];
+    const VkFence fence = this->slots_[this->index_].fence;
+    if (owner != VK_NULL_HANDLE && owner != fence) {
+        VkResult err = vkWaitForFences(this->vk_->data.device, 1, &owner, VK_TRUE, UINT64_MAX);
+        VulkanHelper::check_vk_result(err);
+    }
+    owner = fence;
+}
@@ -4,12 +4,24 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
 #include <implot.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>  // getpid
 #include <stdio.h>  // printf, fprintf
 #include <stdlib.h> // abort
 #define GLFW_INCLUDE_NONE
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#include "scope_helper.h"
+
 // Volk headers
 #ifdef IMGUI_IMPL_VULKAN_USE_VOLK
 #define VOLK_IMPLEMENTATION
@@ -37,6 +49,56 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debug_report(VkDebugReportFlagsEXT flags,
 }
 #endif // APP_USE_VULKAN_DEBUG_REPORT
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+auto ms_since(Clock::time_point start) -> double {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Our own header in front of the driver's blob. The driver checks its VkPipelineCacheHeaderVersionOne too, but some
+// drivers misbehave on foreign or truncated data, so nothing reaches vkCreatePipelineCache unless this matches.
+struct PipelineCacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint32_t reserved;
+    uint64_t dataSize;
+    uint64_t dataHash;
+};
+
+constexpr uint32_t kPipelineCacheMagic = 0x43505549;  // "IUPC"
+constexpr uint32_t kPipelineCacheVersion = 1;
+
+auto fnv1a(const uint8_t *data, size_t size) -> uint64_t {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++)
+        h = (h ^ data[i]) * 0x100000001b3ull;
+    return h;
+}
+
+auto fill_header(VkPhysicalDevice physical_device, PipelineCacheFileHeader &header) -> void {
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(physical_device, &props);
+    header = PipelineCacheFileHeader{};
+    header.magic = kPipelineCacheMagic;
+    header.version = kPipelineCacheVersion;
+    header.vendorID = props.vendorID;
+    header.deviceID = props.deviceID;
+    header.driverVersion = props.driverVersion;
+    std::memcpy(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+std::mutex g_pipelineCachePathMutex;
+std::optional<std::string> g_pipelineCachePath;
+std::atomic<bool> g_hostAllocatorEnabled{true};
+
+}  // namespace
+
 auto VulkanHelper::check_vk_result(VkResult err) -> void {
     if (err == VK_SUCCESS)
         return;
@@ -53,8 +115,43 @@ auto VulkanHelper::IsExtensionAvailable(const ImVector<VkExtensionProperties> &p
     return false;
 }
 
-auto VulkanHelper::Setup(ImVector<const char *> instance_extensions) -> void {
+auto VulkanHelper::Acquire(const ImVector<const char *> &instance_extensions, bool headless)
+    -> std::shared_ptr<VulkanHelper> {
+    static std::mutex mutex;
+    static std::weak_ptr<VulkanHelper> shared;
+
+    std::scoped_lock lock(mutex);
+    if (auto vk = shared.lock()) {
+        if (vk->headless_ && !headless)
+            throw std::runtime_error("VulkanHelper: the shared device was created headless, it cannot present");
+        for (const char *ext : instance_extensions)
+            if (std::find(vk->instanceExtensions_.begin(), vk->instanceExtensions_.end(), ext) ==
+                vk->instanceExtensions_.end())
+                throw std::runtime_error(std::string("VulkanHelper: shared instance lacks extension ") + ext);
+        return vk;
+    }
+
+    // Setup() undoes its own partial work when it throws, so Cleanup() is attached only once it succeeded.
+    auto helper = std::make_unique<VulkanHelper>();
+    helper->Setup(instance_extensions, headless);
+    auto vk = std::shared_ptr<VulkanHelper>(helper.release(), [](VulkanHelper *p) {
+        p->Cleanup();
+        delete p;
+    });
+    shared = vk;
+    return vk;
+}
+
+auto VulkanHelper::Setup(ImVector<const char *> instance_extensions, bool headless) -> void {
     VkResult err;
+    this->headless_ = headless;
+    ScopeFail undo([this]() { this->Cleanup(); });
+    this->startup = VulkanStartupStats{};
+    auto phase_start = Clock::now();
+    if (g_hostAllocatorEnabled.load(std::memory_order_relaxed)) {
+        this->hostAllocator_ = std::make_unique<VulkanHostAllocator>();
+        this->data.allocator = this->hostAllocator_->callbacks();
+    }
 #ifdef IMGUI_IMPL_VULKAN_USE_VOLK
     volkInitialize();
 #endif
@@ -95,6 +192,7 @@ auto VulkanHelper::Setup(ImVector<const char *> instance_extensions) -> void {
         create_info.ppEnabledExtensionNames = instance_extensions.Data;
         err = vkCreateInstance(&create_info, this->data.allocator, &this->data.instance);
         check_vk_result(err);
+        this->instanceExtensions_.assign(instance_extensions.begin(), instance_extensions.end());
 #ifdef IMGUI_IMPL_VULKAN_USE_VOLK
         volkLoadInstance(g_Instance);
 #endif
@@ -115,6 +213,9 @@ auto VulkanHelper::Setup(ImVector<const char *> instance_extensions) -> void {
 #endif
     }
 
+    this->startup.instance_ms = ms_since(phase_start);
+    phase_start = Clock::now();
+
     // Select Physical Device (GPU)
     this->data.physicalDevice = ImGui_ImplVulkanH_SelectPhysicalDevice(this->data.instance);
     IM_ASSERT(this->data.physicalDevice != VK_NULL_HANDLE);
@@ -123,10 +224,11 @@ auto VulkanHelper::Setup(ImVector<const char *> instance_extensions) -> void {
     this->data.queueFamily = ImGui_ImplVulkanH_SelectQueueFamilyIndex(this->data.physicalDevice);
     IM_ASSERT(this->data.queueFamily != (uint32_t)-1);
 
-    // Create Logical Device (with 1 queue)
+    // Create Logical Device (with up to kMaxQueues queues, so engines can submit without contending)
     {
         ImVector<const char *> device_extensions;
-        device_extensions.push_back("VK_KHR_swapchain");
+        if (!headless)
+            device_extensions.push_back("VK_KHR_swapchain");
 
         // Enumerate physical device extension
         uint32_t properties_count;
@@ -139,45 +241,220 @@ auto VulkanHelper::Setup(ImVector<const char *> instance_extensions) -> void {
             device_extensions.push_back(VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME);
 #endif
 
-        const float queue_priority[] = {1.0f};
+        uint32_t family_count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(this->data.physicalDevice, &family_count, nullptr);
+        ImVector<VkQueueFamilyProperties> families;
+        families.resize(family_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(this->data.physicalDevice, &family_count, families.Data);
+        const uint32_t queue_count = std::clamp(families[this->data.queueFamily].queueCount, 1u, kMaxQueues);
+
+        const float queue_priority[kMaxQueues] = {1.0f, 1.0f, 1.0f, 1.0f};
         VkDeviceQueueCreateInfo queue_info[1] = {};
         queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queue_info[0].queueFamilyIndex = this->data.queueFamily;
-        queue_info[0].queueCount = 1;
+        queue_info[0].queueCount = queue_count;
         queue_info[0].pQueuePriorities = queue_priority;
+        // Point sizes above 1 (GpuSeries markers) need largePoints; without it they are drawn 1 px wide.
+        VkPhysicalDeviceFeatures supported = {};
+        vkGetPhysicalDeviceFeatures(this->data.physicalDevice, &supported);
+        this->features = {};
+        this->features.largePoints = supported.largePoints;
+
         VkDeviceCreateInfo create_info = {};
         create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         create_info.queueCreateInfoCount = sizeof(queue_info) / sizeof(queue_info[0]);
         create_info.pQueueCreateInfos = queue_info;
         create_info.enabledExtensionCount = (uint32_t)device_extensions.Size;
         create_info.ppEnabledExtensionNames = device_extensions.Data;
+        create_info.pEnabledFeatures = &this->features;
         err = vkCreateDevice(this->data.physicalDevice, &create_info, this->data.allocator, &this->data.device);
         check_vk_result(err);
-        vkGetDeviceQueue(this->data.device, this->data.queueFamily, 0, &this->data.queue);
+        this->queues_.resize(queue_count);
+        for (uint32_t i = 0; i < queue_count; i++)
+            vkGetDeviceQueue(this->data.device, this->data.queueFamily, i, &this->queues_[i]);
+        this->queueMutexes_ = std::make_unique<std::mutex[]>(queue_count);
+        this->data.queue = this->queues_[0];
     }
+    this->startup.device_ms = ms_since(phase_start);
 
-    // Create Descriptor Pool
-    // If you wish to load e.g. additional textures you may need to alter pools sizes and maxSets.
+    this->LoadPipelineCache();
+}
+
+auto VulkanHelper::SetPipelineCachePath(std::string path) -> void {
+    std::scoped_lock lock(g_pipelineCachePathMutex);
+    g_pipelineCachePath = std::move(path);
+}
+
+auto VulkanHelper::PipelineCachePath() -> std::string {
     {
-        VkDescriptorPoolSize pool_sizes[] = {
-            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, IMGUI_IMPL_VULKAN_MINIMUM_IMAGE_SAMPLER_POOL_SIZE},
-        };
-        VkDescriptorPoolCreateInfo pool_info = {};
-        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-        pool_info.maxSets = 0;
-        for (VkDescriptorPoolSize &pool_size : pool_sizes)
-            pool_info.maxSets += pool_size.descriptorCount;
-        pool_info.poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes);
-        pool_info.pPoolSizes = pool_sizes;
-        err = vkCreateDescriptorPool(this->data.device, &pool_info, this->data.allocator, &this->data.descriptorPool);
-        check_vk_result(err);
+        std::scoped_lock lock(g_pipelineCachePathMutex);
+        if (g_pipelineCachePath)
+            return *g_pipelineCachePath;
     }
+    if (const char *env = std::getenv("IMPLOT_UTIL_PIPELINE_CACHE"))
+        return env;
+    std::filesystem::path dir;
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        dir = xdg;
+    else if (const char *home = std::getenv("HOME"); home && *home)
+        dir = std::filesystem::path(home) / ".cache";
+    else
+        return {};
+    return (dir / "implot_util" / "pipeline_cache.bin").string();
 }
 
-auto VulkanHelper::Cleanup() -> void {
-    vkDestroyDescriptorPool(this->data.device, this->data.descriptorPool, this->data.allocator);
+auto VulkanHelper::SetHostAllocatorEnabled(bool enabled) -> void {
+    g_hostAllocatorEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+auto VulkanHelper::HostAllocStats() const -> VulkanHostAllocStats {
+    return this->hostAllocator_ ? this->hostAllocator_->stats() : VulkanHostAllocStats{};
+}
+
+// Always creates data.pipelineCache; a missing, stale or corrupt file only means starting from an empty cache.
+auto VulkanHelper::LoadPipelineCache() -> void {
+    const auto start = Clock::now();
+    this->pipelineCachePath_ = PipelineCachePath();
+    this->pipelineCacheHash_ = 0;
+
+    std::vector<uint8_t> blob;
+    if (!this->pipelineCachePath_.empty()) {
+        std::ifstream file(this->pipelineCachePath_, std::ios::binary);
+        PipelineCacheFileHeader header, expected;
+        fill_header(this->data.physicalDevice, expected);
+        if (file && file.read(reinterpret_cast<char *>(&header), sizeof(header)) && header.magic == expected.magic &&
+            header.version == expected.version && header.vendorID == expected.vendorID &&
+            header.deviceID == expected.deviceID && header.driverVersion == expected.driverVersion &&
+            std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+            header.dataSize <= (256u << 20)) {
+            blob.resize(header.dataSize);
+            if (!file.read(reinterpret_cast<char *>(blob.data()), (std::streamsize)blob.size()) ||
+                fnv1a(blob.data(), blob.size()) != header.dataHash)
+                blob.clear();
+            else
+                this->pipelineCacheHash_ = header.dataHash;
+        }
+    }
 
+    VkPipelineCacheCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = blob.size();
+    info.pInitialData = blob.empty() ? nullptr : blob.data();
+    VkResult err = vkCreatePipelineCache(this->data.device, &info, this->data.allocator, &this->data.pipelineCache);
+    if (err != VK_SUCCESS && !blob.empty()) {
+        blob.clear();
+        this->pipelineCacheHash_ = 0;
+        info.initialDataSize = 0;
+        info.pInitialData = nullptr;
+        err = vkCreatePipelineCache(this->data.device, &info, this->data.allocator, &this->data.pipelineCache);
+    }
+    check_vk_result(err);
+
+    this->startup.pipeline_cache_bytes = blob.size();
+    this->startup.pipeline_cache_hit = !blob.empty();
+    this->startup.pipeline_cache_load_ms = ms_since(start);
+}
+
+// Written to a temporary file and renamed into place, so viewers starting while another one exits never read a
+// half-written cache. Failures are reported and otherwise ignored: the cache is only an optimization.
+auto VulkanHelper::SavePipelineCache() -> void {
+    if (this->data.pipelineCache == VK_NULL_HANDLE || this->pipelineCachePath_.empty())
+        return;
+    size_t size = 0;
+    VkResult err = vkGetPipelineCacheData(this->data.device, this->data.pipelineCache, &size, nullptr);
+    if (err != VK_SUCCESS || size == 0)
+        return;
+    std::vector<uint8_t> blob(size);
+    err = vkGetPipelineCacheData(this->data.device, this->data.pipelineCache, &size, blob.data());
+    if (err != VK_SUCCESS)
+        return;
+    blob.resize(size);
+
+    PipelineCacheFileHeader header;
+    fill_header(this->data.physicalDevice, header);
+    header.dataSize = blob.size();
+    header.dataHash = fnv1a(blob.data(), blob.size());
+    if (header.dataHash == this->pipelineCacheHash_)
+        return;
+
+    std::error_code ec;
+    const std::filesystem::path path(this->pipelineCachePath_);
+    if (path.has_parent_path())
+        std::filesystem::create_directories(path.parent_path(), ec);
+    const std::filesystem::path tmp = path.string() + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(blob.data()), (std::streamsize)blob.size());
+        if (!file) {
+            fprintf(stderr, "[vulkan] Cannot write pipeline cache %s\n", tmp.c_str());
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        fprintf(stderr, "[vulkan] Cannot replace pipeline cache %s: %s\n", path.c_str(), ec.message().c_str());
+        std::filesystem::remove(tmp, ec);
+    }
+}
+
+auto VulkanHelper::AcquireQueue() -> VulkanQueue {
+    const uint32_t i = this->nextQueue_.fetch_add(1, std::memory_order_relaxed) % (uint32_t)this->queues_.size();
+    return VulkanQueue{this->queues_[i], &this->queueMutexes_[i]};
+}
+
+auto VulkanHelper::LockQueues() -> std::vector<std::unique_lock<std::mutex>> {
+    // Always in index order, so two threads locking everything cannot deadlock.
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(this->queues_.size());
+    for (size_t i = 0; i < this->queues_.size(); i++)
+        locks.emplace_back(this->queueMutexes_[i]);
+    return locks;
+}
+
+// If you wish to load e.g. additional textures you may need to alter pools sizes and maxSets.
+auto VulkanHelper::CreateDescriptorPool() -> VkDescriptorPool {
+    VkDescriptorPoolSize pool_sizes[] = {
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, IMGUI_IMPL_VULKAN_MINIMUM_IMAGE_SAMPLER_POOL_SIZE},
+    };
+    VkDescriptorPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    pool_info.maxSets = 0;
+    for (VkDescriptorPoolSize &pool_size : pool_sizes)
+        pool_info.maxSets += pool_size.descriptorCount;
+    pool_info.poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes);
+    pool_info.pPoolSizes = pool_sizes;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkResult err = vkCreateDescriptorPool(this->data.device, &pool_info, this->data.allocator, &pool);
+    check_vk_result(err);
+    return pool;
+}
+
+auto VulkanHelper::DestroyDescriptorPool(VkDescriptorPool pool) -> void {
+    vkDestroyDescriptorPool(this->data.device, pool, this->data.allocator);
+}
+
+auto VulkanHelper::TexturesPending(const ImDrawData *draw_data) -> bool {
+    if (draw_data->Textures == nullptr)
+        return false;
+    for (ImTextureData *tex : *draw_data->Textures)
+        if (tex->Status != ImTextureStatus_OK)
+            return true;
+    return false;
+}
+
+auto VulkanHelper::FindMemoryType(uint32_t type_bits, VkMemoryPropertyFlags properties) const -> uint32_t {
+    VkPhysicalDeviceMemoryProperties mem_properties;
+    vkGetPhysicalDeviceMemoryProperties(this->data.physicalDevice, &mem_properties);
+    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++)
+        if ((type_bits & (1u << i)) && (mem_properties.memoryTypes[i].propertyFlags & properties) == properties)
+            return i;
+    return UINT32_MAX;
+}
+
+auto VulkanHelper::Cleanup() -> void {
 #ifdef APP_USE_VULKAN_DEBUG_REPORT
     // Remove the debug report callback
     auto f_vkDestroyDebugReportCallbackEXT =
@@ -185,8 +462,29 @@ auto VulkanHelper::Cleanup() -> void {
     f_vkDestroyDebugReportCallbackEXT(g_Instance, g_DebugReport, g_Allocator);
 #endif // APP_USE_VULKAN_DEBUG_REPORT
 
-    vkDestroyDevice(this->data.device, this->data.allocator);
-    vkDestroyInstance(this->data.instance, this->data.allocator);
+    // Also runs on a helper whose Setup() failed partway, so only what was created is destroyed.
+    if (this->data.device) {
+        this->SavePipelineCache();
+        if (this->data.pipelineCache)
+            vkDestroyPipelineCache(this->data.device, this->data.pipelineCache, this->data.allocator);
+        vkDestroyDevice(this->data.device, this->data.allocator);
+    }
+    if (this->data.instance)
+        vkDestroyInstance(this->data.instance, this->data.allocator);
+
+    if (this->hostAllocator_) {
+        // Everything created with data.allocator is gone by now; what is left was leaked by us or the driver.
+        const VulkanHostAllocStats stats = this->hostAllocator_->stats();
+        if (stats.live_count > 0)
+            fprintf(stderr, "[vulkan] %llu host allocation(s), %llu bytes, still live after vkDestroyInstance\n",
+                    (unsigned long long)stats.live_count, (unsigned long long)stats.live_bytes);
+        this->hostAllocator_.reset();
+    }
 
     this->data = VulkanData{};
+    this->queues_.clear();
+    this->queueMutexes_.reset();
+    this->instanceExtensions_.clear();
+    this->pipelineCachePath_.clear();
+    this->pipelineCacheHash_ = 0;
 }
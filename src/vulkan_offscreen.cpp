@@ -0,0 +1,285 @@
+#include "vulkan_offscreen.h"
+
+#include <imgui.h>
+#include <imgui_impl_vulkan.h>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#include "gpu_frame_timer.h"
+#include "vulkan_capture.h"
+#include "vulkan_helper.h"
+
+auto VulkanOffscreen::Create(VulkanHelper *vk, VulkanQueue queue, uint32_t width, uint32_t height,
+                             uint32_t frames_in_flight) -> void {
+    this->vk_ = vk;
+    this->queue_ = queue;
+    this->width = width;
+    this->height = height;
+    const VkDevice device = vk->data.device;
+    const VkAllocationCallbacks *allocator = vk->data.allocator;
+    VkResult err;
+
+    // Color attachment
+    {
+        VkImageCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        info.imageType = VK_IMAGE_TYPE_2D;
+        info.format = this->format;
+        info.extent = {width, height, 1};
+        info.mipLevels = 1;
+        info.arrayLayers = 1;
+        info.samples = VK_SAMPLE_COUNT_1_BIT;
+        info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        err = vkCreateImage(device, &info, allocator, &this->image);
+        VulkanHelper::check_vk_result(err);
+
+        VkMemoryRequirements req;
+        vkGetImageMemoryRequirements(device, this->image, &req);
+        VkMemoryAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = req.size;
+        alloc_info.memoryTypeIndex = vk->FindMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (alloc_info.memoryTypeIndex == UINT32_MAX)
+            alloc_info.memoryTypeIndex = vk->FindMemoryType(req.memoryTypeBits, 0);
+        err = vkAllocateMemory(device, &alloc_info, allocator, &this->imageMemory_);
+        VulkanHelper::check_vk_result(err);
+        err = vkBindImageMemory(device, this->image, this->imageMemory_, 0);
+        VulkanHelper::check_vk_result(err);
+
+        VkImageViewCreateInfo view_info = {};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = this->image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = this->format;
+        view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        view_info.subresourceRange.levelCount = 1;
+        view_info.subresourceRange.layerCount = 1;
+        err = vkCreateImageView(device, &view_info, allocator, &this->imageView_);
+        VulkanHelper::check_vk_result(err);
+    }
+
+    // Render pass: clear, draw, leave the image ready to be copied out
+    {
+        VkAttachmentDescription attachment = {};
+        attachment.format = this->format;
+        attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        VkAttachmentReference color_attachment = {};
+        color_attachment.attachment = 0;
+        color_attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &color_attachment;
+        VkSubpassDependency dependencies[2] = {};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;  // the previous frame in flight
+        dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        VkRenderPassCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        info.attachmentCount = 1;
+        info.pAttachments = &attachment;
+        info.subpassCount = 1;
+        info.pSubpasses = &subpass;
+        info.dependencyCount = 2;
+        info.pDependencies = dependencies;
+        err = vkCreateRenderPass(device, &info, allocator, &this->renderPass);
+        VulkanHelper::check_vk_result(err);
+    }
+
+    {
+        VkFramebufferCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        info.renderPass = this->renderPass;
+        info.attachmentCount = 1;
+        info.pAttachments = &this->imageView_;
+        info.width = width;
+        info.height = height;
+        info.layers = 1;
+        err = vkCreateFramebuffer(device, &info, allocator, &this->framebuffer_);
+        VulkanHelper::check_vk_result(err);
+    }
+
+    this->frames_.Create(vk, frames_in_flight);
+
+    // Persistently mapped readback buffer
+    {
+        VkBufferCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.size = static_cast<VkDeviceSize>(width) * height * 4;
+        info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        err = vkCreateBuffer(device, &info, allocator, &this->readbackBuffer_);
+        VulkanHelper::check_vk_result(err);
+
+        VkMemoryRequirements req;
+        vkGetBufferMemoryRequirements(device, this->readbackBuffer_, &req);
+        VkMemoryAllocateInfo alloc_info = {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = req.size;
+        alloc_info.memoryTypeIndex = vk->FindMemoryType(
+            req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        this->readbackCoherent_ = alloc_info.memoryTypeIndex != UINT32_MAX;
+        if (!this->readbackCoherent_)
+            alloc_info.memoryTypeIndex = vk->FindMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        if (alloc_info.memoryTypeIndex == UINT32_MAX)
+            throw std::runtime_error("Vulkan: no host-visible memory type for readback");
+        err = vkAllocateMemory(device, &alloc_info, allocator, &this->readbackMemory_);
+        VulkanHelper::check_vk_result(err);
+        err = vkBindBufferMemory(device, this->readbackBuffer_, this->readbackMemory_, 0);
+        VulkanHelper::check_vk_result(err);
+        err = vkMapMemory(device, this->readbackMemory_, 0, VK_WHOLE_SIZE, 0, &this->readbackMapped_);
+        VulkanHelper::check_vk_result(err);
+    }
+}
+
+auto VulkanOffscreen::Destroy() -> void {
+    if (!this->vk_)
+        return;
+    const VkDevice device = this->vk_->data.device;
+    const VkAllocationCallbacks *allocator = this->vk_->data.allocator;
+
+    if (this->readbackMapped_)
+        vkUnmapMemory(device, this->readbackMemory_);
+    vkDestroyBuffer(device, this->readbackBuffer_, allocator);
+    vkFreeMemory(device, this->readbackMemory_, allocator);
+    this->frames_.Destroy();
+    vkDestroyFramebuffer(device, this->framebuffer_, allocator);
+    vkDestroyRenderPass(device, this->renderPass, allocator);
+    vkDestroyImageView(device, this->imageView_, allocator);
+    vkDestroyImage(device, this->image, allocator);
+    vkFreeMemory(device, this->imageMemory_, allocator);
+
+    *this = VulkanOffscreen{};
+}
+
+auto VulkanOffscreen::SetFramesInFlight(uint32_t frames) -> void {
+    this->frames_.WaitIdle();
+    this->frames_.Destroy();
+    this->frames_.Create(this->vk_, frames);
+}
+
+auto VulkanOffscreen::Wait() -> void { this->frames_.WaitIdle(); }
+
+auto VulkanOffscreen::Render(ImDrawData *draw_data, const VkClearValue &clear, bool readback,
+                             VulkanFrameCapture *capture, GpuFrameTimer *timer, uint64_t timer_tag) -> void {
+    const VkDevice device = this->vk_->data.device;
+    VkResult err;
+
+    VulkanFrameSlot &frame = this->frames_.Next();
+    const VkCommandBuffer cmd = frame.commandBuffer;
+    err = vkResetFences(device, 1, &frame.fence);
+    VulkanHelper::check_vk_result(err);
+    if (timer)
+        timer->collect(this->frames_.Index());
+    {
+        err = vkResetCommandPool(device, frame.commandPool, 0);
+        VulkanHelper::check_vk_result(err);
+        VkCommandBufferBeginInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        err = vkBeginCommandBuffer(cmd, &info);
+        VulkanHelper::check_vk_result(err);
+        if (timer)
+            timer->begin(cmd, this->frames_.Index(), timer_tag);
+    }
+    {
+        VkRenderPassBeginInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        info.renderPass = this->renderPass;
+        info.framebuffer = this->framebuffer_;
+        info.renderArea.extent.width = this->width;
+        info.renderArea.extent.height = this->height;
+        info.clearValueCount = 1;
+        info.pClearValues = &clear;
+        vkCmdBeginRenderPass(cmd, &info, VK_SUBPASS_CONTENTS_INLINE);
+    }
+
+    {
+        // Texture uploads submit on the queue from inside the backend
+        std::unique_lock queue_lock(*this->queue_.mutex, std::defer_lock);
+        if (VulkanHelper::TexturesPending(draw_data))
+            queue_lock.lock();
+        ImGui_ImplVulkan_RenderDrawData(draw_data, cmd);
+    }
+
+    vkCmdEndRenderPass(cmd);
+    if (timer)
+        timer->end(cmd, this->frames_.Index());
+
+    if (readback) {
+        VkBufferImageCopy region = {};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {this->width, this->height, 1};
+        vkCmdCopyImageToBuffer(cmd, this->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, this->readbackBuffer_, 1,
+                               &region);
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = this->readbackBuffer_;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1,
+                             &barrier, 0, nullptr);
+    }
+    if (capture)
+        capture->record(cmd, this->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, this->format, this->width,
+                        this->height);
+
+    {
+        VkSubmitInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        info.commandBufferCount = 1;
+        info.pCommandBuffers = &cmd;
+
+        err = vkEndCommandBuffer(cmd);
+        VulkanHelper::check_vk_result(err);
+        std::scoped_lock queue_lock(*this->queue_.mutex);
+        err = vkQueueSubmit(this->queue_.queue, 1, &info, frame.fence);
+        VulkanHelper::check_vk_result(err);
+        if (capture)
+            capture->submitted(this->queue_.queue);
+    }
+    this->readbackPending_ = readback;
+}
+
+auto VulkanOffscreen::Readback(std::vector<uint8_t> &rgba) -> bool {
+    this->Wait();
+    if (!this->readbackPending_)
+        return false;
+
+    if (!this->readbackCoherent_) {
+        VkMappedMemoryRange range = {};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = this->readbackMemory_;
+        range.size = VK_WHOLE_SIZE;
+        VkResult err = vkInvalidateMappedMemoryRanges(this->vk_->data.device, 1, &range);
+        VulkanHelper::check_vk_result(err);
+    }
+
+    rgba.resize(static_cast<size_t>(this->width) * this->height * 4);
+    std::memcpy(rgba.data(), this->readbackMapped_, rgba.size());
+    return true;
+}